@@ -0,0 +1,52 @@
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/pool_allocator.h"
+
+namespace
+{
+    template < typename Alloc >
+    using Table = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::chained_storage,
+                              ac::prime_size, ac::recompute_hash, Alloc>;
+
+    using Entry = ac::HashEntry<int, int>;
+
+    /// Fills a table, then erases and reinserts every key several times, as a long-running cache would.
+    template < typename Alloc >
+    void run_churn( const std::string & label_, size_t n_ )
+    {
+        const int reps = 5, rounds = 4;
+        auto keys = bench::shuffled( bench::sequential_keys( n_ ) );
+
+        double took = bench::best_of( reps, [&]{
+            Table<Alloc> table;
+            for( int k : keys )
+                table.insert( k, k );
+            for( int r = 0 ; r < rounds ; r++ )
+            {
+                for( size_t i = 0 ; i < n_ ; i += 2 )
+                    table.erase( keys[i] );
+                for( size_t i = 0 ; i < n_ ; i += 2 )
+                    table.insert( keys[i], r );
+            }
+            bench::keep( table.size() );
+        } );
+        bench::report( "allocator", label_, n_ + rounds * n_, took );
+    }
+
+    void run()
+    {
+        for( size_t n : { 100000u, 1000000u } )
+        {
+            std::string size = " n=" + std::to_string( n );
+            run_churn< std::allocator<Entry> >( "std::allocator churn" + size, n );
+            run_churn< ac::pool_allocator<Entry> >( "pool_allocator churn" + size, n );
+            run_churn< std::pmr::polymorphic_allocator<Entry> >( "pmr default resource churn" + size, n );
+        }
+    }
+
+    bench::Registrar registrar( "allocator", run );
+}
@@ -0,0 +1,61 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/account.h"
+
+namespace
+{
+    /// Resolves every key of a large account table in requests of request_ keys, with one retrieve() per key, then with retrieve_many().
+    template < typename Storage >
+    void run_case( const std::string & label_, const std::vector<Account::AcctKey> & keys_, size_t request_ )
+    {
+        using Table = ac::HashTbl<Account::AcctKey, int, KeyHash, KeyEqual, Storage>;
+        const int reps = 5;
+        auto lookups = bench::shuffled( keys_ );
+
+        Table table( keys_.size() );
+        for( const auto & k : keys_ )
+            table.insert( k, std::get<3>( k ) );
+
+        std::vector<int> data( request_ );
+
+        double single = bench::best_of( reps, [&]{
+            long sum = 0;
+            for( size_t base = 0 ; base + request_ <= lookups.size() ; base += request_ )
+                for( size_t i = 0 ; i < request_ ; i++ )
+                    sum += table.retrieve( lookups[ base + i ], data[i] ) ? data[i] : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "batch_lookup", label_ + " retrieve loop", lookups.size(), single );
+
+        double batched = bench::best_of( reps, [&]{
+            long sum = 0;
+            for( size_t base = 0 ; base + request_ <= lookups.size() ; base += request_ )
+            {
+                table.retrieve_many( &lookups[ base ], request_, data.data() );
+                for( size_t i = 0 ; i < request_ ; i++ )
+                    sum += data[i];
+            }
+            bench::keep( sum );
+        } );
+        bench::report( "batch_lookup", label_ + " retrieve_many", lookups.size(), batched );
+    }
+
+    void run()
+    {
+        const size_t request = 1000;
+
+        for( size_t n : { 10000u, 1000000u } )
+        {
+            auto keys = bench::account_keys( n );
+            std::string size = " n=" + std::to_string( n );
+            run_case<ac::chained_storage>( "chained" + size, keys, request );
+            run_case<ac::open_addressing>( "open_addressing" + size, keys, request );
+            run_case<ac::swiss_table>( "swiss_table" + size, keys, request );
+        }
+    }
+
+    bench::Registrar registrar( "batch_lookup", run );
+}
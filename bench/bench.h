@@ -0,0 +1,204 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "../include/account.h"
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/*! \namespace bench
+    \brief Minimal harness shared by the hash_bench benchmark groups.
+
+*/
+namespace bench
+{
+    /// One benchmark group, selected by name on the command line.
+    struct Case
+    {
+        std::string name;
+        std::function<void()> run;
+    };
+
+    /// Every group registered by the bench/*.cpp files.
+    inline std::vector<Case>& registry()
+    {
+        static std::vector<Case> cases;
+        return cases;
+    }
+
+    /// Adds a group to the registry during static initialization.
+    struct Registrar
+    {
+        Registrar( const std::string & name_, std::function<void()> run_ )
+        { registry().push_back( { name_, run_ } ); }
+    };
+
+    /// Keeps the compiler from optimizing away the computation that produced v_.
+    template < typename T >
+    inline void keep( const T & v_ )
+    {
+#if defined(__GNUC__)
+        asm volatile( "" : : "g"( &v_ ) : "memory" );
+#else
+        static volatile const void * sink;
+        sink = &v_;
+#endif
+    }
+
+    /// Runs fn_ reps_ times and returns the fastest run, in nanoseconds.
+    template < typename Fn >
+    double best_of( int reps_, Fn && fn_ )
+    {
+        double best = 0;
+        for( int i = 0 ; i < reps_ ; i++ )
+        {
+            auto start = std::chrono::steady_clock::now();
+            fn_();
+            std::chrono::duration<double, std::nano> took = std::chrono::steady_clock::now() - start;
+            if( i == 0 or took.count() < best )
+                best = took.count();
+        }
+        return best;
+    }
+
+    /// Command line settings shared by every group.
+    struct Options
+    {
+        std::string format = "text"; //!< text for people, csv or json (one object per line) for scripts.
+        size_t max_size = 1000000; //!< Largest size swept by the groups that sweep sizes().
+    };
+
+    inline Options& options()
+    {
+        static Options opts;
+        return opts;
+    }
+
+    /// Sizes from from_ up to options().max_size, by powers of ten.
+    inline std::vector<size_t> sizes( size_t from_ = 1000 )
+    {
+        std::vector<size_t> all;
+        for( size_t n = from_ ; n <= options().max_size ; n *= 10 )
+            all.push_back( n );
+        return all;
+    }
+
+    /// Peak resident set size of the process, in KiB, since it started or since the last reset_peak_rss(). 0 where the platform doesn't tell.
+    inline size_t peak_rss_kb( void )
+    {
+#if defined(__linux__)
+        std::ifstream status( "/proc/self/status" );
+        std::string line;
+        while( std::getline( status, line ) )
+            if( line.compare( 0, 6, "VmHWM:" ) == 0 )
+                return std::stoul( line.substr( 6 ) );
+#endif
+        return 0;
+    }
+
+    /// Gives freed heap memory back to the OS, then makes the current resident set size the new peak, so the next peak_rss_kb() only sees what was allocated since. Linux only, a no-op elsewhere.
+    inline void reset_peak_rss( void )
+    {
+#if defined(__GLIBC__)
+        malloc_trim( 0 );
+#endif
+#if defined(__linux__)
+        std::ofstream( "/proc/self/clear_refs" ) << "5";
+#endif
+    }
+
+    /// Writes s_ as a quoted CSV or JSON string.
+    inline std::string quoted( const std::string & s_, char escape_ )
+    {
+        std::string q = "\"";
+        for( char c : s_ )
+        {
+            if( c == '"' or c == escape_ )
+                q += escape_;
+            q += c;
+        }
+        return q + '"';
+    }
+
+    /// Prints one result line: ns per operation, millions of operations per second and the peak RSS, as text, CSV or JSON depending on options().format.
+    inline void report( const std::string & group_, const std::string & name_, size_t ops_, double ns_ )
+    {
+        size_t rss = peak_rss_kb();
+
+        if( options().format == "csv" )
+            std::cout << group_ << ',' << quoted( name_, '"' ) << ',' << ops_ << ','
+                      << std::fixed << std::setprecision( 3 ) << ns_ / ops_ << ',' << ops_ * 1e3 / ns_ << ',' << rss << std::endl;
+        else if( options().format == "json" )
+            std::cout << "{\"group\": " << quoted( group_, '\\' ) << ", \"name\": " << quoted( name_, '\\' ) << ", \"ops\": " << ops_
+                      << std::fixed << std::setprecision( 3 ) << ", \"ns_per_op\": " << ns_ / ops_ << ", \"mops\": " << ops_ * 1e3 / ns_
+                      << ", \"peak_rss_kb\": " << rss << "}" << std::endl;
+        else
+            std::cout << std::left << std::setw( 14 ) << group_
+                      << std::setw( 56 ) << name_
+                      << std::right << std::setw( 10 ) << ops_
+                      << std::fixed << std::setprecision( 2 )
+                      << std::setw( 10 ) << ns_ / ops_ << " ns/op"
+                      << std::setw( 10 ) << ops_ * 1e3 / ns_ << " Mops/s"
+                      << std::setw( 8 ) << rss / 1024 << " MB peak" << std::endl;
+    }
+
+    /// Prints a line meant for people only, skipped in the machine readable formats.
+    inline void note( const std::string & line_ )
+    {
+        if( options().format == "text" )
+            std::cout << line_ << std::endl;
+    }
+
+    /// n_ sequential integers starting at zero.
+    inline std::vector<int> sequential_keys( size_t n_ )
+    {
+        std::vector<int> keys( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+            keys[i] = static_cast<int>( i );
+        return keys;
+    }
+
+    /// n_ integers that are multiples of stride_, the worst case for a masked identity hash.
+    inline std::vector<int> strided_keys( size_t n_, int stride_ )
+    {
+        std::vector<int> keys( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+            keys[i] = static_cast<int>( i ) * stride_;
+        return keys;
+    }
+
+    /// A copy of keys_ in a random but reproducible order, so lookups don't walk memory sequentially.
+    template < typename Key >
+    std::vector<Key> shuffled( std::vector<Key> keys_, unsigned seed_ = 2019 )
+    {
+        std::mt19937 gen( seed_ );
+        std::shuffle( keys_.begin(), keys_.end(), gen );
+        return keys_;
+    }
+
+    /// n_ distinct account keys.
+    inline std::vector<Account::AcctKey> account_keys( size_t n_ )
+    {
+        std::vector<Account::AcctKey> keys;
+        keys.reserve( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+        {
+            int id = static_cast<int>( i );
+            keys.push_back( std::make_tuple( "Holder " + std::to_string( id ), 1 + id % 300, 1000 + id % 5000, id ) );
+        }
+        return keys;
+    }
+} // bench Namespace
+#endif
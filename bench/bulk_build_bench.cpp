@@ -0,0 +1,74 @@
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+
+namespace
+{
+    /// Builds a table from pairs_ one insert() at a time, then with the range constructor, which sizes it once.
+    template < typename Storage >
+    void run_case( const std::string & label_, const std::vector< std::pair<int, int> > & pairs_ )
+    {
+        using Table = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage>;
+        const int reps = 5;
+
+        double one_by_one = bench::best_of( reps, [&]{
+            Table table;
+            for( const auto & p : pairs_ )
+                table.insert( p.first, p.second );
+            bench::keep( table.size() );
+        } );
+        bench::report( "bulk_build", label_ + " insert loop", pairs_.size(), one_by_one );
+
+        double ranged = bench::best_of( reps, [&]{
+            Table table( pairs_.begin(), pairs_.end() );
+            bench::keep( table.size() );
+        } );
+        bench::report( "bulk_build", label_ + " range constructor", pairs_.size(), ranged );
+    }
+
+    /// Serial against parallel builds and full rehashes of the chained table, with threads_ threads.
+    void run_parallel_case( const std::string & label_, const std::vector< std::pair<int, int> > & pairs_, size_t threads_ )
+    {
+        using Table = ac::HashTbl<int, int>;
+        const int reps = 5;
+        std::string count = " threads=" + std::to_string( threads_ );
+
+        double built = bench::best_of( reps, [&]{
+            Table table( pairs_.begin(), pairs_.end(), threads_ );
+            bench::keep( table.size() );
+        } );
+        bench::report( "bulk_build", label_ + " parallel build" + count, pairs_.size(), built );
+
+        Table table( pairs_.begin(), pairs_.end() );
+        table.parallel_rehash( threads_ );
+        size_t size = table.bucket_count();
+        double rehashed = bench::best_of( reps, [&]{
+            size = size == table.bucket_count() ? 4 * size : size / 4;
+            table.rehash( size );
+        } );
+        bench::report( "bulk_build", label_ + " rehash" + count, pairs_.size(), rehashed );
+    }
+
+    void run()
+    {
+        for( size_t n : { 100000u, 1000000u } )
+        {
+            // Keys scattered over the whole int range, as account ids are.
+            std::vector< std::pair<int, int> > pairs;
+            for( int k : bench::sequential_keys( n ) )
+                pairs.emplace_back( static_cast<int>( ac::mix_hash( k ) ), k );
+
+            std::string size = " n=" + std::to_string( n );
+            run_case<ac::chained_storage>( "chained" + size, pairs );
+            run_case<ac::open_addressing>( "open_addressing" + size, pairs );
+            run_case<ac::swiss_table>( "swiss_table" + size, pairs );
+            for( size_t threads : { 1u, 2u, 4u } )
+                run_parallel_case( "chained" + size, pairs, threads );
+        }
+    }
+
+    bench::Registrar registrar( "bulk_build", run );
+}
@@ -0,0 +1,231 @@
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/account.h"
+
+namespace
+{
+    /// Uniform calls on a HashTbl, specialized below for std::unordered_map.
+    template < typename Map >
+    struct Adapter
+    {
+        template < typename K >
+        static void insert( Map & m_, const K & k_, int d_ )
+        { m_.insert( k_, d_ ); }
+
+        template < typename K >
+        static bool find( const Map & m_, const K & k_, int & d_ )
+        { return m_.retrieve( k_, d_ ); }
+
+        template < typename K >
+        static bool erase( Map & m_, const K & k_ )
+        { return m_.erase( k_ ); }
+
+        static long sum( const Map & m_ )
+        {
+            long total = 0;
+            for( const auto & e : m_ )
+                total += e.m_data;
+            return total;
+        }
+    };
+
+    template < typename K, typename H, typename E, typename A >
+    struct Adapter< std::unordered_map< K, int, H, E, A > >
+    {
+        using Map = std::unordered_map< K, int, H, E, A >;
+
+        static void insert( Map & m_, const K & k_, int d_ )
+        { m_.insert_or_assign( k_, d_ ); }
+
+        static bool find( const Map & m_, const K & k_, int & d_ )
+        {
+            auto it = m_.find( k_ );
+            if( it == m_.end() )
+                return false;
+            d_ = it->second;
+            return true;
+        }
+
+        static bool erase( Map & m_, const K & k_ )
+        { return m_.erase( k_ ) == 1; }
+
+        static long sum( const Map & m_ )
+        {
+            long total = 0;
+            for( const auto & e : m_ )
+                total += e.second;
+            return total;
+        }
+    };
+
+    /// n_ distinct keys of each type, starting from the from_-th one, so [0, n) and [n, 2n) never share a key.
+    template < typename K >
+    std::vector<K> make_keys( size_t from_, size_t n_ );
+
+    /// Ints spread over the whole range by an odd multiplier, which keeps them distinct.
+    template < >
+    std::vector<int> make_keys<int>( size_t from_, size_t n_ )
+    {
+        std::vector<int> keys( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+            keys[i] = static_cast<int>( static_cast<uint32_t>( from_ + i ) * 2654435761u );
+        return keys;
+    }
+
+    template < >
+    std::vector<std::string> make_keys<std::string>( size_t from_, size_t n_ )
+    {
+        std::vector<std::string> keys( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+            keys[i] = "user:" + std::to_string( from_ + i );
+        return keys;
+    }
+
+    template < >
+    std::vector<Account::AcctKey> make_keys<Account::AcctKey>( size_t from_, size_t n_ )
+    {
+        auto all = bench::account_keys( from_ + n_ );
+        return std::vector<Account::AcctKey>( all.begin() + from_, all.end() );
+    }
+
+    /// Best, over reps_, of the total time of rounds_ calls to op_( map ), each on a map freshly made by make_(). Only op_ is timed.
+    template < typename Make, typename Op >
+    double timed( int reps_, size_t rounds_, Make && make_, Op && op_ )
+    {
+        double best = 0;
+        for( int r = 0 ; r < reps_ ; r++ )
+        {
+            double total = 0;
+            for( size_t i = 0 ; i < rounds_ ; i++ )
+            {
+                auto map = make_();
+                auto start = std::chrono::steady_clock::now();
+                op_( map );
+                total += std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+                bench::keep( map );
+            }
+            if( r == 0 or total < best )
+                best = total;
+        }
+        return best;
+    }
+
+    /// Every workload on one map type, for n_ keys. Small sizes are repeated so each measurement covers at least a million operations.
+    template < typename Map, typename K >
+    void run_map( const std::string & label_, const std::vector<K> & keys_, const std::vector<K> & misses_ )
+    {
+        using Ops = Adapter< Map >;
+        const size_t n = keys_.size();
+        const size_t rounds = n >= 1000000 ? 1 : 1000000 / n;
+        const int reps = n >= 10000000 ? 1 : 3;
+        const std::string size = " n=" + std::to_string( n );
+
+        bench::reset_peak_rss();
+        auto empty = []{ return Map(); };
+        auto built = [&]{
+            Map m;
+            for( size_t i = 0 ; i < n ; i++ )
+                Ops::insert( m, keys_[i], static_cast<int>( i ) );
+            return m;
+        };
+
+        // Growing from the default size goes through every rehash on the way.
+        double took = timed( reps, rounds, empty, [&]( Map & m_ ){
+            for( size_t i = 0 ; i < n ; i++ )
+                Ops::insert( m_, keys_[i], static_cast<int>( i ) );
+        } );
+        bench::report( "compare", label_ + " insert, growing" + size, rounds * n, took );
+
+        took = timed( reps, rounds, [&]{ Map m; m.reserve( n ); return m; }, [&]( Map & m_ ){
+            for( size_t i = 0 ; i < n ; i++ )
+                Ops::insert( m_, keys_[i], static_cast<int>( i ) );
+        } );
+        bench::report( "compare", label_ + " insert, reserved" + size, rounds * n, took );
+
+        Map table = built();
+        auto lookups = bench::shuffled( keys_ );
+        auto same = [&table]{ return std::ref( table ); };
+
+        took = timed( reps, rounds, same, [&]( std::reference_wrapper<Map> m_ ){
+            long total = 0;
+            int d = 0;
+            for( const K & k : lookups )
+                total += Ops::find( m_, k, d ) ? d : 0;
+            bench::keep( total );
+        } );
+        bench::report( "compare", label_ + " lookup, hit" + size, rounds * n, took );
+
+        took = timed( reps, rounds, same, [&]( std::reference_wrapper<Map> m_ ){
+            long found = 0;
+            int d = 0;
+            for( const K & k : misses_ )
+                found += Ops::find( m_, k, d );
+            bench::keep( found );
+        } );
+        bench::report( "compare", label_ + " lookup, miss" + size, rounds * n, took );
+
+        took = timed( reps, rounds, same, [&]( std::reference_wrapper<Map> m_ ){ bench::keep( Ops::sum( m_ ) ); } );
+        bench::report( "compare", label_ + " iterate" + size, rounds * n, took );
+
+        // 80% lookups, 10% erases and 10% reinsertions, on a table that stays about the same size.
+        took = timed( reps, rounds, same, [&]( std::reference_wrapper<Map> m_ ){
+            long total = 0;
+            int d = 0;
+            for( size_t i = 0 ; i < n ; i++ )
+            {
+                const K & k = lookups[i];
+                switch( i % 10 )
+                {
+                    case 8: Ops::erase( m_, k ); break;
+                    case 9: Ops::insert( m_, lookups[ i - 1 ], 1 ); break;
+                    default: total += Ops::find( m_, k, d ) ? d : 0;
+                }
+            }
+            bench::keep( total );
+        } );
+        bench::report( "compare", label_ + " mixed 80/10/10" + size, rounds * n, took );
+
+        // Counting occurrences, ++map[ key ], with each key seen four times.
+        took = timed( reps, rounds, empty, [&]( Map & m_ ){
+            for( size_t i = 0 ; i < n ; i++ )
+                ++m_[ lookups[ i / 4 ] ];
+        } );
+        bench::report( "compare", label_ + " operator[] count" + size, rounds * n, took );
+
+        took = timed( reps, rounds, built, [&]( Map & m_ ){
+            for( const K & k : lookups )
+                Ops::erase( m_, k );
+        } );
+        bench::report( "compare", label_ + " erase" + size, rounds * n, took );
+    }
+
+    template < typename K, typename Hash, typename Equal = std::equal_to<K> >
+    void run_key( const std::string & key_ )
+    {
+        for( size_t n : bench::sizes() )
+        {
+            auto keys = make_keys<K>( 0, n );
+            auto misses = make_keys<K>( n, n );
+
+            run_map< ac::HashTbl<K, int, Hash, Equal, ac::chained_storage> >( key_ + " HashTbl chained", keys, misses );
+            run_map< ac::HashTbl<K, int, Hash, Equal, ac::open_addressing> >( key_ + " HashTbl open_addressing", keys, misses );
+            run_map< ac::HashTbl<K, int, Hash, Equal, ac::swiss_table> >( key_ + " HashTbl swiss_table", keys, misses );
+            run_map< std::unordered_map<K, int, Hash, Equal> >( key_ + " std::unordered_map", keys, misses );
+        }
+    }
+
+    void run()
+    {
+        run_key< int, std::hash<int> >( "int" );
+        run_key< std::string, std::hash<std::string> >( "string" );
+        run_key< Account::AcctKey, KeyHash >( "AcctKey" );
+    }
+
+    bench::Registrar registrar( "compare", run );
+}
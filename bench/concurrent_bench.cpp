@@ -0,0 +1,116 @@
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/concurrent_hashtbl.h"
+#include "../include/read_mostly_hashtbl.h"
+
+namespace
+{
+    /// One HashTbl behind one mutex, the way callers made it thread safe before ConcurrentHashTbl.
+    struct GlobalLockTable
+    {
+        bool retrieve( int k_, int & d_ )
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            return table.retrieve( k_, d_ );
+        }
+
+        bool insert( int k_, int d_ )
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            return table.insert( k_, d_ );
+        }
+
+        int fetch_add( int k_, int delta_ )
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            int & d = table[ k_ ];
+            int previous = d;
+            d += delta_;
+            return previous;
+        }
+
+        std::mutex mutex;
+        ac::HashTbl<int, int> table;
+    };
+
+    /// threads_ threads share one table, each doing ops_ operations, one insert every write_every_ of them and lookups otherwise.
+    template < typename Table >
+    void run_case( const std::string & label_, size_t threads_, size_t ops_, size_t write_every_ )
+    {
+        const int reps = 3;
+        static const size_t keys = 100000;
+
+        double took = bench::best_of( reps, [&]{
+            Table table;
+            for( size_t k = 0 ; k < keys ; k++ )
+                table.insert( static_cast<int>( k ), 1 );
+
+            std::vector<std::thread> workers;
+            for( size_t t = 0 ; t < threads_ ; t++ )
+                workers.emplace_back( [&table, t, ops_, write_every_]{
+                    long sum = 0;
+                    int d = 0;
+                    size_t k = t * 7919;
+                    for( size_t i = 0 ; i < ops_ ; i++ )
+                    {
+                        k = ( k + 104729 ) % keys;
+                        if( i % write_every_ == 0 )
+                            table.insert( static_cast<int>( k ), static_cast<int>( i ) );
+                        else if( table.retrieve( static_cast<int>( k ), d ) )
+                            sum += d;
+                    }
+                    bench::keep( sum );
+                } );
+            for( auto & w : workers )
+                w.join();
+        } );
+        bench::report( "concurrent", label_, threads_ * ops_, took );
+    }
+
+    /// threads_ threads each add ops_ times to counters spread over words_ keys, the metrics aggregation pattern.
+    template < typename Table >
+    void run_counters( const std::string & label_, size_t threads_, size_t ops_, size_t words_ )
+    {
+        const int reps = 3;
+
+        double took = bench::best_of( reps, [&]{
+            Table table;
+            std::vector<std::thread> workers;
+            for( size_t t = 0 ; t < threads_ ; t++ )
+                workers.emplace_back( [&table, t, ops_, words_]{
+                    size_t k = t * 7919;
+                    for( size_t i = 0 ; i < ops_ ; i++ )
+                    {
+                        k = ( k + 104729 ) % words_;
+                        table.fetch_add( static_cast<int>( k ), 1 );
+                    }
+                } );
+            for( auto & w : workers )
+                w.join();
+        } );
+        bench::report( "concurrent", label_, threads_ * ops_, took );
+    }
+
+    void run()
+    {
+        const size_t ops = 1000000;
+        for( size_t threads : { 1u, 2u, 4u, 8u } )
+        {
+            std::string count = " threads=" + std::to_string( threads );
+            run_case< GlobalLockTable >( "global mutex 10% writes" + count, threads, ops, 10 );
+            run_case< ac::ConcurrentHashTbl<int, int> >( "16 shards 10% writes" + count, threads, ops, 10 );
+            run_case< GlobalLockTable >( "global mutex 0.1% writes" + count, threads, ops, 1000 );
+            run_case< ac::ConcurrentHashTbl<int, int> >( "16 shards 0.1% writes" + count, threads, ops, 1000 );
+            run_case< ac::ReadMostlyHashTbl<int, int> >( "read mostly 0.1% writes" + count, threads, ops, 1000 );
+            run_counters< GlobalLockTable >( "global mutex counters" + count, threads, ops, 10000 );
+            run_counters< ac::ConcurrentHashTbl<int, int> >( "16 shards fetch_add counters" + count, threads, ops, 10000 );
+        }
+    }
+
+    bench::Registrar registrar( "concurrent", run );
+}
@@ -0,0 +1,85 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/account.h"
+
+namespace
+{
+    /// Fills a table of about slots_ slots up to load_, then times its hits and misses. Storages whose max_load_factor() can't reach load_ are skipped.
+    template < typename Storage >
+    void run_case( const std::string & label_, size_t slots_, float load_,
+                   const std::vector<Account::AcctKey> & keys_, const std::vector<Account::AcctKey> & missing_ )
+    {
+        using Table = ac::HashTbl<Account::AcctKey, int, KeyHash, KeyEqual, Storage>;
+        const int reps = 3;
+
+        Table table;
+        table.max_load_factor( load_ );
+        if( table.max_load_factor() < load_ )
+            return;
+        table.rehash( slots_ );
+        size_t buckets = table.bucket_count();
+        size_t n = std::min( keys_.size(), static_cast<size_t>( load_ * buckets ) );
+
+        double build = bench::best_of( reps, [&]{
+            Table t;
+            t.max_load_factor( load_ );
+            t.rehash( slots_ );
+            for( size_t i = 0 ; i < n ; i++ )
+                t.insert( keys_[i], 1 );
+            bench::keep( t.size() );
+        } );
+        bench::report( "cuckoo", label_ + " insert", n, build );
+
+        for( size_t i = 0 ; i < n ; i++ )
+            table.insert( keys_[i], 1 );
+        auto lookups = bench::shuffled( std::vector<Account::AcctKey>( keys_.begin(), keys_.begin() + n ) );
+
+        double hit = bench::best_of( reps, [&]{
+            int sum = 0, d = 0;
+            for( const auto & k : lookups )
+                sum += table.retrieve( k, d ) ? d : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "cuckoo", label_ + " hit", lookups.size(), hit );
+
+        double miss = bench::best_of( reps, [&]{
+            int found = 0, d = 0;
+            for( const auto & k : missing_ )
+                found += table.retrieve( k, d );
+            bench::keep( found );
+        } );
+        bench::report( "cuckoo", label_ + " miss", missing_.size(), miss );
+
+        ac::HashStats s = table.stats();
+        char line[160];
+        std::snprintf( line, sizeof( line ), "    load factor %.3f%s, longest chain or probe %zu",
+                       table.load_factor(), table.bucket_count() != buckets ? " (grew early)" : "", s.longest );
+        bench::note( line );
+    }
+
+    void run()
+    {
+        for( size_t slots = 1 << 14 ; slots <= bench::options().max_size ; slots <<= 3 )
+        {
+            auto all = bench::account_keys( slots + slots / 4 );
+            std::vector<Account::AcctKey> keys( all.begin(), all.begin() + slots );
+            std::vector<Account::AcctKey> missing( all.begin() + slots, all.end() );
+
+            for( float load : { 0.5f, 0.75f, 0.875f, 0.95f } )
+            {
+                char tag[48];
+                std::snprintf( tag, sizeof( tag ), " load %.3f slots=%zu", load, slots );
+                run_case<ac::chained_storage>( std::string( "chained" ) + tag, slots, load, keys, missing );
+                run_case<ac::open_addressing>( std::string( "open_addressing" ) + tag, slots, load, keys, missing );
+                run_case<ac::swiss_table>( std::string( "swiss_table" ) + tag, slots, load, keys, missing );
+                run_case<ac::cuckoo_table>( std::string( "cuckoo_table" ) + tag, slots, load, keys, missing );
+            }
+        }
+    }
+
+    bench::Registrar registrar( "cuckoo", run );
+}
@@ -0,0 +1,78 @@
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+
+namespace
+{
+    /// Hashes every field of an account key, like a real composite key hash would.
+    struct FullAcctHash
+    {
+        size_t operator()( const Account::AcctKey & k_ ) const
+        {
+            size_t h = std::hash<std::string>()( std::get<0>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<1>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<2>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<3>( k_ ) );
+            return h;
+        }
+    };
+
+    /// Builds a table from keys_, then looks up every key and as many missing ones.
+    template < typename Storage, typename HashPolicy >
+    void run_case( const std::string & label_, const std::vector<Account::AcctKey> & keys_,
+                   const std::vector<Account::AcctKey> & missing_ )
+    {
+        using Table = ac::HashTbl<Account::AcctKey, int, FullAcctHash, std::equal_to<Account::AcctKey>,
+                                  Storage, ac::prime_size, HashPolicy>;
+        const int reps = 5;
+        auto lookups = bench::shuffled( keys_ );
+
+        double build = bench::best_of( reps, [&]{
+            Table table;
+            for( const auto & k : keys_ )
+                table.insert( k, 1 );
+            bench::keep( table.size() );
+        } );
+        bench::report( "hash_cache", label_ + " insert", keys_.size(), build );
+
+        Table table;
+        for( const auto & k : keys_ )
+            table.insert( k, 1 );
+
+        double hit = bench::best_of( reps, [&]{
+            int sum = 0, d = 0;
+            for( const auto & k : lookups )
+                sum += table.retrieve( k, d ) ? d : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "hash_cache", label_ + " hit", lookups.size(), hit );
+
+        double miss = bench::best_of( reps, [&]{
+            int found = 0, d = 0;
+            for( const auto & k : missing_ )
+                found += table.retrieve( k, d );
+            bench::keep( found );
+        } );
+        bench::report( "hash_cache", label_ + " miss", missing_.size(), miss );
+    }
+
+    void run()
+    {
+        const size_t n = 200000;
+        auto all = bench::account_keys( 2 * n );
+        std::vector<Account::AcctKey> keys( all.begin(), all.begin() + n );
+        std::vector<Account::AcctKey> missing( all.begin() + n, all.end() );
+
+        run_case<ac::chained_storage, ac::recompute_hash>( "chained recompute", keys, missing );
+        run_case<ac::chained_storage, ac::cache_hash>( "chained cache", keys, missing );
+        run_case<ac::open_addressing, ac::recompute_hash>( "open_addressing recompute", keys, missing );
+        run_case<ac::open_addressing, ac::cache_hash>( "open_addressing cache", keys, missing );
+        run_case<ac::swiss_table, ac::recompute_hash>( "swiss_table recompute", keys, missing );
+        run_case<ac::swiss_table, ac::cache_hash>( "swiss_table cache", keys, missing );
+    }
+
+    bench::Registrar registrar( "hash_cache", run );
+}
@@ -0,0 +1,102 @@
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/account.h"
+#include "../include/key_hash.h"
+
+namespace
+{
+    /// The account key hash account.h used to have: the account number alone.
+    struct AcctNumHash
+    {
+        size_t operator()( const Account::AcctKey & k_ ) const
+        { return static_cast<size_t>( std::get<3>( k_ ) ); }
+    };
+
+    /// The usual hand written combiner: std::hash of every field, folded with h * 31 + field.
+    struct StdCombineHash
+    {
+        size_t operator()( const Account::AcctKey & k_ ) const
+        {
+            size_t h = std::hash<std::string>()( std::get<0>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<1>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<2>( k_ ) );
+            h = h * 31 + std::hash<int>()( std::get<3>( k_ ) );
+            return h;
+        }
+    };
+
+    /// n_ account keys where every account number is shared by 300 banks, as happens once several banks are loaded in one table.
+    std::vector<Account::AcctKey> shared_number_keys( size_t n_ )
+    {
+        std::vector<Account::AcctKey> keys;
+        keys.reserve( n_ );
+        for( size_t i = 0 ; i < n_ ; i++ )
+        {
+            int id = static_cast<int>( i );
+            keys.push_back( std::make_tuple( "Holder " + std::to_string( id ), 1 + id % 300, 1000 + id % 5000, id / 300 ) );
+        }
+        return keys;
+    }
+
+    /// Cost of hashing alone, then the chain lengths the hash gives a chained table, and its lookup cost. A nonzero treeify_ indexes the chains longer than that.
+    template < typename Hash >
+    void run_hash( const std::string & label_, const std::vector<Account::AcctKey> & keys_, size_t treeify_ = 0 )
+    {
+        const int reps = 3;
+        Hash hashFunc;
+        auto lookups = bench::shuffled( keys_ );
+
+        double hashing = bench::best_of( reps, [&]{
+            size_t sum = 0;
+            for( const auto & k : keys_ )
+                sum += hashFunc( k );
+            bench::keep( sum );
+        } );
+        bench::report( "key_hash", label_ + " hash only", keys_.size(), hashing );
+
+        ac::HashTbl<Account::AcctKey, int, Hash, KeyEqual> table( keys_.size() );
+        table.treeify_buckets( treeify_ );
+        for( const auto & k : keys_ )
+            table.insert( k, 1 );
+
+        double lookup = bench::best_of( reps, [&]{
+            int sum = 0, d = 0;
+            for( const auto & k : lookups )
+                sum += table.retrieve( k, d ) ? d : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "key_hash", label_ + " lookup, chained", lookups.size(), lookup );
+
+        ac::HashStats s = table.stats();
+        char line[160];
+        std::snprintf( line, sizeof( line ), "    longest chain %zu, %.1f%% buckets empty, %zu treeified, load factor %.2f",
+                       s.longest, 100 * s.empty_ratio, s.treeified, table.load_factor() );
+        bench::note( line );
+    }
+
+    void run()
+    {
+        for( size_t n : bench::sizes( 10000 ) )
+        {
+            const std::string size = " n=" + std::to_string( n );
+            auto unique = bench::account_keys( n );
+            auto shared = shared_number_keys( n );
+
+            run_hash< AcctNumHash >( "acct number only, unique numbers" + size, unique );
+            run_hash< StdCombineHash >( "std::hash*31, unique numbers" + size, unique );
+            run_hash< KeyHash >( "KeyHash, unique numbers" + size, unique );
+
+            run_hash< AcctNumHash >( "acct number only, shared numbers" + size, shared );
+            run_hash< AcctNumHash >( "acct number only, treeify 8, shared numbers" + size, shared, 8 );
+            run_hash< StdCombineHash >( "std::hash*31, shared numbers" + size, shared );
+            run_hash< KeyHash >( "KeyHash, shared numbers" + size, shared );
+        }
+    }
+
+    bench::Registrar registrar( "key_hash", run );
+}
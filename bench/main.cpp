@@ -0,0 +1,49 @@
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "bench.h"
+
+/// Runs every registered group, or only the ones whose name contains the filter argument.
+/// Options: --format=text|csv|json selects the output, --max-size=N the largest size of the groups sweeping sizes.
+int main( int argc, char** argv )
+{
+    const char * filter = "";
+
+    for( int i = 1 ; i < argc ; i++ )
+    {
+        std::string arg = argv[i];
+        if( arg.compare( 0, 9, "--format=" ) == 0 )
+            bench::options().format = arg.substr( 9 );
+        else if( arg.compare( 0, 11, "--max-size=" ) == 0 )
+            bench::options().max_size = std::stoull( arg.substr( 11 ) );
+        else if( arg.compare( 0, 2, "--" ) == 0 )
+        {
+            std::cerr << "usage: " << argv[0] << " [--format=text|csv|json] [--max-size=N] [group filter]" << std::endl;
+            return arg == "--help" ? 0 : 1;
+        }
+        else
+            filter = argv[i];
+    }
+
+    const std::string & format = bench::options().format;
+    if( format != "text" and format != "csv" and format != "json" )
+    {
+        std::cerr << "unknown format " << format << std::endl;
+        return 1;
+    }
+
+    if( format == "csv" )
+        std::cout << "group,name,ops,ns_per_op,mops,peak_rss_kb" << std::endl;
+
+    for( const auto & c : bench::registry() )
+    {
+        if( std::strstr( c.name.c_str(), filter ) == nullptr )
+            continue;
+
+        bench::note( "=== " + c.name + " ===" );
+        c.run();
+    }
+
+    return 0;
+}
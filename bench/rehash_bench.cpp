@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+
+namespace
+{
+    /// Times every single insert into a growing table and prints the latency tail.
+    void run_latency( const std::string & label_, size_t n_, size_t step_ )
+    {
+        std::vector<double> took( n_ );
+        auto keys = bench::shuffled( bench::sequential_keys( n_ ) );
+        ac::HashTbl<int, int> table;
+        table.incremental_rehash( step_ );
+
+        auto total_start = std::chrono::steady_clock::now();
+        for( size_t i = 0 ; i < n_ ; i++ )
+        {
+            auto start = std::chrono::steady_clock::now();
+            table.insert( keys[i], 1 );
+            took[i] = std::chrono::duration<double, std::nano>( std::chrono::steady_clock::now() - start ).count();
+        }
+        std::chrono::duration<double, std::nano> total = std::chrono::steady_clock::now() - total_start;
+        bench::keep( table.size() );
+
+        std::sort( took.begin(), took.end() );
+        bench::report( "rehash", label_ + " insert", n_, total.count() );
+        std::ostringstream latency;
+        latency << std::left << std::setw( 14 ) << "" << std::setw( 56 ) << label_ + " latency"
+                << std::right << std::fixed << std::setprecision( 0 )
+                << " p50 " << took[ n_ / 2 ] << " ns"
+                << "  p99.9 " << took[ n_ - n_ / 1000 - 1 ] << " ns"
+                << "  max " << took.back() / 1000 << " us";
+        bench::note( latency.str() );
+    }
+
+    void run()
+    {
+        for( size_t n : { 100000u, 1000000u } )
+        {
+            std::string size = " n=" + std::to_string( n );
+            run_latency( "one-shot" + size, n, 0 );
+            run_latency( "incremental 1/op" + size, n, 1 );
+            run_latency( "incremental 4/op" + size, n, 4 );
+        }
+    }
+
+    bench::Registrar registrar( "rehash", run );
+}
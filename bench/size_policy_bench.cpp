@@ -0,0 +1,82 @@
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+
+namespace
+{
+    /// Times insertion into an empty table (growth included) and successful lookups of the same keys in random order.
+    template < typename Table, typename Key >
+    void run_table( const std::string & label_, const std::vector<Key> & keys_ )
+    {
+        double insert_ns = bench::best_of( 3, [&]{
+            Table t;
+            for( const auto & k : keys_ )
+                t.insert( k, 1 );
+            bench::keep( t.size() );
+        });
+
+        Table t;
+        for( const auto & k : keys_ )
+            t.insert( k, 1 );
+        auto probes = bench::shuffled( keys_ );
+
+        double lookup_ns = bench::best_of( 3, [&]{
+            size_t hits = 0;
+            int data;
+            for( const auto & k : probes )
+                hits += t.retrieve( k, data );
+            bench::keep( hits );
+        });
+
+        bench::report( "size_policy", label_ + " insert", keys_.size(), insert_ns );
+        bench::report( "size_policy", label_ + " lookup", keys_.size(), lookup_ns );
+    }
+
+    /// Every size policy on the given storage and key set.
+    template < typename Storage, typename Key, typename Hash, typename Equal >
+    void run_policies( const std::string & label_, const std::vector<Key> & keys_ )
+    {
+        run_table< ac::HashTbl<Key, int, Hash, Equal, Storage, ac::prime_size> >( label_ + " prime", keys_ );
+        run_table< ac::HashTbl<Key, int, Hash, Equal, Storage, ac::power_of_two_size> >( label_ + " pow2+mix", keys_ );
+        run_table< ac::HashTbl<Key, int, Hash, Equal, Storage, ac::fast_range_size> >( label_ + " fastrange+mix", keys_ );
+        run_table< ac::HashTbl<Key, int, Hash, Equal, Storage, ac::prime_table_size> >( label_ + " primetable", keys_ );
+    }
+
+    /// Cost of picking the next table size, as done by every constructor and rehash().
+    template < typename Policy >
+    void run_capacity( const std::string & label_ )
+    {
+        const size_t calls = 30;
+        double ns = bench::best_of( 3, [&]{
+            size_t sum = 0;
+            for( size_t n = 16 ; n < ( size_t( 1 ) << 32 ) ; n *= 2 )
+                sum += Policy::capacity( n );
+            bench::keep( sum );
+        });
+        bench::report( "size_policy", label_ + " capacity(16..2^31)", calls, ns );
+    }
+
+    void run()
+    {
+        run_capacity< ac::prime_size >( "prime" );
+        run_capacity< ac::prime_table_size >( "primetable" );
+
+        for( size_t n : { 1000u, 100000u, 1000000u } )
+        {
+            std::string size = " n=" + std::to_string( n );
+            auto seq = bench::sequential_keys( n );
+            auto strided = bench::strided_keys( n, 1024 );
+            auto accounts = bench::account_keys( n );
+
+            run_policies< ac::chained_storage, int, std::hash<int>, std::equal_to<int> >( "chained int-seq" + size, seq );
+            run_policies< ac::chained_storage, int, std::hash<int>, std::equal_to<int> >( "chained int-x1024" + size, strided );
+            run_policies< ac::chained_storage, Account::AcctKey, KeyHash, KeyEqual >( "chained acct" + size, accounts );
+            run_policies< ac::open_addressing, int, std::hash<int>, std::equal_to<int> >( "flat int-seq" + size, seq );
+            run_policies< ac::open_addressing, Account::AcctKey, KeyHash, KeyEqual >( "flat acct" + size, accounts );
+        }
+    }
+
+    bench::Registrar registrar( "size_policy", run );
+}
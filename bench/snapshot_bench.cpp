@@ -0,0 +1,84 @@
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bench.h"
+#include "../include/hashtbl.h"
+#include "../include/account.h"
+#include "../include/mapped_hashtbl.h"
+#include "../include/serializer.h"
+
+namespace
+{
+    using Balance = std::pair<float, int>;
+    using Table = ac::HashTbl<Account::AcctKey, Balance, KeyHash, KeyEqual>;
+    using Mapped = ac::MappedHashTbl<Account::AcctKey, Balance, KeyHash>;
+
+    /// Startup cost of an account table: reinserting every record, against loading a checkpoint written by save() and mapping a snapshot. Then lookups on the table and the snapshot.
+    void run_case( const std::string & label_, const std::vector<Account::AcctKey> & keys_ )
+    {
+        const int reps = 3;
+        const std::string path = "hash_bench_snapshot.bin";
+        auto lookups = bench::shuffled( keys_ );
+
+        double rebuilt = bench::best_of( reps, [&]{
+            Table table( keys_.size() );
+            for( const auto & k : keys_ )
+                table.insert( k, { 1.0f, std::get<3>( k ) } );
+            bench::keep( table.size() );
+        } );
+        bench::report( "snapshot", label_ + " startup, reinsert", keys_.size(), rebuilt );
+
+        Table table( keys_.size() );
+        for( const auto & k : keys_ )
+            table.insert( k, { 1.0f, std::get<3>( k ) } );
+        ac::save_snapshot( table, path );
+
+        std::stringstream checkpoint;
+        ac::save( table, checkpoint );
+        const std::string saved = checkpoint.str();
+        double loaded = bench::best_of( reps, [&]{
+            std::istringstream in( saved );
+            Table restored;
+            ac::load( restored, in );
+            bench::keep( restored.size() );
+        } );
+        bench::report( "snapshot", label_ + " startup, load checkpoint", keys_.size(), loaded );
+
+        double opened = bench::best_of( reps, [&]{
+            Mapped mapped( path );
+            bench::keep( mapped.size() );
+        } );
+        bench::report( "snapshot", label_ + " startup, map snapshot", keys_.size(), opened );
+
+        Mapped mapped( path );
+        Balance d;
+        double in_memory = bench::best_of( reps, [&]{
+            long sum = 0;
+            for( const auto & k : lookups )
+                sum += table.retrieve( k, d ) ? d.second : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "snapshot", label_ + " lookups, HashTbl", lookups.size(), in_memory );
+
+        double on_file = bench::best_of( reps, [&]{
+            long sum = 0;
+            for( const auto & k : lookups )
+                sum += mapped.retrieve( k, d ) ? d.second : 0;
+            bench::keep( sum );
+        } );
+        bench::report( "snapshot", label_ + " lookups, MappedHashTbl", lookups.size(), on_file );
+
+        std::remove( path.c_str() );
+    }
+
+    void run()
+    {
+        for( size_t n : { 100000u, 1000000u } )
+            run_case( "accounts n=" + std::to_string( n ), bench::account_keys( n ) );
+    }
+
+    bench::Registrar registrar( "snapshot", run );
+}
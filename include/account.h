@@ -6,6 +6,8 @@
 #include <string>
 #include <tuple>
 
+#include "key_hash.h"
+
 
 /*! \struct Account
 	\brief Structure to save the data of an account.
@@ -37,26 +39,31 @@ struct Account
 };
 
 /*! \struct KeyHash
-	\brief Account's key generator.
+	\brief Account's key hash: combines the owner's name, bank, agency and account number.
 
+	Hashing the whole key keeps accounts that share an account number, at other banks or
+	agencies, out of each other's buckets.
 */
 struct KeyHash
 {
-	int operator()( const Account::AcctKey& k_ ) const
+	size_t operator()( const Account::AcctKey& k_ ) const
 	{
-		return std::get<3>(k_);
+		return ac::composite_hash()( k_ );
 	}
 };
 
 /*! \struct KeyEqual
-	\brief Account's equality comparator.
+	\brief Account's equality comparator: two keys are equal only when all their fields are.
 
+	The integers are compared first, so most different keys are told apart without
+	comparing the names.
 */
 struct KeyEqual
 {
-	bool operator()( const Account::AcctKey& lhs, const Account::AcctKey& rhs )
+	bool operator()( const Account::AcctKey& lhs, const Account::AcctKey& rhs ) const
 	{
-		return ( std::get<3>(lhs) == std::get<3>(rhs) );
+		return std::get<3>(lhs) == std::get<3>(rhs) and std::get<2>(lhs) == std::get<2>(rhs)
+			   and std::get<1>(lhs) == std::get<1>(rhs) and std::get<0>(lhs) == std::get<0>(rhs);
 	}
 };
 
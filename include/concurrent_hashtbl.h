@@ -0,0 +1,278 @@
+#ifndef CONCURRENT_HASH_H
+#define CONCURRENT_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/*! \class ConcurrentHashTbl
+		\brief Thread safe HashTbl, split into independently locked shards.
+
+		The key space is split into a power of two number of shards, each one a plain HashTbl
+		guarded by its own std::shared_mutex. Lookups take their shard's lock shared, so they
+		run in parallel with each other; insert(), erase(), upsert() and the other read-modify-write
+		operations take it exclusively, blocking only the operations on the same shard. Every
+		shard grows, and rehashes, on its own, under its own lock, so one shard growing never
+		stalls the others.
+
+		A key's shard is picked from the high bits of its mixed hash, while the shard's table
+		uses the hash itself, so both choices stay independent. Nothing hands out references
+		to the stored data, which could outlive the lock: data is copied out by retrieve(),
+		and changed in place through the functions passed to upsert(), compute_if_present()
+		and for_each(), which run under the lock after a single lookup of the key.
+	*/
+	template < typename KeyType,
+			   typename DataType,
+			   typename KeyHash = std::hash< KeyType >,
+			   typename KeyEqual = std::equal_to< KeyType >,
+			   typename StoragePolicy = chained_storage,
+			   typename SizePolicy = prime_size,
+			   typename HashPolicy = recompute_hash,
+			   typename Allocator = std::allocator< HashEntry< KeyType, DataType, HashPolicy > >,
+			   typename StatsPolicy = no_stats >
+	class ConcurrentHashTbl
+	{
+		public:
+			using Table = HashTbl< KeyType, DataType, KeyHash, KeyEqual, StoragePolicy, SizePolicy, HashPolicy, Allocator, StatsPolicy >; //!< Alias
+			using Entry = typename Table::Entry; //!< Alias
+
+			/// Lookup methods taking a K key are only enabled for KeyType itself, or for any K when KeyHash and KeyEqual are transparent.
+			template < typename K >
+			using lookup_key = typename std::enable_if< std::is_same< K, KeyType >::value or transparent_key< KeyHash, KeyEqual, K >::value >::type;
+
+			//== Constructors
+			/// Constructor with shards_ shards, rounded up to a power of two, each starting with shard_size_ buckets.
+			explicit ConcurrentHashTbl( size_t shards_ = DEFAULT_SHARDS, size_t shard_size_ = DEFAULT_SHARD_SIZE )
+			{
+				m_shard_count = 1;
+				while( m_shard_count < shards_ )
+					m_shard_count *= 2;
+
+				m_shards.reset( new Shard[ m_shard_count ] );
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+					m_shards[i].table = Table( shard_size_ );
+			}
+
+			/// Shards hold locks, the table can be neither copied nor moved.
+			ConcurrentHashTbl( const ConcurrentHashTbl & ) = delete;
+			ConcurrentHashTbl& operator=( const ConcurrentHashTbl & ) = delete;
+
+			//=== Methods
+			/// Same as HashTbl::insert(): stores d_ for the k_ key, overwriting the data of an existing key. Returns true if the key is new.
+			bool insert ( const KeyType & k_, const DataType & d_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.insert( k_, d_ );
+			}
+
+			/// Same as the insert() above, but k_ and d_ are moved into the table instead of copied.
+			bool insert ( KeyType && k_, DataType && d_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.insert( std::move( k_ ), std::move( d_ ) );
+			}
+
+			/// Inserts d_ for the k_ key if it is new and returns true. Otherwise calls update_( data ) on the existing data, with the shard locked, and returns false.
+			template < typename Fn >
+			bool upsert ( const KeyType & k_, const DataType & d_, Fn && update_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.upsert( k_, d_, std::forward< Fn >( update_ ) );
+			}
+
+			/// Calls fn_( data ) on the data of the k_ key, with the shard locked, inserting it first with value initialized data if it is new. Returns true if the key is new.
+			template < typename Fn >
+			bool upsert ( const KeyType & k_, Fn && fn_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.upsert( k_, std::forward< Fn >( fn_ ) );
+			}
+
+			/// Adds delta_ to the data of the k_ key, which starts from value initialized data if it is new. Returns the data held before the addition.
+			DataType fetch_add ( const KeyType & k_, const DataType & delta_ )
+			{
+				DataType previous{};
+				upsert( k_, [&]( DataType & d ){ previous = d; d += delta_; } );
+				return previous;
+			}
+
+			/// Calls fn_( data ) on the data of the k_ key, with the shard locked, if it is on the table. Returns true if it was.
+			template < typename Fn >
+			bool compute_if_present ( const KeyType & k_, Fn && fn_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.compute_if_present( k_, std::forward< Fn >( fn_ ) );
+			}
+
+			/// Inserts the k_ key with fn_() as its data if it is new, calling fn_ with the shard locked, and returns true. Otherwise returns false, without calling fn_.
+			template < typename Fn >
+			bool compute_if_absent ( const KeyType & k_, Fn && fn_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.compute_if_absent( k_, std::forward< Fn >( fn_ ) );
+			}
+
+			/// Removes the k_ key from the table. Returns true if it was there.
+			bool erase ( const KeyType & k_ )
+			{ return erase< KeyType >( k_ ); }
+
+			/// Same as the erase() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool erase ( const K & k_ )
+			{
+				Shard & shard = shard_of( k_ );
+				std::unique_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.erase( k_ );
+			}
+
+			/// Copies in d_ the data of the k_ key and returns true, or returns false if the key is not on the table. Readers of a shard don't block each other.
+			bool retrieve ( const KeyType & k_, DataType & d_ ) const
+			{ return retrieve< KeyType >( k_, d_ ); }
+
+			/// Same as the retrieve() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool retrieve ( const K & k_, DataType & d_ ) const
+			{
+				const Shard & shard = shard_of( k_ );
+				std::shared_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.retrieve( k_, d_ );
+			}
+
+			/// Returns true if the k_ key is on the table.
+			bool contains ( const KeyType & k_ ) const
+			{
+				const Shard & shard = shard_of( k_ );
+				std::shared_lock< std::shared_mutex > lock( shard.mutex );
+				return shard.table.find( k_ ) != shard.table.end();
+			}
+
+			/// Removes every entry, one shard at a time.
+			void clear ( void )
+			{
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::unique_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					m_shards[i].table.clear();
+				}
+			}
+
+			/// Returns the number of entries. Shards are counted one at a time, so under concurrent updates the result is only a snapshot of each shard.
+			size_t size ( void ) const
+			{
+				size_t total = 0;
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::shared_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					total += m_shards[i].table.size();
+				}
+				return total;
+			}
+
+			/// Returns true if no shard holds an entry.
+			bool empty ( void ) const
+			{ return size() == 0; }
+
+			/// Returns the stats() of every shard merged into one: sizes, bucket counts, histograms, memory and counters add up, the longest chain or probe is the longest of any shard. Each shard is measured under its shared lock, so the result is not one atomic snapshot of the whole table.
+			HashStats stats ( void ) const
+			{
+				HashStats total;
+				double empty = 0.0;
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::shared_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					HashStats s = m_shards[i].table.stats();
+					lock.unlock();
+
+					if( total.histogram.size() < s.histogram.size() )
+						total.histogram.resize( s.histogram.size(), 0u );
+					for( size_t n = 0 ; n < s.histogram.size() ; n++ )
+						total.histogram[n] += s.histogram[n];
+
+					empty += s.empty_ratio * s.bucket_count;
+					total.size += s.size;
+					total.bucket_count += s.bucket_count;
+					total.longest = std::max( total.longest, s.longest );
+					total.bytes += s.bytes;
+					total.rehashes += s.rehashes;
+					total.rehash_ns += s.rehash_ns;
+					total.hits += s.hits;
+					total.misses += s.misses;
+				}
+				total.empty_ratio = total.bucket_count == 0 ? 0.0 : empty / total.bucket_count;
+				return total;
+			}
+
+			/// Makes room for n_ entries spread evenly over the shards.
+			void reserve ( size_t n_ )
+			{
+				size_t per_shard = ( n_ + m_shard_count - 1 ) / m_shard_count;
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::unique_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					m_shards[i].table.reserve( per_shard );
+				}
+			}
+
+			/// Returns the number of shards.
+			size_t shard_count ( void ) const
+			{ return m_shard_count; }
+
+			/// Calls fn_( key, data ) on every entry, one shard at a time, holding that shard's lock exclusively. The data may be modified, the key may not.
+			template < typename Fn >
+			void for_each ( Fn && fn_ )
+			{
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::unique_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					m_shards[i].table.for_each( fn_ );
+				}
+			}
+
+			/// Calls fn_( key, data ) on every entry, one shard at a time, holding that shard's lock shared.
+			template < typename Fn >
+			void for_each ( Fn && fn_ ) const
+			{
+				for( size_t i = 0 ; i < m_shard_count ; i++ )
+				{
+					std::shared_lock< std::shared_mutex > lock( m_shards[i].mutex );
+					std::as_const( m_shards[i].table ).for_each( fn_ );
+				}
+			}
+
+		private:
+			/// One lock and the table it guards, on their own cache lines so that shards don't slow each other down through false sharing.
+			struct alignas( 64 ) Shard
+			{
+				mutable std::shared_mutex mutex;
+				Table table;
+			};
+
+			/// Shard holding the k_ key.
+			template < typename K >
+			Shard & shard_of( const K & k_ ) const
+			{
+				KeyHash hashFunc;
+				return m_shards[ ( mix_hash( hashFunc( k_ ) ) >> 32 ) & ( m_shard_count - 1 ) ];
+			}
+
+			std::unique_ptr< Shard[] > m_shards; //!< Array of m_shard_count shards.
+			size_t m_shard_count = 0u; //!< Number of shards, a power of two.
+			static const size_t DEFAULT_SHARDS = 16;
+			static const size_t DEFAULT_SHARD_SIZE = 11;
+
+	}; // ConcurrentHashTbl Class
+} // ac Namespace
+#endif
@@ -0,0 +1,867 @@
+#ifndef CUCKOO_HASH_H
+#define CUCKOO_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <new>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/*! \namespace ac::cuckoo
+		\brief Layout and search bounds of the cuckoo_table storage.
+
+	*/
+	namespace cuckoo
+	{
+		static const size_t BUCKET_SLOTS = 4; //!< Entries per bucket.
+		static const size_t STASH_SLOTS = 8; //!< Slots set aside, past the buckets, for the entries no displacement path could place.
+		static const size_t MAX_DISPLACEMENTS = 4; //!< Most entries moved to make room for one insertion.
+		static const size_t SEARCH_NODES = 256; //!< Most buckets visited by the search for a displacement path.
+		static const size_t MIN_BUCKETS = 2; //!< Smallest table, so that a key's two buckets may differ.
+	} // cuckoo Namespace
+
+	/*! \class HashTbl< KeyType, DataType, KeyHash, KeyEqual, cuckoo_table, SizePolicy, HashPolicy >
+		\brief Bucketized cuckoo hashing version of the HashTbl.
+
+		Every key may only live in one of two buckets of BUCKET_SLOTS entries each, so a lookup
+		reads at most those two buckets, whatever the load: the first one picked by the high bits
+		of the mixed hash, the second one by xoring the first with a hash of the key's 8-bit tag
+		(its low hash bits). Tags live in an array of their own, one byte per slot, like the
+		control bytes of the swiss_table, so ruling a bucket out reads 4 bytes of a dense array
+		and most misses touch no entry at all. The tag also gives the other bucket of any stored
+		entry without hashing its key again.
+
+		An insertion whose two buckets are full searches, breadth first, for the shortest chain
+		of at most MAX_DISPLACEMENTS entries that can each move to their other bucket, ending on
+		a free slot, then moves them from the free end back. When no such chain exists the entry
+		goes to a small stash, searched only while it is not empty, and once the stash is full
+		too the table doubles. Erasing an entry gives stashed entries their bucket back when
+		they can. The capacity is always a power of two, whatever the SizePolicy, and the hash
+		is always mixed.
+
+		Keys sharing their full hash share both buckets: a KeyHash handing the same hash to
+		more than 2 * BUCKET_SLOTS + STASH_SLOTS keys can't be served, and insert() throws
+		std::length_error rather than growing a mostly empty table further.
+	*/
+	template < typename KeyType,
+			   typename DataType,
+			   typename KeyHash,
+			   typename KeyEqual,
+			   typename SizePolicy,
+			   typename HashPolicy,
+			   typename Allocator,
+			   typename StatsPolicy >
+	class HashTbl< KeyType, DataType, KeyHash, KeyEqual, cuckoo_table, SizePolicy, HashPolicy, Allocator, StatsPolicy >
+		: public table_base< HashTbl< KeyType, DataType, KeyHash, KeyEqual, cuckoo_table, SizePolicy, HashPolicy, Allocator, StatsPolicy >,
+							 KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >
+	{
+		using Base = table_base< HashTbl, KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >; //!< Shared interface, built on the primitives below.
+		friend Base;
+
+		public:
+			using Entry = typename Base::Entry; //!< Alias
+
+			template < typename K >
+			using lookup_key = typename Base::template lookup_key< K >; //!< Alias
+
+			/*! \class basic_iterator
+				\brief Forward iterator over the entries, bucket by bucket in memory order, then over the stash.
+
+				Any insertion may move entries and invalidate every iterator; erasing invalidates the erased entry's, and those of the stashed entries, which may move back to their buckets, unless a min_load_factor() makes it shrink the table.
+			*/
+			template < bool Const >
+			class basic_iterator
+			{
+				friend class HashTbl;
+				friend class basic_iterator< not Const >;
+
+				using Table = typename std::conditional< Const, const HashTbl, HashTbl >::type;
+
+				public:
+					using iterator_category = std::forward_iterator_tag;
+					using value_type = Entry;
+					using difference_type = std::ptrdiff_t;
+					using pointer = typename std::conditional< Const, const Entry *, Entry * >::type;
+					using reference = typename std::conditional< Const, const Entry &, Entry & >::type;
+
+					basic_iterator( void ) = default;
+
+					/// An iterator converts to a const_iterator.
+					template < bool C, typename = typename std::enable_if< Const and not C >::type >
+					basic_iterator( const basic_iterator< C > & other ) : m_tbl( other.m_tbl ), m_pos( other.m_pos )
+					{  }
+
+					reference operator*( void ) const
+					{ return m_tbl->entry( m_pos ); }
+
+					pointer operator->( void ) const
+					{ return &m_tbl->entry( m_pos ); }
+
+					basic_iterator& operator++( void )
+					{
+						m_pos++;
+						skip_empty();
+						return *this;
+					}
+
+					basic_iterator operator++( int )
+					{
+						basic_iterator old( *this );
+						++( *this );
+						return old;
+					}
+
+					template < bool C >
+					bool operator==( const basic_iterator< C > & other ) const
+					{ return m_pos == other.m_pos; }
+
+					template < bool C >
+					bool operator!=( const basic_iterator< C > & other ) const
+					{ return not ( *this == other ); }
+
+				private:
+					basic_iterator( Table * tbl_, size_t pos_ ) : m_tbl( tbl_ ), m_pos( pos_ )
+					{  }
+
+					/// Moves to the first full slot at or after the current one, or to the end.
+					void skip_empty( void )
+					{
+						while( m_pos < m_tbl->positions() and m_tbl->tag_at( m_pos ) == 0 )
+							m_pos++;
+					}
+
+					Table * m_tbl = nullptr;
+					size_t m_pos = 0u; //!< Slot index, stash included, positions() at the end.
+			};
+
+			using iterator = basic_iterator< false >; //!< Alias
+			using const_iterator = basic_iterator< true >; //!< Alias
+
+			//== Constructors
+			/// Constructor with room for tbl_size_ entries. The tags and slots come from alloc_.
+			HashTbl( size_t tbl_size_ = DEFAULT_SIZE, const Allocator & alloc_ = Allocator() ) : m_alloc( alloc_ )
+			{
+				allocate( buckets_for( tbl_size_ ) );
+			}
+
+			/// Constructor with the default size and an allocator.
+			explicit HashTbl( const Allocator & alloc_ ) : HashTbl( DEFAULT_SIZE, alloc_ )
+			{  }
+
+			/// Default destructor.
+			virtual ~HashTbl()
+			{
+				clear();
+				release( m_tags, m_slots, m_size );
+			}
+
+			/// Copy constructor. The allocator is obtained as for the standard containers, from select_on_container_copy_construction().
+			HashTbl( const HashTbl& other )
+				: m_alloc( std::allocator_traits< Allocator >::select_on_container_copy_construction( other.m_alloc ) ),
+				  m_max_load( other.m_max_load ), m_min_load( other.m_min_load )
+			{
+				allocate( other.m_bucket_count );
+				copy_slots( other );
+			}
+
+			/// Move constructor. Takes over the buckets and the allocator of other, which is left empty and without buckets until its next insertion.
+			HashTbl( HashTbl&& other ) noexcept : m_alloc( other.m_alloc )
+			{
+				swap_contents( other );
+			}
+
+			/// Range constructor: builds the table from [first_, last_), whose elements are entries or key/data pairs. With forward iterators the range is counted first and the table allocated once, at its final size. A key appearing twice keeps its last data, as with insert().
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			HashTbl( InputIt first_, InputIt last_, const Allocator & alloc_ = Allocator() )
+				: HashTbl( initial_size( range_length( first_, last_ ) ), alloc_ )
+			{
+				this->insert( first_, last_ );
+			}
+
+			/// std::initializer_list copy constructor.
+			HashTbl( std::initializer_list < Entry > ilist, const Allocator & alloc_ = Allocator() )
+				: HashTbl( ilist.begin(), ilist.end(), alloc_ )
+			{  }
+
+			//=== Operators
+			/// Operator = overload for HashTbl objects.
+			HashTbl& operator=( const HashTbl & other )
+			{
+				if( this == &other )
+					return *this;
+
+				clear();
+				release( m_tags, m_slots, m_size );
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_copy_assignment::value )
+					m_alloc = other.m_alloc;
+				m_max_load = other.m_max_load;
+				m_min_load = other.m_min_load;
+				allocate( other.m_bucket_count );
+				copy_slots( other );
+
+				return *this;
+			}
+
+			/// Move assignment, see table_base::move_assign().
+			HashTbl& operator=( HashTbl && other )
+				noexcept( std::allocator_traits< Allocator >::propagate_on_container_move_assignment::value )
+			{
+				if( this != &other )
+					this->move_assign( other );
+				return *this;
+			}
+
+			/// Operator = overload for std::initializer_list
+			HashTbl& operator=( std::initializer_list < Entry > ilist )
+			{
+				clear();
+				this->insert( ilist.begin(), ilist.end() );
+
+				return *this;
+			}
+
+			//=== Methods
+			/// Removes from the table an item identified by its k_ key. If the key is found, this method returns true, otherwise it returns false.
+			bool erase ( const KeyType & k_ )
+			{ return erase< KeyType >( k_ ); }
+
+			/// Same as the erase() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool erase ( const K & k_ )
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+
+				if( pos == npos )
+					return false;
+
+				entry( pos ).~Entry();
+				tag_at( pos ) = 0;
+				m_count--;
+
+				if( pos >= m_size )
+					m_stashed--;
+				else if( m_stashed != 0 )
+					unstash();
+
+				shrink_if_sparse();
+				return true;
+			}
+
+			/// Looks up the n_ keys of keys_ in one go. Keys are hashed and both their buckets prefetched PREFETCH_DISTANCE keys ahead of the one being searched, so the cache misses of successive keys overlap instead of being paid one after the other. For each keys_[i] found, its data is copied to data_[i]; found_[i], unless found_ is nullptr, tells whether keys_[i] was found. Returns the number of keys found.
+			size_t retrieve_many ( const KeyType * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{ return retrieve_many< KeyType >( keys_, n_, data_, found_ ); }
+
+			/// Same as the retrieve_many() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t retrieve_many ( const K * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{
+				size_t hashes[ PREFETCH_DISTANCE ];
+				size_t found = 0;
+
+				if( m_count == 0 )
+				{
+					if( found_ != nullptr )
+						std::fill( found_, found_ + n_, false );
+					this->count_lookups( 0, n_ );
+					return 0;
+				}
+
+				auto prepare = [&]( size_t j_ )
+				{
+					size_t r = j_ % PREFETCH_DISTANCE;
+					hashes[r] = hash_of( keys_[j_] );
+					size_t first = home_bucket( hashes[r] );
+					prefetch( &m_tags[ first * cuckoo::BUCKET_SLOTS ] );
+					prefetch( &m_slots[ first * cuckoo::BUCKET_SLOTS ] );
+					prefetch( &m_tags[ alt_bucket( first, tag( hashes[r] ) ) * cuckoo::BUCKET_SLOTS ] );
+				};
+
+				for( size_t j = 0 ; j < PREFETCH_DISTANCE and j < n_ ; j++ )
+					prepare( j );
+
+				for( size_t i = 0 ; i < n_ ; i++ )
+				{
+					size_t pos = find_slot( keys_[i], hashes[ i % PREFETCH_DISTANCE ] );
+					if( pos != npos )
+					{
+						data_[i] = entry( pos ).m_data;
+						found++;
+					}
+					if( found_ != nullptr )
+						found_[i] = ( pos != npos );
+
+					if( i + PREFETCH_DISTANCE < n_ )
+						prepare( i + PREFETCH_DISTANCE );
+				}
+
+				this->count_lookups( found, n_ - found );
+				return found;
+			}
+
+			/// Clears all memory associated to the Hashtable's slots, removing all it's elements.
+			void clear ( void )
+			{
+				for( size_t i = 0 ; i < positions() ; i++ )
+					if( tag_at( i ) != 0 )
+					{
+						entry( i ).~Entry();
+						tag_at( i ) = 0;
+					}
+
+				m_count = 0;
+				m_stashed = 0;
+			}
+
+			/// Sets the number of buckets to the power of two giving at least n_ slots, and at least the number needed to keep size() entries under max_load_factor(). Shrinks the table if that is less than bucket_count().
+			void rehash( size_t n_ )
+			{
+				size_t buckets = buckets_for( m_count );
+				while( buckets * cuckoo::BUCKET_SLOTS < n_ )
+					buckets *= 2;
+
+				if( buckets != m_bucket_count )
+					resize( buckets );
+			}
+
+			/// Makes room for n_ entries, so inserting up to n_ entries triggers no rehash, unless some of them find no displacement path.
+			void reserve( size_t n_ )
+			{
+				size_t needed = buckets_for( n_ );
+				if( needed > m_bucket_count )
+					resize( needed );
+			}
+
+			/// Returns the number of elements stored in the two buckets of the k_ key.
+			size_t count( const KeyType& k_ ) const
+			{ return count< KeyType >( k_ ); }
+
+			/// Same as the count() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t count( const K& k_ ) const
+			{
+				size_t counter = 0u;
+
+				if( m_size == 0 )
+					return counter;
+
+				size_t hash = hash_of( k_ );
+				size_t first = home_bucket( hash );
+				size_t second = alt_bucket( first, tag( hash ) );
+
+				for( size_t i = 0 ; i < cuckoo::BUCKET_SLOTS ; i++ )
+				{
+					counter += tag_at( first * cuckoo::BUCKET_SLOTS + i ) != 0;
+					if( second != first )
+						counter += tag_at( second * cuckoo::BUCKET_SLOTS + i ) != 0;
+				}
+
+				return counter;
+			}
+
+			/// Returns an iterator to the first entry, or end() if the table is empty.
+			iterator begin( void )
+			{ return first< iterator >( this ); }
+
+			/// Returns the past-the-end iterator.
+			iterator end( void )
+			{ return iterator( this, positions() ); }
+
+			/// Returns a const_iterator to the first entry, or end() if the table is empty.
+			const_iterator begin( void ) const
+			{ return first< const_iterator >( this ); }
+
+			/// Returns the past-the-end const_iterator.
+			const_iterator end( void ) const
+			{ return const_iterator( this, positions() ); }
+
+			/// Returns an iterator to the entry of the k_ key, or end() if the key is not on the table.
+			iterator find( const KeyType & k_ )
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			iterator find( const K & k_ )
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+				return iterator( this, pos == npos ? positions() : pos );
+			}
+
+			/// Returns a const_iterator to the entry of the k_ key, or end() if the key is not on the table.
+			const_iterator find( const KeyType & k_ ) const
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			const_iterator find( const K & k_ ) const
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+				return const_iterator( this, pos == npos ? positions() : pos );
+			}
+
+			/// A depuration method used to generate a textual representation of the hashtable and it's elements.
+			friend std::ostream& operator<< ( std::ostream & os, const HashTbl & tbl )
+			{
+				for( size_t i = 0 ; i < tbl.positions() ; i++ )
+				{
+					if( i < tbl.m_size )
+						os << "[" << i / cuckoo::BUCKET_SLOTS << "." << i % cuckoo::BUCKET_SLOTS << "]";
+					else
+						os << "[stash " << i - tbl.m_size << "]";
+					if( tbl.tag_at( i ) != 0 )
+						os << " -> " << tbl.entry( i ).m_data;
+					os << std::endl;
+				}
+				return os;
+			}
+
+		private:
+			typedef typename std::aligned_storage< sizeof( Entry ), alignof( Entry ) >::type Slot;
+
+			/// One bucket reached by the search for a displacement path, through the entry in slot of the parent bucket, which may move there.
+			struct Step
+			{
+				size_t bucket;
+				uint16_t parent;
+				uint8_t slot;
+				uint8_t depth; //!< Entries to move to free a slot of this bucket.
+			};
+
+			Entry& entry( size_t pos_ )
+			{ return *reinterpret_cast< Entry* >( &m_slots[pos_] ); }
+
+			const Entry& entry( size_t pos_ ) const
+			{ return *reinterpret_cast< const Entry* >( &m_slots[pos_] ); }
+
+			uint8_t& tag_at( size_t pos_ )
+			{ return m_tags[pos_]; }
+
+			uint8_t tag_at( size_t pos_ ) const
+			{ return m_tags[pos_]; }
+
+			/// Number of slots, stash included: the end of the positions walked by iterators.
+			size_t positions( void ) const
+			{ return positions( m_size ); }
+
+			/// Number of slots, stash included, of a table with size_ slots in its buckets.
+			static size_t positions( size_t size_ )
+			{ return size_ == 0 ? 0 : size_ + cuckoo::STASH_SLOTS; }
+
+			/// Iterator to the first entry of tbl_, or the end.
+			template < typename It, typename Table >
+			static It first( Table * tbl_ )
+			{
+				It it( tbl_, 0 );
+				it.skip_empty();
+				return it;
+			}
+
+			/// Hash of k_, with its bits spread so both the bucket index (high bits) and the tag (low 8 bits) are usable.
+			template < typename K >
+			static size_t hash_of( const K & k_ )
+			{
+				KeyHash hashFunc;
+
+				return static_cast< size_t >( mix_hash( hashFunc( k_ ) ) );
+			}
+
+			/// Mixed hash of the key of e_: the stored one with cache_hash, otherwise KeyHash is called again.
+			static size_t hash_of_entry( const Entry & e_ )
+			{
+				if constexpr ( std::is_same< HashPolicy, cache_hash >::value )
+					return e_.m_hash;
+				else
+					return hash_of( e_.m_key );
+			}
+
+			/// The tag kept next to the entry: the low 8 bits of the hash, 0 being taken by empty slots.
+			static uint8_t tag( size_t hash_ )
+			{
+				uint8_t t = static_cast< uint8_t >( hash_ & 0xFF );
+				return t == 0 ? 1 : t;
+			}
+
+			/// First bucket of hash_.
+			size_t home_bucket( size_t hash_ ) const
+			{ return ( hash_ >> 8 ) & ( m_bucket_count - 1 ); }
+
+			/// The other bucket of an entry tagged tag_ sitting in bucket_: either bucket leads to the other one, so entries are displaced without hashing their keys.
+			size_t alt_bucket( size_t bucket_, uint8_t tag_ ) const
+			{ return ( bucket_ ^ ( ( tag_ + 1u ) * static_cast< size_t >( 0xc6a4a7935bd1e995ULL ) ) ) & ( m_bucket_count - 1 ); }
+
+			/// Maximum number of entries for a table of size_ slots, under max_load_factor().
+			size_t max_load( size_t size_ ) const
+			{ return static_cast< size_t >( m_max_load * size_ ); }
+
+			/// Smallest power of two number of buckets, at least MIN_BUCKETS, that holds n_ entries.
+			size_t buckets_for( size_t n_ ) const
+			{
+				size_t buckets = cuckoo::MIN_BUCKETS;
+				while( max_load( buckets * cuckoo::BUCKET_SLOTS ) < n_ )
+					buckets *= 2;
+				return buckets;
+			}
+
+			/// Returns the slot holding the k_ key, or npos if the key is not on the table. Reads the first bucket, then the second one, then the stash if it is not empty.
+			template < typename K >
+			size_t find_slot( const K & k_, size_t hash_ ) const
+			{
+				if( m_count == 0 )
+					return npos;
+
+				uint8_t t = tag( hash_ );
+				size_t first = home_bucket( hash_ );
+				size_t pos = find_in( first * cuckoo::BUCKET_SLOTS, cuckoo::BUCKET_SLOTS, k_, hash_, t );
+
+				if( pos == npos )
+					pos = find_in( alt_bucket( first, t ) * cuckoo::BUCKET_SLOTS, cuckoo::BUCKET_SLOTS, k_, hash_, t );
+				if( pos == npos and m_stashed != 0 )
+					pos = find_in( m_size, cuckoo::STASH_SLOTS, k_, hash_, t );
+
+				return pos;
+			}
+
+			/// Returns the slot holding the k_ key among the n_ slots from first_, or npos.
+			template < typename K >
+			size_t find_in( size_t first_, size_t n_, const K & k_, size_t hash_, uint8_t tag_ ) const
+			{
+				KeyEqual equalFunc;
+
+				for( size_t pos = first_ ; pos < first_ + n_ ; pos++ )
+					if( tag_at( pos ) == tag_ and entry( pos ).same_hash( hash_ ) and equalFunc( entry( pos ).m_key, k_ ) )
+						return pos;
+
+				return npos;
+			}
+
+			/// First empty slot of bucket_, or npos if it is full.
+			size_t free_slot( size_t bucket_ ) const
+			{
+				for( size_t pos = bucket_ * cuckoo::BUCKET_SLOTS ; pos < ( bucket_ + 1 ) * cuckoo::BUCKET_SLOTS ; pos++ )
+					if( m_tags[pos] == 0 )
+						return pos;
+				return npos;
+			}
+
+			/// True if bucket_ is already on the path from the root to path_[node_], which would move an entry twice.
+			static bool on_path( const Step * path_, size_t node_, size_t bucket_ )
+			{
+				for( size_t i = node_ ; ; i = path_[i].parent )
+				{
+					if( path_[i].bucket == bucket_ )
+						return true;
+					if( path_[i].parent == NO_PARENT )
+						return false;
+				}
+			}
+
+			/// Returns an empty slot for an entry whose mixed hash is hash_: a free slot of one of its buckets, made if needed by moving the entries along the shortest displacement path found, or else a free slot of the stash. Returns npos, having moved nothing, if there is none.
+			size_t make_room( size_t hash_ )
+			{
+				Step path[ cuckoo::SEARCH_NODES ];
+				size_t nodes = 0;
+				size_t first = home_bucket( hash_ );
+				size_t roots[2] = { first, alt_bucket( first, tag( hash_ ) ) };
+
+				// Free slots are looked for as buckets are reached, so the shortest path wins.
+				for( size_t r = 0 ; r < 2 ; r++ )
+				{
+					if( r == 1 and roots[1] == roots[0] )
+						break;
+
+					path[nodes] = Step{ roots[r], NO_PARENT, 0, 0 };
+					size_t pos = free_slot( roots[r] );
+					if( pos != npos )
+						return displace( path, nodes, pos );
+					nodes++;
+				}
+
+				for( size_t head = 0 ; head < nodes ; head++ )
+				{
+					Step from = path[head];
+					if( from.depth == cuckoo::MAX_DISPLACEMENTS )
+						break;
+
+					for( size_t i = 0 ; i < cuckoo::BUCKET_SLOTS and nodes < cuckoo::SEARCH_NODES ; i++ )
+					{
+						size_t to = alt_bucket( from.bucket, tag_at( from.bucket * cuckoo::BUCKET_SLOTS + i ) );
+						if( on_path( path, head, to ) )
+							continue;
+
+						path[nodes] = Step{ to, static_cast< uint16_t >( head ), static_cast< uint8_t >( i ), static_cast< uint8_t >( from.depth + 1 ) };
+						size_t pos = free_slot( to );
+						if( pos != npos )
+							return displace( path, nodes, pos );
+						nodes++;
+					}
+				}
+
+				for( size_t pos = m_size ; pos < positions() ; pos++ )
+					if( tag_at( pos ) == 0 )
+						return pos;
+
+				return npos;
+			}
+
+			/// Moves the entries of the path ending on path_[node_], from the empty slot free_ back to a root bucket, whose slot they free is returned.
+			size_t displace( const Step * path_, size_t node_, size_t free_ )
+			{
+				for( size_t i = node_ ; path_[i].parent != NO_PARENT ; i = path_[i].parent )
+				{
+					size_t from = path_[ path_[i].parent ].bucket * cuckoo::BUCKET_SLOTS + path_[i].slot;
+					move_slot( from, free_ );
+					free_ = from;
+				}
+
+				return free_;
+			}
+
+			/// Moves the entry of the from_ slot, with its tag, to the empty to_ slot.
+			void move_slot( size_t from_, size_t to_ )
+			{
+				::new ( static_cast< void* >( &entry( to_ ) ) ) Entry( std::move( entry( from_ ) ) );
+				entry( from_ ).~Entry();
+				tag_at( to_ ) = tag_at( from_ );
+				tag_at( from_ ) = 0;
+			}
+
+			/// Moves the stashed entries that now find a free slot in one of their buckets back there.
+			void unstash( void )
+			{
+				for( size_t pos = m_size ; pos < positions() ; pos++ )
+				{
+					if( tag_at( pos ) == 0 )
+						continue;
+
+					size_t first = home_bucket( hash_of_entry( entry( pos ) ) );
+					size_t to = free_slot( first );
+					if( to == npos )
+						to = free_slot( alt_bucket( first, tag_at( pos ) ) );
+
+					if( to != npos )
+					{
+						move_slot( pos, to );
+						m_stashed--;
+					}
+				}
+			}
+
+			/// Entry of the k_ key, whose mixed hash is hash_, or nullptr if the key is not on the table.
+			template < typename K >
+			Entry * find_entry( const K & k_, size_t hash_ ) const
+			{
+				size_t pos = find_slot( k_, hash_ );
+				return pos == npos ? nullptr : reinterpret_cast< Entry* >( &m_slots[pos] );
+			}
+
+			/// Constructs, in its slot, the entry built from args_ for a key that is known not to be on the table, growing it first if needed. Returns the new entry. Throws std::length_error when no slot is found while the table is under half full: every entry is kept, but the table may have grown and its entries moved to other slots by then.
+			template < typename... Args >
+			Entry & place( size_t hash_, Args &&... args_ )
+			{
+				if( m_size == 0 )
+					allocate( buckets_for( 1 ) );
+
+				if( m_count + 1 > max_load( m_size ) )
+					resize( m_bucket_count * 2 );
+
+				size_t pos;
+				while( ( pos = make_room( hash_ ) ) == npos )
+				{
+					if( 2 * m_count < m_size )
+						throw std::length_error( "cuckoo_table: too many keys share both their buckets, KeyHash is too weak" );
+					resize( m_bucket_count * 2 );
+				}
+
+				construct( pos, hash_, std::forward< Args >( args_ )... );
+				return entry( pos );
+			}
+
+			/// Builds, in the empty pos_ slot, the entry of args_, whose key hashes to hash_.
+			template < typename... Args >
+			void construct( size_t pos_, size_t hash_, Args &&... args_ )
+			{
+				::new ( static_cast< void* >( &entry( pos_ ) ) ) Entry( std::forward< Args >( args_ )... );
+				entry( pos_ ).set_hash( hash_ );
+				tag_at( pos_ ) = tag( hash_ );
+				m_count++;
+				if( pos_ >= m_size )
+					m_stashed++;
+			}
+
+			/// Number of entries to size the table for when n_ entries are about to be inserted.
+			static size_t initial_size( size_t n_ )
+			{ return n_ == 0 ? DEFAULT_SIZE : n_; }
+
+			/// Grows the table at once if the current load is above a new max_load_factor().
+			void refit( void )
+			{
+				if( m_size != 0 and buckets_for( m_count ) > m_bucket_count )
+					resize( buckets_for( m_count ) );
+			}
+
+			/// Fills the shape part of s_, for stats(), by walking every slot: histogram of where the entries sit (0 in their first bucket, 1 in their second one, 2 in the stash), the furthest of those, empty slots and memory held. Each entry's hash is needed, so KeyHash is called once per entry unless hashes are cached. Many entries out of their first bucket well under max_load_factor(), or any in the stash, point to a weak KeyHash.
+			void measure( HashStats & s_ ) const
+			{
+				size_t empty = 0;
+				for( size_t i = 0 ; i < positions() ; i++ )
+				{
+					if( tag_at( i ) == 0 )
+					{
+						empty += i < m_size;
+						continue;
+					}
+
+					size_t where = 2;
+					if( i < m_size )
+						where = i / cuckoo::BUCKET_SLOTS == home_bucket( hash_of_entry( entry( i ) ) ) ? 0 : 1;
+					count_length( s_.histogram, where );
+					s_.longest = std::max( s_.longest, where );
+				}
+
+				s_.empty_ratio = m_size == 0 ? 0.0 : static_cast< double >( empty ) / m_size;
+				s_.bytes = positions() * ( sizeof( Slot ) + sizeof( uint8_t ) );
+			}
+
+			/// Shrinks the table, to at most half of max_load_factor(), when its load fell below min_load_factor().
+			void shrink_if_sparse( void )
+			{
+				if( m_min_load > 0 and m_bucket_count > cuckoo::MIN_BUCKETS and this->load_factor() < m_min_load )
+					resize( buckets_for( 2 * m_count ) );
+			}
+
+			/// Moves every entry to a new table with buckets_ buckets, doubled until every entry finds room, which only happens if buckets_ leaves little slack.
+			void resize( size_t buckets_ )
+			{
+				auto timer = this->time_rehash();
+				uint8_t * old_tags = m_tags;
+				Slot * old_slots = m_slots;
+				size_t old_size = m_size;
+
+				for( size_t buckets = buckets_ ; ; buckets *= 2 )
+				{
+					allocate( buckets );
+
+					size_t i = 0;
+					for( ; i < positions( old_size ) ; i++ )
+					{
+						if( old_tags[i] == 0 )
+							continue;
+
+						Entry & e = *reinterpret_cast< Entry* >( &old_slots[i] );
+						size_t hash = hash_of_entry( e );
+						size_t pos = make_room( hash );
+						if( pos == npos )
+							break;
+
+						construct( pos, hash, std::move( e ) );
+						e.~Entry();
+						old_tags[i] = 0;
+					}
+
+					if( i == positions( old_size ) )
+						break;
+
+					// An entry found no room: the ones already moved go back to the slots they left, and the table doubles.
+					size_t back = 0;
+					for( size_t j = 0 ; j < positions() ; j++ )
+					{
+						if( m_tags[j] == 0 )
+							continue;
+
+						while( old_tags[back] != 0 )
+							back++;
+						::new ( static_cast< void* >( &old_slots[back] ) ) Entry( std::move( entry( j ) ) );
+						entry( j ).~Entry();
+						old_tags[back] = m_tags[j];
+					}
+					release( m_tags, m_slots, m_size );
+				}
+
+				release( old_tags, old_slots, old_size );
+			}
+
+			/// Copies every entry from other, which must have the same size, keeping their slots.
+			void copy_slots( const HashTbl & other )
+			{
+				for( size_t i = 0 ; i < positions() ; i++ )
+				{
+					if( other.tag_at( i ) != 0 )
+					{
+						::new ( static_cast< void* >( &entry( i ) ) ) Entry( other.entry( i ) );
+						tag_at( i ) = other.tag_at( i );
+					}
+				}
+
+				m_count = other.m_count;
+				m_stashed = other.m_stashed;
+			}
+
+			using TagAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< uint8_t >;
+			using SlotAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Slot >;
+
+			/// Allocates an empty table with buckets_ buckets and the stash, without any array if buckets_ is zero. The previous arrays must have been released.
+			void allocate( size_t buckets_ )
+			{
+				m_bucket_count = buckets_;
+				m_size = buckets_ * cuckoo::BUCKET_SLOTS;
+				m_tags = nullptr;
+				m_slots = nullptr;
+
+				if( m_size != 0 )
+				{
+					TagAlloc tag_alloc( m_alloc );
+					SlotAlloc slot_alloc( m_alloc );
+					m_tags = std::allocator_traits< TagAlloc >::allocate( tag_alloc, positions() );
+					m_slots = std::allocator_traits< SlotAlloc >::allocate( slot_alloc, positions() );
+					std::memset( m_tags, 0, positions() );
+				}
+
+				m_count = 0;
+				m_stashed = 0;
+			}
+
+			/// Frees the arrays of a table with size_ slots in its buckets, whose entries must have been destroyed already.
+			void release( uint8_t * tags_, Slot * slots_, size_t size_ )
+			{
+				if( size_ == 0 )
+					return;
+
+				TagAlloc tag_alloc( m_alloc );
+				SlotAlloc slot_alloc( m_alloc );
+				std::allocator_traits< TagAlloc >::deallocate( tag_alloc, tags_, positions( size_ ) );
+				std::allocator_traits< SlotAlloc >::deallocate( slot_alloc, slots_, positions( size_ ) );
+			}
+
+			/// Exchanges everything but the allocators. Both must be equal, or their buckets be exchanged back before any allocation.
+			void swap_contents ( HashTbl & other ) noexcept
+			{
+				std::swap( m_bucket_count, other.m_bucket_count );
+				std::swap( m_size, other.m_size );
+				std::swap( m_count, other.m_count );
+				std::swap( m_stashed, other.m_stashed );
+				std::swap( m_tags, other.m_tags );
+				std::swap( m_slots, other.m_slots );
+				std::swap( m_max_load, other.m_max_load );
+				std::swap( m_min_load, other.m_min_load );
+			}
+
+			Allocator m_alloc; //!< Allocator of the tags and slots, rebound to each.
+			size_t m_bucket_count = 0u; //!< Number of buckets, a power of two, the stash left out.
+			size_t m_size = 0u; //!< Number of slots, BUCKET_SLOTS per bucket.
+			size_t m_count = 0u; //!< Number of elements on the table, stashed ones included.
+			size_t m_stashed = 0u; //!< Number of elements in the stash.
+			uint8_t * m_tags = nullptr; //!< One tag per slot, 0 for an empty one, stash included.
+			Slot * m_slots = nullptr; //!< The slots of the buckets, BUCKET_SLOTS after BUCKET_SLOTS, followed by the STASH_SLOTS of the stash.
+			float m_max_load = MAX_LOAD; //!< Load factor the table grows past.
+			float m_min_load = 0.0f; //!< Load factor erase() shrinks the table below, 0 for never.
+			static constexpr float MAX_LOAD = 0.95f; //!< Highest allowed maximum load factor, past which displacement paths often fail.
+			static const short DEFAULT_SIZE = 11;
+			static constexpr size_t PREFETCH_DISTANCE = 8; //!< How many keys ahead retrieve_many() prefetches.
+			static const uint16_t NO_PARENT = static_cast< uint16_t >( -1 ); //!< Parent of the two root buckets of a displacement path.
+			static const size_t npos = static_cast< size_t >( -1 ); //!< "Not found" slot index.
+
+	}; // HashTbl cuckoo table specialization
+} // ac Namespace
+#endif
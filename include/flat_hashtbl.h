@@ -0,0 +1,686 @@
+#ifndef FLAT_HASH_H
+#define FLAT_HASH_H
+
+#include <utility>
+#include <new>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/*! \class HashTbl< KeyType, DataType, KeyHash, KeyEqual, open_addressing, SizePolicy, HashPolicy >
+		\brief Open addressing version of the HashTbl.
+
+		Every entry is stored inline in one contiguous slot array, so a lookup touches
+		consecutive memory instead of chasing list nodes. Collisions are resolved with
+		Robin Hood linear probing: each slot remembers how far it sits from its home slot,
+		and an insertion steals the slot of any entry that is closer to home than itself.
+		This keeps probe sequences short and lets an unsuccessful search stop early.
+		Removal uses backward-shift deletion, so no tombstones are ever left behind.
+	*/
+	template < typename KeyType,
+			   typename DataType,
+			   typename KeyHash,
+			   typename KeyEqual,
+			   typename SizePolicy,
+			   typename HashPolicy,
+			   typename Allocator,
+			   typename StatsPolicy >
+	class HashTbl< KeyType, DataType, KeyHash, KeyEqual, open_addressing, SizePolicy, HashPolicy, Allocator, StatsPolicy >
+		: public table_base< HashTbl< KeyType, DataType, KeyHash, KeyEqual, open_addressing, SizePolicy, HashPolicy, Allocator, StatsPolicy >,
+							 KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >
+	{
+		using Base = table_base< HashTbl, KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >; //!< Shared interface, built on the primitives below.
+		friend Base;
+
+		public:
+			using Entry = typename Base::Entry; //!< Alias
+
+			template < typename K >
+			using lookup_key = typename Base::template lookup_key< K >; //!< Alias
+
+			/*! \class basic_iterator
+				\brief Forward iterator over the entries, slot by slot in memory order.
+
+				Any insertion may rehash the table and invalidate every iterator; erasing shifts entries back and invalidates them too.
+			*/
+			template < bool Const >
+			class basic_iterator
+			{
+				friend class HashTbl;
+				friend class basic_iterator< not Const >;
+
+				using Table = typename std::conditional< Const, const HashTbl, HashTbl >::type;
+
+				public:
+					using iterator_category = std::forward_iterator_tag;
+					using value_type = Entry;
+					using difference_type = std::ptrdiff_t;
+					using pointer = typename std::conditional< Const, const Entry *, Entry * >::type;
+					using reference = typename std::conditional< Const, const Entry &, Entry & >::type;
+
+					basic_iterator( void ) = default;
+
+					/// An iterator converts to a const_iterator.
+					template < bool C, typename = typename std::enable_if< Const and not C >::type >
+					basic_iterator( const basic_iterator< C > & other ) : m_tbl( other.m_tbl ), m_pos( other.m_pos )
+					{  }
+
+					reference operator*( void ) const
+					{ return m_tbl->entry_at( m_pos ); }
+
+					pointer operator->( void ) const
+					{ return &m_tbl->entry_at( m_pos ); }
+
+					basic_iterator& operator++( void )
+					{
+						m_pos++;
+						skip_empty();
+						return *this;
+					}
+
+					basic_iterator operator++( int )
+					{
+						basic_iterator old( *this );
+						++( *this );
+						return old;
+					}
+
+					template < bool C >
+					bool operator==( const basic_iterator< C > & other ) const
+					{ return m_pos == other.m_pos; }
+
+					template < bool C >
+					bool operator!=( const basic_iterator< C > & other ) const
+					{ return not ( *this == other ); }
+
+				private:
+					basic_iterator( Table * tbl_, size_t pos_ ) : m_tbl( tbl_ ), m_pos( pos_ )
+					{  }
+
+					/// Moves to the first full slot at or after the current one, or to the end.
+					void skip_empty( void )
+					{
+						while( m_pos < m_tbl->m_size and m_tbl->m_slots[m_pos].dist == 0 )
+							m_pos++;
+					}
+
+					Table * m_tbl = nullptr;
+					size_t m_pos = 0u; //!< Slot index, m_size at the end.
+			};
+
+			using iterator = basic_iterator< false >; //!< Alias
+			using const_iterator = basic_iterator< true >; //!< Alias
+
+			//== Constructors
+			/// Constructor with a defined size. The slot array comes from alloc_.
+			HashTbl( size_t tbl_size_ = DEFAULT_SIZE, const Allocator & alloc_ = Allocator() ) : m_alloc( alloc_ )
+			{
+				m_size = SizePolicy::capacity( tbl_size_ == 0 ? 1 : tbl_size_ );
+				m_reduce = Reducer( m_size );
+				m_count = 0;
+
+				m_slots = new_slots( m_size );
+			}
+
+			/// Constructor with the default size and an allocator.
+			explicit HashTbl( const Allocator & alloc_ ) : HashTbl( DEFAULT_SIZE, alloc_ )
+			{  }
+
+			/// Default destructor.
+			virtual ~HashTbl()
+			{
+				clear();
+				delete_slots( m_slots, m_size );
+			}
+
+			/// Copy constructor. The allocator is obtained as for the standard containers, from select_on_container_copy_construction().
+			HashTbl( const HashTbl& other )
+				: m_alloc( std::allocator_traits< Allocator >::select_on_container_copy_construction( other.m_alloc ) )
+			{
+				m_size = other.m_size;
+				m_reduce = other.m_reduce;
+				m_count = 0;
+				m_max_load = other.m_max_load;
+				m_min_load = other.m_min_load;
+				m_slots = new_slots( m_size );
+
+				copy_slots( other );
+			}
+
+			/// Move constructor. Takes over the slots and the allocator of other, which is left empty and without slots until its next insertion.
+			HashTbl( HashTbl&& other ) noexcept : m_alloc( other.m_alloc )
+			{
+				swap_contents( other );
+			}
+
+			/// Range constructor: builds the table from [first_, last_), whose elements are entries or key/data pairs. With forward iterators the range is counted first and the slot array allocated once, at its final size. A key appearing twice keeps its last data, as with insert().
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			HashTbl( InputIt first_, InputIt last_, const Allocator & alloc_ = Allocator() )
+				: HashTbl( initial_size( range_length( first_, last_ ) ), alloc_ )
+			{
+				this->insert( first_, last_ );
+			}
+
+			/// std::initializer_list copy constructor.
+			HashTbl( std::initializer_list < Entry > ilist, const Allocator & alloc_ = Allocator() )
+				: HashTbl( ilist.begin(), ilist.end(), alloc_ )
+			{  }
+
+			//=== Operators
+			/// Operator = overload for HashTbl objects.
+			HashTbl& operator=( const HashTbl & other )
+			{
+				if( this == &other )
+					return *this;
+
+				clear();
+				delete_slots( m_slots, m_size );
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_copy_assignment::value )
+					m_alloc = other.m_alloc;
+
+				m_size = other.m_size;
+				m_reduce = other.m_reduce;
+				m_max_load = other.m_max_load;
+				m_min_load = other.m_min_load;
+				m_slots = new_slots( m_size );
+
+				copy_slots( other );
+
+				return *this;
+			}
+
+			/// Move assignment, see table_base::move_assign().
+			HashTbl& operator=( HashTbl && other )
+				noexcept( std::allocator_traits< Allocator >::propagate_on_container_move_assignment::value )
+			{
+				if( this != &other )
+					this->move_assign( other );
+				return *this;
+			}
+
+			/// Operator = overload for std::initializer_list
+			HashTbl& operator=( std::initializer_list < Entry > ilist )
+			{
+				clear();
+				this->insert( ilist.begin(), ilist.end() );
+
+				return *this;
+			}
+
+			//=== Methods
+			/// Removes from the table an item identified by its k_ key. If the key is found, this method returns true, otherwise it returns false.
+			bool erase ( const KeyType & k_ )
+			{ return erase< KeyType >( k_ ); }
+
+			/// Same as the erase() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool erase ( const K & k_ )
+			{
+				size_t pos = find_slot( k_ );
+
+				if( pos == npos )
+					return false;
+
+				m_slots[pos].destroy();
+
+				// Backward-shift: pull every displaced successor one slot closer to home.
+				size_t next = advance( pos );
+				while( m_slots[next].dist > 1 )
+				{
+					m_slots[pos].construct( std::move( m_slots[next].entry() ), m_slots[next].dist - 1 );
+					m_slots[next].destroy();
+
+					pos = next;
+					next = advance( next );
+				}
+
+				m_count--;
+				shrink_if_sparse();
+				return true;
+			}
+
+			/// Looks up the n_ keys of keys_ in one go. Keys are hashed and their home slot prefetched PREFETCH_DISTANCE keys ahead of the one being searched, so the cache misses of successive keys overlap instead of being paid one after the other. For each keys_[i] found, its data is copied to data_[i]; found_[i], unless found_ is nullptr, tells whether keys_[i] was found. Returns the number of keys found.
+			size_t retrieve_many ( const KeyType * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{ return retrieve_many< KeyType >( keys_, n_, data_, found_ ); }
+
+			/// Same as the retrieve_many() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t retrieve_many ( const K * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{
+				KeyHash hashFunc;
+				size_t hashes[ PREFETCH_DISTANCE ];
+				size_t homes[ PREFETCH_DISTANCE ];
+				size_t found = 0;
+
+				if( m_count == 0 )
+				{
+					if( found_ != nullptr )
+						std::fill( found_, found_ + n_, false );
+					this->count_lookups( 0, n_ );
+					return 0;
+				}
+
+				auto prepare = [&]( size_t j_ )
+				{
+					size_t r = j_ % PREFETCH_DISTANCE;
+					hashes[r] = hashFunc( keys_[j_] );
+					homes[r] = m_reduce( hashes[r] );
+					prefetch( &m_slots[ homes[r] ] );
+				};
+
+				for( size_t j = 0 ; j < PREFETCH_DISTANCE and j < n_ ; j++ )
+					prepare( j );
+
+				for( size_t i = 0 ; i < n_ ; i++ )
+				{
+					size_t r = i % PREFETCH_DISTANCE;
+					size_t pos = find_slot_from( keys_[i], hashes[r], homes[r] );
+					if( pos != npos )
+					{
+						data_[i] = m_slots[pos].entry().m_data;
+						found++;
+					}
+					if( found_ != nullptr )
+						found_[i] = ( pos != npos );
+
+					if( i + PREFETCH_DISTANCE < n_ )
+						prepare( i + PREFETCH_DISTANCE );
+				}
+
+				this->count_lookups( found, n_ - found );
+				return found;
+			}
+
+			/// Clears all memory associated to the Hashtable's slots, removing all it's elements.
+			void clear ( void )
+			{
+				for( size_t i = 0 ; i < m_size ; i++ )
+					if( m_slots[i].dist != 0 )
+						m_slots[i].destroy();
+
+				m_count = 0;
+			}
+
+			/// Sets the number of slots to SizePolicy::capacity() of n_, or of the number needed to keep size() entries under max_load_factor() if that is larger. Shrinks the table if that is less than bucket_count().
+			void rehash( size_t n_ )
+			{
+				size_t needed = static_cast< size_t >( std::ceil( m_count / static_cast< double >( m_max_load ) ) );
+				size_t new_size = SizePolicy::capacity( std::max< size_t >( { n_, needed, 1 } ) );
+
+				if( new_size != m_size )
+					resize( new_size );
+			}
+
+			/// Makes room for n_ entries, so inserting up to n_ entries triggers no rehash.
+			void reserve( size_t n_ )
+			{
+				size_t needed = static_cast< size_t >( std::ceil( n_ / static_cast< double >( m_max_load ) ) );
+				if( needed > m_size )
+					rehash( needed );
+			}
+
+			/// Returns the number of elements from the hashtable that share the home slot of the k_ key.
+			size_t count( const KeyType& k_ ) const
+			{ return count< KeyType >( k_ ); }
+
+			/// Same as the count() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t count( const K& k_ ) const
+			{
+				KeyHash hashFunc;
+
+				if( m_size == 0 )
+					return 0;
+
+				size_t pos = m_reduce( hashFunc( k_ ) );
+				size_t counter = 0u;
+
+				// Entries with the same home are contiguous and all sit at distance d on slot home + d - 1.
+				for( size_t d = 1 ; m_slots[pos].dist >= d ; d++ )
+				{
+					if( m_slots[pos].dist == d )
+						counter++;
+					pos = advance( pos );
+				}
+
+				return counter;
+			}
+
+			/// Returns an iterator to the first entry, or end() if the table is empty.
+			iterator begin( void )
+			{ return first< iterator >( this ); }
+
+			/// Returns the past-the-end iterator.
+			iterator end( void )
+			{ return iterator( this, m_size ); }
+
+			/// Returns a const_iterator to the first entry, or end() if the table is empty.
+			const_iterator begin( void ) const
+			{ return first< const_iterator >( this ); }
+
+			/// Returns the past-the-end const_iterator.
+			const_iterator end( void ) const
+			{ return const_iterator( this, m_size ); }
+
+			/// Returns an iterator to the entry of the k_ key, or end() if the key is not on the table.
+			iterator find( const KeyType & k_ )
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			iterator find( const K & k_ )
+			{
+				size_t pos = find_slot( k_ );
+				return iterator( this, pos == npos ? m_size : pos );
+			}
+
+			/// Returns a const_iterator to the entry of the k_ key, or end() if the key is not on the table.
+			const_iterator find( const KeyType & k_ ) const
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			const_iterator find( const K & k_ ) const
+			{
+				size_t pos = find_slot( k_ );
+				return const_iterator( this, pos == npos ? m_size : pos );
+			}
+
+			/// A depuration method used to generate a textual representation of the hashtable and it's elements.
+			friend std::ostream& operator<< ( std::ostream & os, const HashTbl & tbl )
+			{
+				for( size_t i = 0 ; i < tbl.m_size ; i++ )
+				{
+					os << "[" << i << "]";
+					if( tbl.m_slots[i].dist != 0 )
+						os << " (+" << tbl.m_slots[i].dist - 1 << ") -> " << tbl.m_slots[i].entry().m_data;
+					os << std::endl;
+				}
+				return os;
+			}
+
+		private:
+			using Reducer = typename SizePolicy::reducer; //!< Maps hashes to slots for the current size.
+
+			/// One position of the flat table. dist == 0 means empty, otherwise the entry sits dist - 1 slots after its home.
+			struct Slot
+			{
+				size_t dist;
+				typename std::aligned_storage< sizeof( Entry ), alignof( Entry ) >::type storage;
+
+				Entry& entry()
+				{ return *reinterpret_cast< Entry* >( &storage ); }
+
+				const Entry& entry() const
+				{ return *reinterpret_cast< const Entry* >( &storage ); }
+
+				void construct( Entry && e_, size_t dist_ )
+				{
+					::new ( static_cast< void* >( &storage ) ) Entry( std::move( e_ ) );
+					dist = dist_;
+				}
+
+				void destroy()
+				{
+					entry().~Entry();
+					dist = 0;
+				}
+			};
+
+			/// Hash of the key of e_: the stored one with cache_hash, otherwise KeyHash is called again.
+			static size_t hash_of_entry( const Entry & e_ )
+			{
+				if constexpr ( std::is_same< HashPolicy, cache_hash >::value )
+					return e_.m_hash;
+				else
+					return KeyHash()( e_.m_key );
+			}
+
+			Entry& entry_at( size_t pos_ )
+			{ return m_slots[pos_].entry(); }
+
+			const Entry& entry_at( size_t pos_ ) const
+			{ return m_slots[pos_].entry(); }
+
+			/// Iterator to the first entry of tbl_, or the end.
+			template < typename It, typename Table >
+			static It first( Table * tbl_ )
+			{
+				It it( tbl_, 0 );
+				it.skip_empty();
+				return it;
+			}
+
+			using SlotAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Slot >;
+			using SlotTraits = std::allocator_traits< SlotAlloc >;
+
+			/// Allocates n_ empty slots with the table's allocator, or returns nullptr if n_ is zero.
+			Slot * new_slots( size_t n_ )
+			{
+				if( n_ == 0 )
+					return nullptr;
+
+				SlotAlloc alloc( m_alloc );
+				Slot * slots = SlotTraits::allocate( alloc, n_ );
+				for( size_t i = 0 ; i < n_ ; i++ )
+					slots[i].dist = 0;
+				return slots;
+			}
+
+			/// Frees the n_ slots of slots_, whose entries must have been destroyed already. Does nothing for nullptr.
+			void delete_slots( Slot * slots_, size_t n_ )
+			{
+				if( slots_ == nullptr )
+					return;
+
+				SlotAlloc alloc( m_alloc );
+				SlotTraits::deallocate( alloc, slots_, n_ );
+			}
+
+			/// Exchanges everything but the allocators. Both must be equal, or their slots be exchanged back before any allocation.
+			void swap_contents ( HashTbl & other ) noexcept
+			{
+				std::swap( m_size, other.m_size );
+				std::swap( m_reduce, other.m_reduce );
+				std::swap( m_count, other.m_count );
+				std::swap( m_slots, other.m_slots );
+				std::swap( m_max_load, other.m_max_load );
+				std::swap( m_min_load, other.m_min_load );
+			}
+
+			/// Returns the slot after pos, wrapping around the end of the table.
+			size_t advance( size_t pos ) const
+			{ return ( pos + 1 == m_size ) ? 0 : pos + 1; }
+
+			/// Hash of k_ as KeyHash gives it, used as is to pick home slots.
+			template < typename K >
+			static size_t hash_of( const K & k_ )
+			{ return KeyHash()( k_ ); }
+
+			/// Returns the slot holding the k_ key, or npos if the key is not on the table.
+			template < typename K >
+			size_t find_slot( const K & k_ ) const
+			{
+				if( m_count == 0 )
+					return npos;
+
+				return find_slot( k_, hash_of( k_ ) );
+			}
+
+			/// Same as the find_slot() above, for a key whose hash_ is already known.
+			template < typename K >
+			size_t find_slot( const K & k_, size_t hash_ ) const
+			{
+				if( m_count == 0 )
+					return npos;
+
+				return find_slot_from( k_, hash_, m_reduce( hash_ ) );
+			}
+
+			/// Same as the find_slot() above, for a key whose home_ slot is also known. The table must not be empty.
+			template < typename K >
+			size_t find_slot_from( const K & k_, size_t hash_, size_t home_ ) const
+			{
+				KeyEqual equalFunc;
+				size_t pos = home_;
+
+				// Once we meet a slot closer to its home than we are to ours, the key can't be further ahead.
+				for( size_t d = 1 ; m_slots[pos].dist >= d ; d++ )
+				{
+					if( m_slots[pos].dist == d and m_slots[pos].entry().same_hash( hash_ ) and equalFunc( m_slots[pos].entry().m_key, k_ ) )
+						return pos;
+					pos = advance( pos );
+				}
+
+				return npos;
+			}
+
+			/// Entry of the k_ key, whose hash is hash_, or nullptr if the key is not on the table.
+			template < typename K >
+			Entry * find_entry( const K & k_, size_t hash_ ) const
+			{
+				size_t pos = find_slot( k_, hash_ );
+				return pos == npos ? nullptr : &m_slots[pos].entry();
+			}
+
+			/// Stores the entry built from args_, for a key whose hash is hash_ and that is known not to be on the table, growing the table first if needed. Returns the new entry.
+			template < typename... Args >
+			Entry & place( size_t hash_, Args &&... args_ )
+			{
+				while( m_count + 1 > static_cast< double >( m_max_load ) * m_size )
+					grow();
+
+				size_t where = robin_hood_insert( m_slots, m_size, m_reduce, Entry( std::forward< Args >( args_ )... ), hash_ );
+				m_count++;
+
+				return m_slots[where].entry();
+			}
+
+			/// Robin Hood insertion of e_, whose key hashes to hash_, into slots_. Returns the slot taken by e_ itself.
+			static size_t robin_hood_insert( Slot * slots_, size_t size_, const Reducer & reduce_, Entry && e_, size_t hash_ )
+			{
+				Entry carry( std::move( e_ ) );
+				carry.set_hash( hash_ );
+				size_t pos = reduce_( hash_ );
+				size_t dist = 1;
+				size_t where = npos;
+
+				while( slots_[pos].dist != 0 )
+				{
+					// The resident is richer (closer to home) than us: take its slot and carry it forward.
+					if( slots_[pos].dist < dist )
+					{
+						std::swap( carry, slots_[pos].entry() );
+						std::swap( dist, slots_[pos].dist );
+						if( where == npos )
+							where = pos;
+					}
+
+					pos = ( pos + 1 == size_ ) ? 0 : pos + 1;
+					dist++;
+				}
+
+				slots_[pos].construct( std::move( carry ), dist );
+
+				return where == npos ? pos : where;
+			}
+
+			/// Copies every entry from other, which must have the same size, keeping their slots.
+			void copy_slots( const HashTbl & other )
+			{
+				for( size_t i = 0 ; i < m_size ; i++ )
+				{
+					if( other.m_slots[i].dist != 0 )
+					{
+						const Entry & e = other.m_slots[i].entry();
+						m_slots[i].construct( Entry( e ), other.m_slots[i].dist );
+					}
+				}
+
+				m_count = other.m_count;
+			}
+
+			/// Number of slots to start with for n_ entries, so that inserting them triggers no rehash.
+			static size_t initial_size( size_t n_ )
+			{ return n_ == 0 ? DEFAULT_SIZE : static_cast< size_t >( std::ceil( n_ / static_cast< double >( MAX_LOAD ) ) ); }
+
+			/// Rehashes at once if the current load is above a new max_load_factor().
+			void refit( void )
+			{
+				if( this->load_factor() > m_max_load )
+					rehash( 0 );
+			}
+
+			/// Fills the shape part of s_, for stats(), by walking every slot: histogram of how many slots past their home the entries sit, longest such distance, empty slots and memory held. Long distances, with a load factor well under max_load_factor(), point to a weak KeyHash.
+			void measure( HashStats & s_ ) const
+			{
+				size_t empty = 0;
+				for( size_t i = 0 ; i < m_size ; i++ )
+				{
+					if( m_slots[i].dist == 0 )
+					{
+						empty++;
+						continue;
+					}
+					count_length( s_.histogram, m_slots[i].dist - 1 );
+					s_.longest = std::max( s_.longest, m_slots[i].dist - 1 );
+				}
+
+				s_.empty_ratio = m_size == 0 ? 0.0 : static_cast< double >( empty ) / m_size;
+				s_.bytes = m_size * sizeof( Slot );
+			}
+
+			/// Shrinks the table, to half of max_load_factor(), when its load fell below min_load_factor().
+			void shrink_if_sparse( void )
+			{
+				if( m_min_load > 0 and m_size > 1 and this->load_factor() < m_min_load )
+					rehash( static_cast< size_t >( std::ceil( 2 * m_count / static_cast< double >( m_max_load ) ) ) );
+			}
+
+			/// Private method called when the load factor would exceed max_load_factor(). Moves every entry to a table with roughly double the size.
+			void grow()
+			{
+				resize( SizePolicy::capacity( m_size == 0 ? 1 : m_size * 2 ) );
+			}
+
+			/// Moves every entry to a new array of new_size_ slots, which must leave at least one slot empty.
+			void resize( size_t new_size_ )
+			{
+				auto timer = this->time_rehash();
+				size_t new_size = new_size_;
+				Reducer new_reduce( new_size );
+				Slot * slots = new_slots( new_size );
+
+				for( size_t i = 0 ; i < m_size ; i++ )
+				{
+					if( m_slots[i].dist != 0 )
+					{
+						Entry & e = m_slots[i].entry();
+						robin_hood_insert( slots, new_size, new_reduce, std::move( e ), hash_of_entry( e ) );
+						m_slots[i].destroy();
+					}
+				}
+
+				delete_slots( m_slots, m_size );
+
+				m_slots = slots;
+				m_size = new_size;
+				m_reduce = new_reduce;
+			}
+
+			Allocator m_alloc; //!< Allocator of the slot array, rebound to Slot.
+			size_t m_size = 0u; //!< Number of slots.
+			Reducer m_reduce; //!< Hash to home slot reduction for m_size.
+			size_t m_count = 0u; //!< Number of elements on the table.
+			Slot * m_slots = nullptr; //!< Flat array of slots.
+			static const short DEFAULT_SIZE = 11;
+			static constexpr size_t PREFETCH_DISTANCE = 8; //!< How many keys ahead retrieve_many() prefetches.
+			float m_max_load = MAX_LOAD; //!< Load factor the table grows past.
+			float m_min_load = 0.0f; //!< Load factor erase() shrinks the table below, 0 for never.
+			static constexpr float MAX_LOAD = 0.875f; //!< Highest allowed maximum load factor, past which probe sequences get long.
+			static const size_t npos = static_cast< size_t >( -1 ); //!< "Not found" slot index.
+
+	}; // HashTbl open addressing specialization
+} // ac Namespace
+#endif
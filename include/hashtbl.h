@@ -3,13 +3,28 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <iterator>
+#include <limits>
 #include <initializer_list>
 #include <math.h>
+#include <cmath>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <forward_list>
+#include <memory>
 #include <functional>
 #include <tuple>
+#include <exception>
 #include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "size_policy.h"
 
 /*! \namespace ac
 	\brief namespace to differ from std.
@@ -17,381 +32,1910 @@
 */
 namespace ac
 {
+	/*! \struct recompute_hash
+		\brief Hash policy: entries only hold their key and data, KeyHash is called again whenever a key's hash is needed (default).
+
+	*/
+	struct recompute_hash {};
+
+	/*! \struct cache_hash
+		\brief Hash policy: every entry also stores the full hash of its key.
+
+		Rehashing reuses the stored hash instead of calling KeyHash, and lookups skip KeyEqual
+		for every entry whose stored hash differs. Worth one size_t per entry when KeyHash or
+		KeyEqual are expensive, e.g. for composite or string keys.
+	*/
+	struct cache_hash {};
+
+	/// Hash stored in a HashEntry: nothing for recompute_hash.
+	template < typename HashPolicy >
+	struct stored_hash
+	{
+		static_assert( std::is_same< HashPolicy, recompute_hash >::value, "unknown HashTbl hash policy" );
+
+		void set_hash( size_t )
+		{  }
+
+		/// Whether the entry may hold a key hashing to hash_. Without a stored hash only KeyEqual can tell.
+		bool same_hash( size_t ) const
+		{ return true; }
+	};
+
+	/// Hash stored in a HashEntry: the full hash for cache_hash.
+	template < >
+	struct stored_hash< cache_hash >
+	{
+		size_t m_hash = 0u; //!< Hash of the entry's key, as used by its table.
+
+		void set_hash( size_t hash_ )
+		{ m_hash = hash_; }
+
+		/// Whether the entry may hold a key hashing to hash_.
+		bool same_hash( size_t hash_ ) const
+		{ return m_hash == hash_; }
+	};
+
 	/*! \class HashEntry
-		\brief List element, containing a Key and a Data variable.
+		\brief List element, containing a Key and a Data variable, plus the key's hash with the cache_hash policy.
 
 	*/
-	template < typename KeyType, typename DataType >
-	class HashEntry
+	template < typename KeyType, typename DataType, typename HashPolicy = recompute_hash >
+	class HashEntry : public stored_hash< HashPolicy >
 	{
 		public:
-			HashEntry ( KeyType k_, DataType d_ ) : m_key( k_ ), m_data( d_ )
+			HashEntry ( const KeyType & k_, const DataType & d_ ) : m_key( k_ ), m_data( d_ )
+			{  }
+
+			/// Builds the key from k_ and the data from args_, forwarding them so temporaries are moved instead of copied.
+			template < typename K, typename... Args,
+					   typename = typename std::enable_if< not std::is_same< typename std::decay< K >::type, HashEntry >::value >::type >
+			explicit HashEntry ( K && k_, Args &&... args_ ) : m_key( std::forward< K >( k_ ) ), m_data( std::forward< Args >( args_ )... )
 			{  }
+
 			KeyType m_key; //!< Variable that stores the Key.
 			DataType m_data; //!< Variable that stores any data.
 	}; // HashEntry Class
 
+	/*! \struct chained_storage
+		\brief Storage policy: separate chaining, one std::forward_list per bucket (default).
+
+	*/
+	struct chained_storage {};
+
+	/*! \struct open_addressing
+		\brief Storage policy: entries live in one flat slot array, probed with Robin Hood linear probing.
+
+	*/
+	struct open_addressing {};
+
+	/*! \struct swiss_table
+		\brief Storage policy: flat slot array plus one control byte per slot, probed a group of slots at a time.
+
+	*/
+	struct swiss_table {};
+
+	/*! \struct cuckoo_table
+		\brief Storage policy: bucketized cuckoo hashing, every key in one of two buckets of 4 slots, so a lookup reads at most two buckets.
+
+	*/
+	struct cuckoo_table {};
+
+	/*! \struct no_stats
+		\brief Stats policy: the table keeps no counters, stats() only reports what it reads from the table itself (default).
+
+	*/
+	struct no_stats {};
+
+	/*! \struct collect_stats
+		\brief Stats policy: the table also counts the hits and misses of retrieve(), retrieve_many() and at(), and the number and duration of its rehashes.
+
+		The counters are relaxed atomics, so readers sharing a table, e.g. under the shared lock
+		of a ConcurrentHashTbl, may bump them at the same time. They belong to the table object:
+		copies and moved-to tables start from zero.
+	*/
+	struct collect_stats {};
+
+	/*! \struct HashStats
+		\brief Shape and counters of a table, as returned by HashTbl::stats().
+
+		For a chained table, histogram[n] is the number of buckets holding n entries. For the
+		flat storages it is the number of entries found n probes past their home: n slots for
+		open_addressing, n groups for swiss_table. For cuckoo_table, entries are counted by where
+		they sit: 0 in their first bucket, 1 in their second one, 2 in the stash. A good hash keeps
+		it short and steep.
+	*/
+	struct HashStats
+	{
+		size_t size = 0u; //!< Number of entries.
+		size_t bucket_count = 0u; //!< Number of buckets, or slots.
+		std::vector< size_t > histogram; //!< Chain lengths, or probe distances, see above.
+		size_t longest = 0u; //!< Longest chain, or longest probe distance.
+		double empty_ratio = 0.0; //!< Fraction of the buckets, or slots, holding no entry.
+		size_t treeified = 0u; //!< Chained tables only: buckets searched through a sorted index, see HashTbl::treeify_buckets().
+		size_t bytes = 0u; //!< Bytes held by the bucket or slot arrays and the chain nodes, allocator overhead excluded.
+		uint64_t rehashes = 0u; //!< Rehashes since construction or reset_stats(). This and the counters below need collect_stats.
+		uint64_t rehash_ns = 0u; //!< Total time spent in those rehashes, in nanoseconds.
+		uint64_t hits = 0u; //!< Lookups that found their key.
+		uint64_t misses = 0u; //!< Lookups that didn't.
+
+	};
+
+	/// Counters of a table: none for no_stats, every call compiles to nothing.
+	template < typename StatsPolicy >
+	struct stats_counters
+	{
+		static_assert( std::is_same< StatsPolicy, no_stats >::value, "unknown HashTbl stats policy" );
+
+		/// Times nothing. The empty destructor only keeps compilers from warning about an unused timer.
+		struct rehash_timer
+		{
+			~rehash_timer()
+			{  }
+		};
+
+		void count_lookups( size_t, size_t ) const
+		{  }
+
+		rehash_timer time_rehash( void ) const
+		{ return {}; }
+
+		void fill_counters( HashStats & ) const
+		{  }
+
+		void reset_counters( void )
+		{  }
+	};
+
+	/// Counters of a table: hits, misses and rehashes for collect_stats.
+	template < >
+	struct stats_counters< collect_stats >
+	{
+		/// Counts one rehash, and the time until it is destroyed.
+		class rehash_timer
+		{
+			public:
+				explicit rehash_timer( const stats_counters & counters_ ) : m_counters( counters_ ), m_start( std::chrono::steady_clock::now() )
+				{  }
+
+				rehash_timer( const rehash_timer & ) = delete;
+				rehash_timer& operator=( const rehash_timer & ) = delete;
+
+				~rehash_timer()
+				{
+					auto ns = std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - m_start ).count();
+					m_counters.m_rehashes.fetch_add( 1, std::memory_order_relaxed );
+					m_counters.m_rehash_ns.fetch_add( static_cast< uint64_t >( ns ), std::memory_order_relaxed );
+				}
+
+			private:
+				const stats_counters & m_counters;
+				std::chrono::steady_clock::time_point m_start;
+		};
+
+		stats_counters() = default;
+
+		/// Copies start from zero, the counters describe one table object.
+		stats_counters( const stats_counters & )
+		{  }
+
+		stats_counters& operator=( const stats_counters & )
+		{ return *this; }
+
+		void count_lookups( size_t hits_, size_t misses_ ) const
+		{
+			if( hits_ != 0 )
+				m_hits.fetch_add( hits_, std::memory_order_relaxed );
+			if( misses_ != 0 )
+				m_misses.fetch_add( misses_, std::memory_order_relaxed );
+		}
+
+		rehash_timer time_rehash( void ) const
+		{ return rehash_timer( *this ); }
+
+		void fill_counters( HashStats & stats_ ) const
+		{
+			stats_.rehashes = m_rehashes.load( std::memory_order_relaxed );
+			stats_.rehash_ns = m_rehash_ns.load( std::memory_order_relaxed );
+			stats_.hits = m_hits.load( std::memory_order_relaxed );
+			stats_.misses = m_misses.load( std::memory_order_relaxed );
+		}
+
+		void reset_counters( void )
+		{
+			m_hits.store( 0, std::memory_order_relaxed );
+			m_misses.store( 0, std::memory_order_relaxed );
+			m_rehashes.store( 0, std::memory_order_relaxed );
+			m_rehash_ns.store( 0, std::memory_order_relaxed );
+		}
+
+		mutable std::atomic< uint64_t > m_hits{ 0 }; //!< Lookups that found their key.
+		mutable std::atomic< uint64_t > m_misses{ 0 }; //!< Lookups that didn't.
+		mutable std::atomic< uint64_t > m_rehashes{ 0 }; //!< Calls to resize().
+		mutable std::atomic< uint64_t > m_rehash_ns{ 0 }; //!< Time spent in them.
+	};
+
+	/// Adds one to histogram_[n_], growing it as needed.
+	inline void count_length( std::vector< size_t > & histogram_, size_t n_ )
+	{
+		if( histogram_.size() <= n_ )
+			histogram_.resize( n_ + 1, 0u );
+		histogram_[n_]++;
+	}
+
+	/// True when KeyHash and KeyEqual both declare is_transparent, so a HashTbl using them can look up keys of type K without building a KeyType.
+	template < typename KeyHash, typename KeyEqual, typename K, typename = void >
+	struct transparent_key : std::false_type {};
+
+	template < typename KeyHash, typename KeyEqual, typename K >
+	struct transparent_key< KeyHash, KeyEqual, K,
+							std::void_t< typename KeyHash::is_transparent, typename KeyEqual::is_transparent > > : std::true_type {};
+
+	/// True when keys of types A and B can be ordered against each other with operator<, as treeified buckets need.
+	template < typename A, typename B, typename = void >
+	struct is_orderable : std::false_type {};
+
+	template < typename A, typename B >
+	struct is_orderable< A, B, std::void_t< decltype( std::declval< const A& >() < std::declval< const B& >() ),
+											decltype( std::declval< const B& >() < std::declval< const A& >() ) > > : std::true_type {};
+
+	/// True when V has the m_key and m_data members of a HashEntry.
+	template < typename V, typename = void >
+	struct is_entry : std::false_type {};
+
+	template < typename V >
+	struct is_entry< V, std::void_t< decltype( std::declval< V& >().m_key ), decltype( std::declval< V& >().m_data ) > > : std::true_type {};
+
+	/// True when V can be a range element: an entry, or a std::pair or std::tuple holding a key and its data.
+	template < typename V, typename = void >
+	struct is_element : is_entry< V > {};
+
+	template < typename V >
+	struct is_element< V, std::void_t< decltype( std::tuple_size< V >::value ) > > : std::integral_constant< bool, ( std::tuple_size< V >::value >= 2 ) > {};
+
+	/// True when It is an iterator over range elements. Pointers to characters, as string literals decay to, are iterators too, so without the element check the range constructor and insert() would be picked for a key and data of the same type.
+	template < typename It, typename = void >
+	struct is_iterator : std::false_type {};
+
+	template < typename It >
+	struct is_iterator< It, std::void_t< typename std::iterator_traits< It >::iterator_category > >
+		: is_element< typename std::iterator_traits< It >::value_type > {};
+
+	/// Enables a range overload for iterators over range elements only.
+	template < typename It >
+	using require_iterator = typename std::enable_if< is_iterator< It >::value >::type;
+
+	/// Number of elements in [first_, last_) if It is a forward iterator, so the table can be sized before inserting them. Single pass iterators can't be walked twice, 0 is returned for them.
+	template < typename It >
+	size_t range_length( It first_, It last_ )
+	{
+		if constexpr ( std::is_base_of< std::forward_iterator_tag, typename std::iterator_traits< It >::iterator_category >::value )
+			return static_cast< size_t >( std::distance( first_, last_ ) );
+		else
+			return 0;
+	}
+
+	/// Asks the CPU to start loading the cache line holding p_, so that reading it later doesn't stall. A no-op on compilers without the builtin.
+	inline void prefetch( const void * p_ )
+	{
+#if defined(__GNUC__) or defined(__clang__)
+		__builtin_prefetch( p_ );
+#else
+		(void) p_;
+#endif
+	}
+
+	/*! \struct string_hash
+		\brief Transparent hash for std::string keys, hashing std::string_view and const char* the same way without building a std::string.
+
+		Use it with std::equal_to<>, e.g. HashTbl< std::string, int, string_hash, std::equal_to<> >.
+	*/
+	struct string_hash
+	{
+		using is_transparent = void;
+
+		size_t operator()( std::string_view s_ ) const
+		{ return std::hash< std::string_view >()( s_ ); }
+	};
+
+	/*! \class table_base
+		\brief Public interface shared by every HashTbl storage, written once over the primitives of the storage.
+
+		Derived is the HashTbl specialization, which befriends this class. Besides its members
+		m_alloc, m_size, m_count, m_max_load and m_min_load, and its highest load factor
+		MAX_LOAD, it provides: hash_of( k ), the hash its lookups use; find_entry( k, hash ), the
+		entry of k or nullptr; place( hash, args... ), which builds the entry of a key known not
+		to be on the table, growing the table if needed, and returns it; refit(), which resizes
+		the table for a new max_load_factor(); measure( stats ), which fills the shape part of
+		HashStats; and swap_contents(). Updates and at() call advance_rehash() first, which
+		only does something for a storage that rehashes incrementally.
+	*/
+	template < typename Derived,
+			   typename KeyType,
+			   typename DataType,
+			   typename KeyHash,
+			   typename KeyEqual,
+			   typename HashPolicy,
+			   typename Allocator,
+			   typename StatsPolicy >
+	class table_base : protected stats_counters< StatsPolicy >
+	{
+		public:
+			using Entry = HashEntry< KeyType, DataType, HashPolicy >; //!< Alias
+			using allocator_type = Allocator; //!< Alias
+
+			/// Enables the lookup overloads for K: always for KeyType itself, for other types only with a transparent KeyHash and KeyEqual.
+			template < typename K >
+			using lookup_key = typename std::enable_if< std::is_same< K, KeyType >::value or transparent_key< KeyHash, KeyEqual, K >::value >::type;
+
+			/// Inserts on the table the information stored in d_ and associated to a k_ key. If the insertion process succeds the method returns true, if the key already exists, the method overwrites it's data with data stored in d_ and then returns false.
+			bool insert ( const KeyType & k_, const DataType & d_ )
+			{ return assign_or_place( k_, d_ ); }
+
+			/// Same as the insert() above, but k_ and d_ are moved into the table instead of copied.
+			bool insert ( KeyType && k_, DataType && d_ )
+			{ return assign_or_place( std::move( k_ ), std::move( d_ ) ); }
+
+			/// Inserts every element of [first_, last_), entries or key/data pairs, as insert() does one by one. With forward iterators the table is grown once, up front, to hold them all.
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			void insert ( InputIt first_, InputIt last_ )
+			{
+				derived().reserve( derived().m_count + range_length( first_, last_ ) );
+
+				for( ; first_ != last_ ; ++first_ )
+					insert_element( *first_ );
+			}
+
+			/// Inserts every entry of ilist, as the range insert() does.
+			void insert ( std::initializer_list < Entry > ilist )
+			{ insert( ilist.begin(), ilist.end() ); }
+
+			/// Associates obj_ to the k_ key. If the key is new, its entry is built from k_ and obj_ and the method returns true; otherwise obj_ is assigned to the existing data and the method returns false.
+			template < typename M >
+			bool insert_or_assign ( const KeyType & k_, M && obj_ )
+			{ return assign_or_place( k_, std::forward< M >( obj_ ) ); }
+
+			/// Same as the insert_or_assign() above, moving k_ into the table if the key is new.
+			template < typename M >
+			bool insert_or_assign ( KeyType && k_, M && obj_ )
+			{ return assign_or_place( std::move( k_ ), std::forward< M >( obj_ ) ); }
+
+			/// If the k_ key is not on the table, builds its entry, the data being constructed from args_, and returns true. Otherwise nothing is constructed, args_ are left untouched and the method returns false.
+			template < typename... Args >
+			bool try_emplace ( const KeyType & k_, Args &&... args_ )
+			{ return place_if_absent( k_, std::forward< Args >( args_ )... ); }
+
+			/// Same as the try_emplace() above, moving k_ into the table if the key is new.
+			template < typename... Args >
+			bool try_emplace ( KeyType && k_, Args &&... args_ )
+			{ return place_if_absent( std::move( k_ ), std::forward< Args >( args_ )... ); }
+
+			/// Builds an entry from args_ (the key, then the data arguments). Returns true if it was inserted, or false if its key was already on the table, in which case the table is unchanged. Since the key is only known once the entry exists, prefer try_emplace() when the key is at hand.
+			template < typename... Args >
+			bool emplace ( Args &&... args_ )
+			{
+				Entry e( std::forward< Args >( args_ )... );
+				size_t hash = derived().hash_of( e.m_key );
+
+				if( derived().find_entry( e.m_key, hash ) != nullptr )
+					return false;
+
+				derived().place( hash, std::move( e ) );
+				return true;
+			}
+
+			/// Inserts d_ for the k_ key if it is new and returns true. Otherwise calls update_( data ) on the existing data and returns false. The key is hashed and looked up only once.
+			template < typename Fn >
+			bool upsert ( const KeyType & k_, const DataType & d_, Fn && update_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( Entry * found = derived().find_entry( k_, hash ) )
+				{
+					update_( found->m_data );
+					return false;
+				}
+
+				derived().place( hash, k_, d_ );
+				return true;
+			}
+
+			/// Calls fn_( data ) on the data of the k_ key, inserting it first with value initialized data if it is new, as ++table[ k_ ] would. Returns true if the key is new.
+			template < typename Fn >
+			bool upsert ( const KeyType & k_, Fn && fn_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( Entry * found = derived().find_entry( k_, hash ) )
+				{
+					fn_( found->m_data );
+					return false;
+				}
+
+				fn_( derived().place( hash, k_ ).m_data );
+				return true;
+			}
+
+			/// Calls fn_( data ) on the data of the k_ key, if it is on the table. Returns true if it was.
+			template < typename Fn >
+			bool compute_if_present ( const KeyType & k_, Fn && fn_ )
+			{
+				derived().advance_rehash();
+				Entry * found = derived().find_entry( k_, derived().hash_of( k_ ) );
+
+				if( found == nullptr )
+					return false;
+
+				fn_( found->m_data );
+				return true;
+			}
+
+			/// Inserts the k_ key with fn_() as its data if it is new, and returns true. Otherwise returns false, without calling fn_.
+			template < typename Fn >
+			bool compute_if_absent ( const KeyType & k_, Fn && fn_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( derived().find_entry( k_, hash ) != nullptr )
+					return false;
+
+				derived().place( hash, k_, fn_() );
+				return true;
+			}
+
+			/// Exchanges the contents of this table and other, without copying any entry. Allocators are swapped if they propagate on swap, and must be equal otherwise, as for the standard containers.
+			void swap ( Derived & other ) noexcept
+			{
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_swap::value )
+				{
+					using std::swap;
+					swap( derived().m_alloc, other.m_alloc );
+				}
+				derived().swap_contents( other );
+			}
+
+			/// Exchanges the contents of two tables.
+			friend void swap ( Derived & lhs, Derived & rhs ) noexcept
+			{ lhs.swap( rhs ); }
+
+			/// Returns a copy of the allocator.
+			allocator_type get_allocator( void ) const
+			{ return derived().m_alloc; }
+
+			/// Retrieves in d_ the information associated with the key k_. If the key is found, the method returns true, otherwise it returns false.
+			bool retrieve ( const KeyType & k_, DataType & d_ ) const
+			{ return retrieve< KeyType >( k_, d_ ); }
+
+			/// Same as the retrieve() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool retrieve ( const K & k_, DataType & d_ ) const
+			{
+				const Entry * found = derived().find_entry( k_, derived().hash_of( k_ ) );
+				this->count_lookups( found != nullptr, found == nullptr );
+
+				if( found == nullptr )
+					return false;
+
+				d_ = found->m_data;
+				return true;
+			}
+
+			/// Returns true if the Hashtable is empty, returns false otherwise.
+			bool empty ( void ) const
+			{ return derived().m_count == 0; }
+
+			/// Returns the number of elements stored in the Hashtable.
+			size_t size( void ) const
+			{ return derived().m_count; }
+
+			/// Returns the number of buckets: the bucket lists of chained_storage, the slots of the other storages, the stash of cuckoo_table left out.
+			size_t bucket_count( void ) const
+			{ return derived().m_size; }
+
+			/// Returns size() over bucket_count(): the average chain length, or the fraction of slots holding an entry.
+			float load_factor( void ) const
+			{ return derived().m_size == 0 ? 0.0f : static_cast< float >( derived().m_count ) / derived().m_size; }
+
+			/// Returns the load factor the table grows past: 1 by default for chained_storage, the highest one allowed for the other storages.
+			float max_load_factor( void ) const
+			{ return derived().m_max_load; }
+
+			/// Sets the load factor the table grows past, and resizes the table for it. Values below 1/16, zero, negative or NaN are raised to 1/16. Values above the highest one the storage allows are lowered to it: 7/8 for open_addressing and swiss_table, past which probe sequences get long, and 0.95 for cuckoo_table, past which displacement paths often fail.
+			void max_load_factor( float ml_ )
+			{
+				if( not ( ml_ >= MIN_LOAD ) )
+					ml_ = MIN_LOAD;
+				derived().m_max_load = std::min( ml_, Derived::MAX_LOAD );
+				derived().m_min_load = std::min( derived().m_min_load, derived().m_max_load / 4 );
+				derived().refit();
+			}
+
+			/// Returns the load factor below which erase() shrinks the table, 0 (never) by default.
+			float min_load_factor( void ) const
+			{ return derived().m_min_load; }
+
+			/// Sets the load factor below which erase() shrinks the table, so that its load becomes at most half of max_load_factor(). Capped at a quarter of max_load_factor(), so a shrink is never followed right away by another one.
+			void min_load_factor( float ml_ )
+			{
+				derived().m_min_load = std::min( ml_, derived().m_max_load / 4 );
+				derived().shrink_if_sparse();
+			}
+
+			/// Shrinks the table to the smallest size holding size() entries under max_load_factor(), e.g. to give memory back after clear(), which keeps it.
+			void shrink_to_fit( void )
+			{ derived().rehash( 0 ); }
+
+			/// Returns the shape of the table, measured now by walking it: see the measure() of each storage for what its histogram counts. The counters are only filled with the collect_stats policy.
+			HashStats stats( void ) const
+			{
+				HashStats s;
+				derived().measure( s );
+				s.size = derived().m_count;
+				s.bucket_count = derived().m_size;
+				this->fill_counters( s );
+				return s;
+			}
+
+			/// Zeroes the hit, miss and rehash counters of the collect_stats policy.
+			void reset_stats( void )
+			{ this->reset_counters(); }
+
+			/// Returns a reference to the data associated to the k_ key, if the key is not on the table the method throws an std::out_of_range exception.
+			DataType& at ( const KeyType& k_ )
+			{ return at< KeyType >( k_ ); }
+
+			/// Same as the at() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			DataType& at ( const K& k_ )
+			{
+				derived().advance_rehash();
+				Entry * found = derived().find_entry( k_, derived().hash_of( k_ ) );
+				this->count_lookups( found != nullptr, found == nullptr );
+
+				if( found == nullptr )
+					throw std::out_of_range("out of range, bro");
+
+				return found->m_data;
+			}
+
+			/// Returns a reference to the data associated to the k_ key. If the key is not on the table the method inserts it, with value-initialized data, and returns a reference to it. The key is hashed and searched only once.
+			DataType& operator[]( const KeyType& k_ )
+			{ return find_or_place( k_ ); }
+
+			/// Same as the operator[] above, moving k_ into the table if the key is new.
+			DataType& operator[]( KeyType&& k_ )
+			{ return find_or_place( std::move( k_ ) ); }
+
+			/// Returns a const_iterator to the first entry, or cend() if the table is empty.
+			auto cbegin( void ) const
+			{ return derived().begin(); }
+
+			/// Returns the past-the-end const_iterator.
+			auto cend( void ) const
+			{ return derived().end(); }
+
+			/// Calls fn_( key, data ) on every entry, in iteration order. The data may be modified, the key may not.
+			template < typename Fn >
+			void for_each( Fn && fn_ )
+			{
+				for( Entry & e : derived() )
+					fn_( std::as_const( e.m_key ), e.m_data );
+			}
+
+			/// Calls fn_( key, data ) on every entry, in iteration order.
+			template < typename Fn >
+			void for_each( Fn && fn_ ) const
+			{
+				for( const Entry & e : derived() )
+					fn_( e.m_key, e.m_data );
+			}
+
+		protected:
+			table_base( void ) = default;
+
+			/// Move assignment of Derived, once self assignment is ruled out. The entries of this table are destroyed and other_ is left empty. Other's storage is taken over when the allocator propagates, together with other's allocator, or when both allocators are equal; otherwise its entries are moved one by one into memory from this table's allocator.
+			void move_assign( Derived & other_ )
+			{
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_move_assignment::value )
+				{
+					// The allocators are exchanged even without propagate_on_container_swap, so that moved frees the old entries with the allocator that made them.
+					using std::swap;
+					Derived moved( std::move( other_ ) );
+					swap( derived().m_alloc, moved.m_alloc );
+					derived().swap_contents( moved );
+				}
+				else if( derived().m_alloc == other_.m_alloc )
+				{
+					Derived moved( std::move( other_ ) );
+					derived().swap_contents( moved );
+				}
+				else
+				{
+					derived().clear();
+					for( Entry & e : other_ )
+						derived().emplace( std::move( e.m_key ), std::move( e.m_data ) );
+					other_.clear();
+				}
+			}
+
+			/// Moves some buckets of an incremental rehash before an update. Storages that rehash at once have nothing to do.
+			void advance_rehash( void )
+			{  }
+
+		private:
+			static constexpr float MIN_LOAD = 0.0625f; //!< Lowest allowed maximum load factor.
+
+			Derived & derived( void )
+			{ return static_cast< Derived & >( *this ); }
+
+			const Derived & derived( void ) const
+			{ return static_cast< const Derived & >( *this ); }
+
+			/// Assigns obj_ to the data of the k_ key, or places a new entry built from both. Returns true if the entry is new.
+			template < typename K, typename M >
+			bool assign_or_place( K && k_, M && obj_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( Entry * found = derived().find_entry( k_, hash ) )
+				{
+					found->m_data = std::forward< M >( obj_ );
+					return false;
+				}
+
+				derived().place( hash, std::forward< K >( k_ ), std::forward< M >( obj_ ) );
+				return true;
+			}
+
+			/// Places a new entry built from k_ and args_ unless the k_ key is already there. Returns true if the entry is new.
+			template < typename K, typename... Args >
+			bool place_if_absent( K && k_, Args &&... args_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( derived().find_entry( k_, hash ) != nullptr )
+					return false;
+
+				derived().place( hash, std::forward< K >( k_ ), std::forward< Args >( args_ )... );
+				return true;
+			}
+
+			/// Returns the data of the k_ key, placing it with value-initialized data first if it is new. The reference stays valid across the rehash place() may trigger.
+			template < typename K >
+			DataType& find_or_place( K && k_ )
+			{
+				derived().advance_rehash();
+				size_t hash = derived().hash_of( k_ );
+
+				if( Entry * found = derived().find_entry( k_, hash ) )
+					return found->m_data;
+
+				return derived().place( hash, std::forward< K >( k_ ) ).m_data;
+			}
+
+			/// Inserts a range element: an entry, or a std::pair or std::tuple holding a key and its data. Members of an rvalue element are moved.
+			template < typename V >
+			void insert_element( V && v_ )
+			{
+				if constexpr ( is_entry< typename std::decay< V >::type >::value )
+					insert_or_assign( std::forward< V >( v_ ).m_key, std::forward< V >( v_ ).m_data );
+				else
+					insert_or_assign( std::get< 0 >( std::forward< V >( v_ ) ), std::get< 1 >( std::forward< V >( v_ ) ) );
+			}
+	};
+
 	template < typename KeyType,
 			   typename DataType,
 			   typename KeyHash = std::hash<KeyType>,
-			   typename KeyEqual = std::equal_to<KeyType> >
-	class HashTbl
+			   typename KeyEqual = std::equal_to<KeyType>,
+			   typename StoragePolicy = chained_storage,
+			   typename SizePolicy = prime_size,
+			   typename HashPolicy = recompute_hash,
+			   typename Allocator = std::allocator< HashEntry< KeyType, DataType, HashPolicy > >,
+			   typename StatsPolicy = no_stats >
+	class HashTbl : public table_base< HashTbl< KeyType, DataType, KeyHash, KeyEqual, StoragePolicy, SizePolicy, HashPolicy, Allocator, StatsPolicy >,
+									   KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >
 	{
+		static_assert( std::is_same< StoragePolicy, chained_storage >::value,
+					   "unknown HashTbl storage policy" );
+
+		using Base = table_base< HashTbl, KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >; //!< Shared interface, built on the primitives below.
+		friend Base;
+
+		using EntryAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< HashEntry< KeyType, DataType, HashPolicy > >;
+		using Bucket = std::forward_list< HashEntry< KeyType, DataType, HashPolicy >, EntryAlloc >; //!< One bucket, its nodes come from the table's allocator.
+		using BucketAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Bucket >;
+		using BucketTraits = std::allocator_traits< BucketAlloc >;
+		using Index = std::vector< HashEntry< KeyType, DataType, HashPolicy >*,
+								   typename std::allocator_traits< Allocator >::template rebind_alloc< HashEntry< KeyType, DataType, HashPolicy >* > >; //!< Entries of a long bucket, sorted by key.
+		using IndexAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Index >;
+		using IndexTraits = std::allocator_traits< IndexAlloc >;
+
 		public:
-			using Entry = HashEntry< KeyType, DataType >; //!< Alias
+			using Entry = typename Base::Entry; //!< Alias
+
+			static constexpr size_t PARALLEL_MIN = 1 << 14; //!< Smallest bucket array, or range, that parallel_rehash() and the parallel range constructor split between threads.
+
+			template < typename K >
+			using lookup_key = typename Base::template lookup_key< K >; //!< Alias
+
+			/*! \class basic_iterator
+				\brief Forward iterator over the entries, bucket by bucket; during an incremental rehash the old buckets not moved yet come last.
+
+				Any insertion may rehash the table and invalidate every iterator; erasing invalidates the erased entry's.
+				During an incremental rehash, every operation that moves old buckets invalidates them too.
+			*/
+			template < bool Const >
+			class basic_iterator
+			{
+				friend class HashTbl;
+				friend class basic_iterator< not Const >;
+
+				using Table = typename std::conditional< Const, const HashTbl, HashTbl >::type;
+				using ListIt = typename std::conditional< Const, typename Bucket::const_iterator, typename Bucket::iterator >::type;
+
+				public:
+					using iterator_category = std::forward_iterator_tag;
+					using value_type = Entry;
+					using difference_type = std::ptrdiff_t;
+					using pointer = typename std::conditional< Const, const Entry *, Entry * >::type;
+					using reference = typename std::conditional< Const, const Entry &, Entry & >::type;
+
+					basic_iterator( void ) = default;
+
+					/// An iterator converts to a const_iterator.
+					template < bool C, typename = typename std::enable_if< Const and not C >::type >
+					basic_iterator( const basic_iterator< C > & other ) : m_tbl( other.m_tbl ), m_bucket( other.m_bucket ), m_it( other.m_it )
+					{  }
+
+					reference operator*( void ) const
+					{ return *m_it; }
+
+					pointer operator->( void ) const
+					{ return &*m_it; }
+
+					basic_iterator& operator++( void )
+					{
+						++m_it;
+						skip_empty();
+						return *this;
+					}
+
+					basic_iterator operator++( int )
+					{
+						basic_iterator old( *this );
+						++( *this );
+						return old;
+					}
+
+					template < bool C >
+					bool operator==( const basic_iterator< C > & other ) const
+					{ return m_bucket == other.m_bucket and ( m_bucket == END or m_it == other.m_it ); }
+
+					template < bool C >
+					bool operator!=( const basic_iterator< C > & other ) const
+					{ return not ( *this == other ); }
+
+				private:
+					static constexpr size_t END = static_cast< size_t >( -1 ); //!< Bucket index of the past-the-end iterator.
+
+					basic_iterator( Table * tbl_, size_t bucket_, ListIt it_ ) : m_tbl( tbl_ ), m_bucket( bucket_ ), m_it( it_ )
+					{  }
+
+					/// Moves to the first entry at or after the current position, or to the end.
+					void skip_empty( void )
+					{
+						while( m_it == m_tbl->bucket( m_bucket ).end() )
+						{
+							if( ++m_bucket == m_tbl->bucket_total() )
+							{
+								m_bucket = END;
+								m_it = ListIt();
+								return;
+							}
+							m_it = m_tbl->bucket( m_bucket ).begin();
+						}
+					}
+
+					Table * m_tbl = nullptr;
+					size_t m_bucket = END; //!< Bucket index, as numbered by HashTbl::bucket().
+					ListIt m_it;
+			};
+
+			using iterator = basic_iterator< false >; //!< Alias
+			using const_iterator = basic_iterator< true >; //!< Alias
 			
 			//== Constructors
-			/// Constructor with a defined size.
-			HashTbl( size_t tbl_size_ = DEFAULT_SIZE )
+			/// Constructor with a defined size. Nodes and bucket arrays come from alloc_.
+			HashTbl( size_t tbl_size_ = DEFAULT_SIZE, const Allocator & alloc_ = Allocator() ) : m_alloc( alloc_ )
 			{
-				tbl_size_ = next_prime( tbl_size_ );
+				tbl_size_ = SizePolicy::capacity( tbl_size_ );
 				
 				m_size = tbl_size_;
+				m_reduce = Reducer( m_size );
 				m_count = 0;
 	
-				m_data_table = new std::forward_list< Entry >[tbl_size_];
+				m_data_table = new_buckets( tbl_size_ );
 			}
+
+			/// Constructor with the default size and an allocator.
+			explicit HashTbl( const Allocator & alloc_ ) : HashTbl( DEFAULT_SIZE, alloc_ )
+			{  }
 			
 			/// Default destructor.
 			virtual ~HashTbl()
 			{
-				delete [] m_data_table;
+				delete_indexes();
+				delete_buckets( m_data_table, m_size );
+				delete_buckets( m_old_table, m_old_size );
 			}
 	
-			/// Copy constructor.
+			/// Copy constructor. The allocator is obtained as for the standard containers, from select_on_container_copy_construction().
 			HashTbl( const HashTbl& other )
+				: m_alloc( std::allocator_traits< Allocator >::select_on_container_copy_construction( other.m_alloc ) )
 			{
-				m_data_table = new std::forward_list< Entry >[ other.m_size ];
-	
-				m_size = other.m_size;
-				m_count = other.m_count;
-	
-				for( size_t i = 0 ; i < m_size ; i++ )
-				{
-					auto otherIt = other.m_data_table[i].begin();
-	
-					while( otherIt != other.m_data_table[i].end() )
-					{
-						m_data_table[i].push_front( *otherIt );
-						otherIt++;
-					}
-				}
+				copy_from( other );
 	
-				if( ( m_count / m_size ) >= 1.0 )
+				if( needs_rehash() )
 					rehash();
 			}
+
+			/// Move constructor. Takes over the buckets and the allocator of other, which is left empty and without buckets until its next insertion.
+			HashTbl( HashTbl&& other ) noexcept : m_alloc( other.m_alloc )
+			{
+				swap_contents( other );
+			}
 			
-			/// std::initializer_list copy constructor.
-			HashTbl( std::initializer_list < Entry > ilist )
+			/// Range constructor: builds the table from [first_, last_), whose elements are entries or key/data pairs. With forward iterators the range is counted first and the bucket array allocated once, at its final size. A key appearing twice keeps its last data, as with insert().
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			HashTbl( InputIt first_, InputIt last_, const Allocator & alloc_ = Allocator() )
+				: HashTbl( initial_size( range_length( first_, last_ ) ), alloc_ )
 			{
-				m_size = DEFAULT_SIZE;
-				m_data_table = new std::forward_list< Entry >[ m_size ];
-	
-				for( const Entry & e : ilist )
-				{
-					insert( e.m_key, e.m_data );
-				}
-	
-				if( ( m_count / m_size ) >= 1.0 )
-					rehash();
+				this->insert( first_, last_ );
 			}
+
+			/// Same as the range constructor above, but the entries are built and linked into their buckets by threads_ threads, the way parallel_rehash() moves them, with the same result as the serial build. Falls back to the serial build for single pass iterators, for fewer than PARALLEL_MIN elements, or for threads_ below 2. The allocator must be safe to call from several threads at once, as std::allocator is; KeyHash and KeyEqual must not throw.
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			HashTbl( InputIt first_, InputIt last_, size_t threads_, const Allocator & alloc_ = Allocator() )
+				: HashTbl( initial_size( range_length( first_, last_ ) ), alloc_ )
+			{
+				size_t n = range_length( first_, last_ );
+
+				if( threads_ < 2 or n < PARALLEL_MIN )
+					this->insert( first_, last_ );
+				else
+					parallel_build( first_, n, threads_ );
+			}
+
+			/// std::initializer_list copy constructor.
+			HashTbl( std::initializer_list < Entry > ilist, const Allocator & alloc_ = Allocator() )
+				: HashTbl( ilist.begin(), ilist.end(), alloc_ )
+			{  }
 			
 			//=== Operators
 			/// Operator = overload for HashTbl objects.
 			HashTbl& operator=( const HashTbl & other )
 			{
+				if( this == &other )
+					return *this;
+
 				clear();
-				delete [] m_data_table;
-				m_data_table = new std::forward_list< Entry >[ other.m_size ];
-	
-				m_size = other.m_size;
-				m_count = other.m_count;
-	
-				for( size_t i = 0 ; i < m_size ; i++ )
-				{
-					auto otherIt = other.m_data_table[i].begin();
-	
-					while( otherIt != other.m_data_table[i].end() )
-					{
-						m_data_table[i].push_front( *otherIt );
-						otherIt++;
-					}
-				}
+				delete_buckets( m_data_table, m_size );
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_copy_assignment::value )
+					m_alloc = other.m_alloc;
+				copy_from( other );
 	
-				if( ( m_count / m_size ) >= 1.0 )
+				if( needs_rehash() )
 					rehash();
 	
 				return *this;
 			}
+
+			/// Move assignment, see table_base::move_assign().
+			HashTbl& operator=( HashTbl && other )
+				noexcept( std::allocator_traits< Allocator >::propagate_on_container_move_assignment::value )
+			{
+				if( this != &other )
+					this->move_assign( other );
+				return *this;
+			}
 			
 			/// Operator = overload for std::initializer_list
 			HashTbl& operator=( std::initializer_list < Entry > ilist )
 			{
 				clear();
-				delete [] m_data_table;
+				delete_buckets( m_data_table, m_size );
 	
-				m_size = ilist.size();
-				m_data_table = new std::forward_list< Entry >[ m_size ];
+				m_size = SizePolicy::capacity( initial_size( ilist.size() ) );
+				m_reduce = Reducer( m_size );
+				m_data_table = new_buckets( m_size );
 				m_count = 0;
 	
-					for( const Entry & e : ilist )
+				this->insert( ilist.begin(), ilist.end() );
+	
+				return *this;
+			}
+	
+			//=== Methods
+			/// Same as table_base::emplace(), but the entry is built in place, in a node which is then linked into its bucket.
+			template < typename... Args >
+			bool emplace ( Args &&... args_ )
+			{
+				KeyHash hashFunc;
+				migrate( m_rehash_step );
+	
+				// Built in a detached node, which is spliced into its bucket if the key is new.
+				Bucket node{ EntryAlloc( m_alloc ) };
+				node.emplace_front( std::forward< Args >( args_ )... );
+	
+				size_t hash = hashFunc( node.front().m_key );
+				if( find_entry( node.front().m_key, hash ) != nullptr )
+					return false;
+				node.front().set_hash( hash );
+	
+				if( m_size == 0 )
+					rehash();
+	
+				size_t b = m_reduce( hash );
+				m_data_table[b].splice_after( m_data_table[b].before_begin(), node );
+				m_count++;
+				linked( b, m_data_table[b].front() );
+	
+				if( needs_rehash() )
+					rehash();
+	
+				return true;
+			}
+
+			/// Removes from the table an item identified by its k_ key. If the key is found, this method returns true, otherwise it returns false.
+			bool erase ( const KeyType & k_ )
+			{ return erase< KeyType >( k_ ); }
+
+			/// Same as the erase() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool erase ( const K & k_ )
+			{
+				KeyHash hashFunc;
+				migrate( m_rehash_step );
+	
+				if( m_size == 0 )
+					return false;
+	
+				size_t hash = hashFunc( k_ );
+				size_t b = m_reduce( hash );
+				bool erased = false;
+				if( not indexed( b ) )
+					erased = erase_from( m_data_table[b], k_, hash );
+				else if constexpr ( is_orderable< KeyType, K >::value )
+					erased = erase_indexed( b, k_ );
+				else
+					erased = erase_scanned( b, k_, hash );
+	
+				if( not erased and m_old_table != nullptr )
 				{
-					insert( e.m_key, e.m_data );
+					size_t old = m_old_reduce( hash );
+					if( old >= m_migrated )
+						erased = erase_from( m_old_table[old], k_, hash );
 				}
 	
-				if( ( m_count / m_size ) >= 1.0 )
-					rehash();
+				if( erased )
+					shrink_if_sparse();
 	
-				return *this;
+				return erased;
 			}
 	
-			//=== Methods
-			/// Inserts on the table the information stored in d_ and associated to a k_ key. If the insertion process succeds the method returns true, if the key already exists, the method overwrites it's data with data stored in d_ and then returns false.
-			bool insert ( const KeyType & k_, const DataType & d_ )
+			/// Looks up the n_ keys of keys_ in one go. Keys are hashed and their bucket prefetched 2 * PREFETCH_DISTANCE keys ahead of the one being searched, then the first node of that bucket PREFETCH_DISTANCE keys ahead, so the cache misses of successive keys overlap instead of being paid one after the other. For each keys_[i] found, its data is copied to data_[i]; found_[i], unless found_ is nullptr, tells whether keys_[i] was found. Returns the number of keys found.
+			size_t retrieve_many ( const KeyType * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{ return retrieve_many< KeyType >( keys_, n_, data_, found_ ); }
+
+			/// Same as the retrieve_many() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t retrieve_many ( const K * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{
+				const size_t ring = 2 * PREFETCH_DISTANCE;
+				KeyHash hashFunc;
+				size_t hashes[ ring ];
+				size_t buckets[ ring ];
+				size_t found = 0;
+
+				if( m_count == 0 )
+				{
+					if( found_ != nullptr )
+						std::fill( found_, found_ + n_, false );
+					this->count_lookups( 0, n_ );
+					return 0;
+				}
+
+				auto prefetch_bucket = [&]( size_t j_ )
+				{
+					size_t r = j_ % ring;
+					hashes[r] = hashFunc( keys_[j_] );
+					buckets[r] = m_reduce( hashes[r] );
+					prefetch( &m_data_table[ buckets[r] ] );
+				};
+
+				auto prefetch_node = [&]( size_t j_ )
+				{
+					const Bucket & bucket = m_data_table[ buckets[ j_ % ring ] ];
+					if( not bucket.empty() )
+						prefetch( &bucket.front() );
+				};
+
+				for( size_t j = 0 ; j < ring and j < n_ ; j++ )
+					prefetch_bucket( j );
+				for( size_t j = 0 ; j < PREFETCH_DISTANCE and j < n_ ; j++ )
+					prefetch_node( j );
+
+				for( size_t i = 0 ; i < n_ ; i++ )
+				{
+					size_t r = i % ring;
+					Entry * e = find_entry_from( keys_[i], hashes[r], buckets[r] );
+					if( e != nullptr )
+					{
+						data_[i] = e->m_data;
+						found++;
+					}
+					if( found_ != nullptr )
+						found_[i] = ( e != nullptr );
+
+					if( i + PREFETCH_DISTANCE < n_ )
+						prefetch_node( i + PREFETCH_DISTANCE );
+					if( i + ring < n_ )
+						prefetch_bucket( i + ring );
+				}
+
+				this->count_lookups( found, n_ - found );
+				return found;
+			}
+	
+			/// Clears all memory associated to the Hashtable's lists, removing all it's elements.
+			void clear ( void )
+			{
+				m_count = 0;
+				delete_indexes();
+				for( size_t i = 0 ; i < m_size ; i++ )
+					m_data_table[i].clear();
+	
+				delete_buckets( m_old_table, m_old_size );
+				m_old_table = nullptr;
+			}
+	
+			/// Returns the number of elemets from the hashtable that are on the list associated to the k_ key. While an incremental rehash is running, the key's old bucket is counted too if it wasn't moved yet.
+			size_t count( const KeyType& k_ ) const
+			{ return count< KeyType >( k_ ); }
+
+			/// Same as the count() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t count( const K& k_ ) const
+			{
+				KeyHash hashFunc;
+	
+				if( m_size == 0 )
+					return 0;
+	
+				size_t hash = hashFunc( k_ );
+				size_t counter = std::distance( m_data_table[ m_reduce( hash ) ].begin(), m_data_table[ m_reduce( hash ) ].end() );
+	
+				if( m_old_table != nullptr and m_old_reduce( hash ) >= m_migrated )
+					counter += std::distance( m_old_table[ m_old_reduce( hash ) ].begin(), m_old_table[ m_old_reduce( hash ) ].end() );
+	
+				return counter;
+			}
+	
+			/// Spreads every future rehash over the following operations: the new bucket array is allocated at once, but insert(), erase(), at() and operator[] each move at most buckets_per_op_ of the old buckets into it, and lookups check both arrays meanwhile. Zero, the default, moves the whole table at once.
+			void incremental_rehash( size_t buckets_per_op_ )
+			{
+				m_rehash_step = buckets_per_op_;
+				if( m_rehash_step == 0 )
+					finish_rehash();
+			}
+	
+			/// Spreads every future rehash of the whole table over threads_ threads. Each one first sorts the entries of its share of the old buckets by the share of the new buckets they go to, then links the entries sorted for its own share into their buckets. No bucket is touched by two threads, so nothing is locked, and the entries end up in the same order as with a serial rehash. Tables with fewer than PARALLEL_MIN buckets, incremental rehashes, and threads_ of 0 or 1, the default, rehash on the calling thread. KeyHash must not throw.
+			void parallel_rehash( size_t threads_ )
+			{ m_rehash_threads = threads_; }
+
+			/// Bounds the cost of long chains: once a bucket holds more than threshold_ entries, it gets an index of its entries sorted by key, and lookups, insertions and erasures in it binary search the index instead of scanning the chain. The index is dropped when the chain shrinks to half of threshold_. Zero, the default, never indexes a bucket. Meant for weak or adversarial hashes, 8 is a good threshold. Keys must be ordered by operator<, consistently with KeyEqual: keys it calls equal must be equivalent. Indexes are rebuilt after each rehash, and buckets are scanned while an incremental rehash runs.
+			void treeify_buckets( size_t threshold_ )
+			{
+				static_assert( is_orderable< KeyType, KeyType >::value, "treeify_buckets() needs keys ordered by operator<" );
+				m_treeify = threshold_;
+				delete_indexes();
+				index_long_chains();
+			}
+
+			/// Returns true while an incremental rehash still has old buckets to move.
+			bool rehashing( void ) const
+			{ return m_old_table != nullptr; }
+
+			/// Sets the number of buckets to SizePolicy::capacity() of n_, or of the number needed to keep size() entries under max_load_factor() if that is larger. Shrinks the table if that is less than bucket_count().
+			void rehash( size_t n_ )
+			{
+				size_t needed = static_cast< size_t >( std::ceil( m_count / static_cast< double >( m_max_load ) ) );
+				size_t new_size = SizePolicy::capacity( std::max< size_t >( { n_, needed, 1 } ) );
+
+				if( new_size != m_size )
+					resize( new_size );
+			}
+
+			/// Makes room for n_ entries, so inserting up to n_ entries triggers no rehash.
+			void reserve( size_t n_ )
+			{
+				size_t needed = static_cast< size_t >( std::ceil( n_ / static_cast< double >( m_max_load ) ) );
+				if( needed > m_size )
+					rehash( needed );
+			}
+
+			/// Returns an iterator to the first entry, or end() if the table is empty.
+			iterator begin( void )
+			{ return first< iterator >( this ); }
+
+			/// Returns the past-the-end iterator.
+			iterator end( void )
+			{ return iterator(); }
+
+			/// Returns a const_iterator to the first entry, or end() if the table is empty.
+			const_iterator begin( void ) const
+			{ return first< const_iterator >( this ); }
+
+			/// Returns the past-the-end const_iterator.
+			const_iterator end( void ) const
+			{ return const_iterator(); }
+
+			/// Returns an iterator to the entry of the k_ key, or end() if the key is not on the table.
+			iterator find( const KeyType & k_ )
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			iterator find( const K & k_ )
+			{
+				migrate( m_rehash_step );
+				return locate< iterator >( this, k_ );
+			}
+
+			/// Returns a const_iterator to the entry of the k_ key, or end() if the key is not on the table.
+			const_iterator find( const KeyType & k_ ) const
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			const_iterator find( const K & k_ ) const
+			{ return locate< const_iterator >( this, k_ ); }
+
+			/// A depuration method used to generate a textual representation of the hashtable and it's elements.
+			friend std::ostream& operator<< ( std::ostream & os, const HashTbl & tbl )
+			{
+				for( size_t i = 0 ; i < tbl.m_size ; i++ )
+				{
+					os << "[" << i << "]";
+					for(auto it = tbl.m_data_table[i].begin(); it != tbl.m_data_table[i].end(); it++)
+					{
+						os << " -> " << it->m_data;
+					}
+					os << std::endl;
+				}
+				return os;
+			}
+	
+		private:
+			using Reducer = typename SizePolicy::reducer; //!< Maps hashes to buckets for the current size.
+
+			/// Hash of k_ as KeyHash gives it, used as is to pick buckets.
+			template < typename K >
+			static size_t hash_of( const K & k_ )
+			{ return KeyHash()( k_ ); }
+
+			/// Returns the entry associated to the k_ key, whose hash is hash_, or nullptr if there is none. Also searches the old bucket array during an incremental rehash.
+			template < typename K >
+			Entry * find_entry( const K & k_, size_t hash_ ) const
+			{
+				if( m_size == 0 )
+					return nullptr;
+	
+				return find_entry_from( k_, hash_, m_reduce( hash_ ) );
+			}
+
+			/// Same as find_entry(), for a key whose bucket_ in the current array is also known. The table must have buckets.
+			template < typename K >
+			Entry * find_entry_from( const K & k_, size_t hash_, size_t bucket_ ) const
 			{
-				KeyHash hashFunc;
 				KeyEqual equalFunc;
-				Entry new_entry( k_, d_ );
-	
-				auto end = hashFunc( k_ ) % m_size;
+
+				if constexpr ( is_orderable< KeyType, K >::value )
+					if( indexed( bucket_ ) )
+						return find_indexed( bucket_, k_ );
 	
-				auto it = m_data_table[end].begin();
+				for( Entry & e : m_data_table[ bucket_ ] )
+					if( e.same_hash( hash_ ) and equalFunc( e.m_key, k_ ) )
+						return &e;
 	
-				while( it != m_data_table[end].end() )
+				if( m_old_table != nullptr )
 				{
-					if( equalFunc( it->m_key, new_entry.m_key ) )
-					{
-						it->m_data = d_;
-						return false;
-					}
-	
-					it++;
+					size_t old = m_old_reduce( hash_ );
+					if( old >= m_migrated )
+						for( Entry & e : m_old_table[old] )
+							if( e.same_hash( hash_ ) and equalFunc( e.m_key, k_ ) )
+								return &e;
 				}
 	
-				m_data_table[end].push_front( new_entry );
+				return nullptr;
+			}
+	
+			/// Builds a new entry from args_ at the front of the bucket of hash_, whose key must not be on the table yet, and grows the table if needed. The returned entry stays valid across the rehash, since nodes are relinked rather than copied.
+			template < typename... Args >
+			Entry & place( size_t hash_, Args &&... args_ )
+			{
+				if( m_size == 0 )
+					rehash();
+	
+				size_t b = m_reduce( hash_ );
+				m_data_table[b].emplace_front( std::forward< Args >( args_ )... );
+				Entry & placed = m_data_table[b].front();
+				placed.set_hash( hash_ );
 				m_count++;
+				linked( b, placed );
 	
-				if( ( m_count / m_size ) >= 1.0 )
+				if( needs_rehash() )
 					rehash();
 	
-				return true;
+				return placed;
 			}
+	
+			/// Moves m_rehash_step buckets of an incremental rehash, before an update or at().
+			void advance_rehash( void )
+			{ migrate( m_rehash_step ); }
 
-			/// Removes from the table an item identified by its k_ key. If the key is found, this method returns true, otherwise it returns false.
-			bool erase ( const KeyType & k_ )
+			/// Rehashes at once if the current load is above a new max_load_factor().
+			void refit( void )
+			{
+				if( this->load_factor() > m_max_load )
+					rehash( 0 );
+			}
+
+			/// Fills the shape part of s_, for stats(), by walking every bucket: chain length histogram, longest chain, empty buckets and memory held. During an incremental rehash the old buckets not moved yet are walked too. A long longest chain, or a histogram whose tail doesn't fall off fast, points to a weak KeyHash.
+			void measure( HashStats & s_ ) const
+			{
+				struct Node { void * next; Entry entry; }; // Layout of a std::forward_list node.
+
+				size_t empty = 0;
+				for( size_t b = 0 ; b < bucket_total() ; b++ )
+				{
+					size_t length = static_cast< size_t >( std::distance( bucket( b ).begin(), bucket( b ).end() ) );
+					count_length( s_.histogram, length );
+					empty += ( length == 0 );
+					s_.longest = std::max( s_.longest, length );
+				}
+
+				s_.empty_ratio = bucket_total() == 0 ? 0.0 : static_cast< double >( empty ) / bucket_total();
+				s_.bytes = ( m_size + ( m_old_table != nullptr ? m_old_size : 0 ) ) * sizeof( Bucket ) + m_count * sizeof( Node );
+				s_.treeified = m_indexed;
+				if( m_indexes != nullptr )
+				{
+					s_.bytes += m_size * sizeof( Index );
+					for( size_t b = 0 ; b < m_size ; b++ )
+						s_.bytes += m_indexes[b].capacity() * sizeof( Entry* );
+				}
+			}
+
+			/// True when the table has no bucket or its load factor went over max_load_factor().
+			bool needs_rehash( void ) const
+			{ return m_size == 0 or m_count > static_cast< double >( m_max_load ) * m_size; }
+
+			/// Number of buckets to start with for n_ entries, so that inserting them triggers no rehash.
+			static size_t initial_size( size_t n_ )
+			{ return n_ == 0 ? DEFAULT_SIZE : n_; }
+
+			/// Shrinks the table, to half of max_load_factor(), when its load fell below min_load_factor().
+			void shrink_if_sparse( void )
+			{
+				if( m_min_load > 0 and m_size > 1 and this->load_factor() < m_min_load )
+					rehash( static_cast< size_t >( std::ceil( 2 * m_count / static_cast< double >( m_max_load ) ) ) );
+			}
+	
+			/// Buckets holding entries: the current array, then, during an incremental rehash, the old buckets not moved yet.
+			size_t bucket_total( void ) const
+			{ return m_size + ( m_old_table != nullptr ? m_old_size - m_migrated : 0 ); }
+
+			/// Bucket b_ in the numbering of bucket_total().
+			Bucket & bucket( size_t b_ )
+			{ return b_ < m_size ? m_data_table[b_] : m_old_table[ m_migrated + b_ - m_size ]; }
+
+			const Bucket & bucket( size_t b_ ) const
+			{ return b_ < m_size ? m_data_table[b_] : m_old_table[ m_migrated + b_ - m_size ]; }
+
+			/// Iterator to the first entry of tbl_, or the end.
+			template < typename It, typename Table >
+			static It first( Table * tbl_ )
+			{
+				if( tbl_->m_count == 0 )
+					return It();
+
+				It it( tbl_, 0, tbl_->bucket( 0 ).begin() );
+				it.skip_empty();
+				return it;
+			}
+
+			/// Iterator to the entry of the k_ key on tbl_, or the end. Same search as find_entry().
+			template < typename It, typename Table, typename K >
+			static It locate( Table * tbl_, const K & k_ )
 			{
 				KeyHash hashFunc;
 				KeyEqual equalFunc;
+
+				if( tbl_->m_size == 0 )
+					return It();
+
+				size_t hash = hashFunc( k_ );
+				size_t b = tbl_->m_reduce( hash );
+
+				// An indexed bucket finds the entry with one key comparison per level, then the chain is walked by address for its iterator.
+				if constexpr ( is_orderable< KeyType, K >::value )
+					if( tbl_->indexed( b ) )
+					{
+						Entry * found = tbl_->find_indexed( b, k_ );
+						for( auto it = tbl_->bucket( b ).begin() ; found != nullptr ; ++it )
+							if( &*it == found )
+								return It( tbl_, b, it );
+						return It();
+					}
+
+				for( auto it = tbl_->bucket( b ).begin() ; it != tbl_->bucket( b ).end() ; ++it )
+					if( it->same_hash( hash ) and equalFunc( it->m_key, k_ ) )
+						return It( tbl_, b, it );
+
+				if( tbl_->m_old_table != nullptr and tbl_->m_old_reduce( hash ) >= tbl_->m_migrated )
+				{
+					b = tbl_->m_size + tbl_->m_old_reduce( hash ) - tbl_->m_migrated;
+					for( auto it = tbl_->bucket( b ).begin() ; it != tbl_->bucket( b ).end() ; ++it )
+						if( it->same_hash( hash ) and equalFunc( it->m_key, k_ ) )
+							return It( tbl_, b, it );
+				}
+
+				return It();
+			}
+
+			/// Hash of the key of e_: the stored one with cache_hash, otherwise KeyHash is called again.
+			static size_t hash_of_entry( const Entry & e_ )
+			{
+				if constexpr ( std::is_same< HashPolicy, cache_hash >::value )
+					return e_.m_hash;
+				else
+					return KeyHash()( e_.m_key );
+			}
+
+			/// Removes the k_ key, whose hash is hash_, from the bucket list. Returns true if it was there.
+			template < typename K >
+			bool erase_from( Bucket & bucket_, const K & k_, size_t hash_ )
+			{
+				KeyEqual equalFunc;
 	
-				auto end = hashFunc( k_ ) % m_size;
-	
-				auto it = m_data_table[end].begin();
-				auto first = it;
+				auto it = bucket_.begin();
+				auto prev = bucket_.before_begin();
 	
-				while( it != m_data_table[end].end() )
+				while( it != bucket_.end() )
 				{
-					if( equalFunc( it->m_key, k_ ) )
+					if( it->same_hash( hash_ ) and equalFunc( it->m_key, k_ ) )
 					{	
-						if(it == first)
-							m_data_table[end].pop_front();
-						else
-							m_data_table[end].erase_after(first);
+						bucket_.erase_after(prev);
 						m_count--;
 						return true;
 					}
 	
+					prev = it;
 					it++;
-					if(not (first == it))
-						first++;
 				}
 	
 				return false;
 			}
 	
-			/// Retrieves in d_ the information associated with the key k_. If the key is found, the method returns true, otherwise it returns false.
-			bool retrieve ( const KeyType & k_, DataType & d_ ) const
+			/// Exchanges everything but the allocators. Both must be equal, or their buckets be exchanged back before any allocation.
+			void swap_contents ( HashTbl & other ) noexcept
+			{
+				std::swap( m_size, other.m_size );
+				std::swap( m_reduce, other.m_reduce );
+				std::swap( m_count, other.m_count );
+				std::swap( m_data_table, other.m_data_table );
+				std::swap( m_old_table, other.m_old_table );
+				std::swap( m_old_size, other.m_old_size );
+				std::swap( m_old_reduce, other.m_old_reduce );
+				std::swap( m_migrated, other.m_migrated );
+				std::swap( m_rehash_step, other.m_rehash_step );
+				std::swap( m_rehash_threads, other.m_rehash_threads );
+				std::swap( m_treeify, other.m_treeify );
+				std::swap( m_indexes, other.m_indexes );
+				std::swap( m_indexed, other.m_indexed );
+				std::swap( m_max_load, other.m_max_load );
+				std::swap( m_min_load, other.m_min_load );
+			}
+
+			/// True when bucket b_ of the current array is searched through its index.
+			bool indexed( size_t b_ ) const
+			{ return m_indexes != nullptr and not m_indexes[b_].empty(); }
+
+			/// Orders an entry of an index against a key of type K.
+			struct by_key
+			{
+				template < typename K >
+				bool operator()( const Entry * e_, const K & k_ ) const
+				{ return e_->m_key < k_; }
+			};
+
+			/// Orders the entries of an index by key.
+			struct by_entry_key
+			{
+				bool operator()( const Entry * a_, const Entry * b_ ) const
+				{ return a_->m_key < b_->m_key; }
+			};
+
+			/// Binary searches the index of bucket b_ for the k_ key. Returns its entry, or nullptr.
+			template < typename K >
+			Entry * find_indexed( size_t b_, const K & k_ ) const
+			{
+				const Index & index = m_indexes[b_];
+				auto it = std::lower_bound( index.begin(), index.end(), k_, by_key() );
+
+				if( it == index.end() or not KeyEqual()( ( *it )->m_key, k_ ) )
+					return nullptr;
+				return *it;
+			}
+
+			/// Removes the k_ key from the indexed bucket b_. The entry is found in the index, then the chain is walked by address to unlink it, without comparing keys. Drops the index once the chain shrinks to half of m_treeify. Returns true if the key was there.
+			template < typename K >
+			bool erase_indexed( size_t b_, const K & k_ )
+			{
+				Index & index = m_indexes[b_];
+				auto it = std::lower_bound( index.begin(), index.end(), k_, by_key() );
+
+				if( it == index.end() or not KeyEqual()( ( *it )->m_key, k_ ) )
+					return false;
+
+				Entry * target = *it;
+				index.erase( it );
+				Bucket & bucket = m_data_table[b_];
+				auto prev = bucket.before_begin();
+				while( &*std::next( prev ) != target )
+					++prev;
+				bucket.erase_after( prev );
+				m_count--;
+
+				if( index.size() <= m_treeify / 2 )
+					unindex( b_ );
+				return true;
+			}
+
+			/// Removes the k_ key, whose hash is hash_, from the indexed bucket b_, for a K that can't be ordered against KeyType: the chain is scanned for the key, then its entry is dropped from the index by address. Drops the index once the chain shrinks to half of m_treeify. Returns true if the key was there.
+			template < typename K >
+			bool erase_scanned( size_t b_, const K & k_, size_t hash_ )
 			{
-				KeyHash hashFunc;
 				KeyEqual equalFunc;
-	
-				auto end = hashFunc( k_ ) % m_size;
-				
-				auto it = m_data_table[end].begin();
-	
-				while( it != m_data_table[end].end() )
+				Bucket & bucket = m_data_table[b_];
+				auto prev = bucket.before_begin();
+
+				for( auto it = bucket.begin() ; it != bucket.end() ; prev = it++ )
 				{
-					if(equalFunc( it->m_key, k_) )
+					if( it->same_hash( hash_ ) and equalFunc( it->m_key, k_ ) )
 					{
-						d_ = it->m_data;
+						Index & index = m_indexes[b_];
+						index.erase( std::find( index.begin(), index.end(), &*it ) );
+						bucket.erase_after( prev );
+						m_count--;
+
+						if( index.size() <= m_treeify / 2 )
+							unindex( b_ );
 						return true;
 					}
-	
-					it++;
 				}
-	
+
 				return false;
 			}
-	
-			/// Clears all memory associated to the Hashtable's lists, removing all it's elements.
-			void clear ( void )
+
+			/// Keeps bucket b_ searchable after e_ was linked into it: e_ is added to the bucket's index, or the bucket is indexed if its chain just outgrew m_treeify.
+			void linked( size_t b_, Entry & e_ )
 			{
-				m_count = 0;
+				if constexpr ( is_orderable< KeyType, KeyType >::value )
+				{
+					if( m_treeify == 0 or m_old_table != nullptr )
+						return;
+
+					if( indexed( b_ ) )
+					{
+						Index & index = m_indexes[b_];
+						index.insert( std::lower_bound( index.begin(), index.end(), &e_, by_entry_key() ), &e_ );
+					}
+					else if( longer_than( m_data_table[b_], m_treeify ) )
+						index_bucket( b_ );
+				}
+				else
+					(void) e_;
+			}
+
+			/// True when bucket_ holds more than n_ entries. Walks at most n_ + 1 nodes.
+			static bool longer_than( const Bucket & bucket_, size_t n_ )
+			{
+				size_t length = 0;
+				for( auto it = bucket_.begin() ; it != bucket_.end() and length <= n_ ; ++it )
+					length++;
+				return length > n_;
+			}
+
+			/// Indexes every bucket of the current array longer than m_treeify. Called once the buckets are all in place: after a rehash, a copy or a change of threshold.
+			void index_long_chains( void )
+			{
+				if constexpr ( is_orderable< KeyType, KeyType >::value )
+				{
+					if( m_treeify == 0 or m_old_table != nullptr )
+						return;
+
+					for( size_t b = 0 ; b < m_size ; b++ )
+						if( not indexed( b ) and longer_than( m_data_table[b], m_treeify ) )
+							index_bucket( b );
+				}
+			}
+
+			/// Builds the index of bucket b_, allocating the index array first if no bucket had one.
+			void index_bucket( size_t b_ )
+			{
+				if( m_indexes == nullptr )
+				{
+					IndexAlloc alloc( m_alloc );
+					m_indexes = IndexTraits::allocate( alloc, m_size );
+					for( size_t i = 0 ; i < m_size ; i++ )
+						::new ( static_cast< void* >( m_indexes + i ) ) Index( typename Index::allocator_type( m_alloc ) );
+				}
+
+				Index & index = m_indexes[b_];
+				for( Entry & e : m_data_table[b_] )
+					index.push_back( &e );
+				std::sort( index.begin(), index.end(), by_entry_key() );
+				m_indexed++;
+			}
+
+			/// Drops the index of bucket b_, whose chain is scanned again. The index array is freed with the last index.
+			void unindex( size_t b_ )
+			{
+				m_indexes[b_].clear();
+				m_indexes[b_].shrink_to_fit();
+				if( --m_indexed == 0 )
+					delete_indexes();
+			}
+
+			/// Frees every index, e.g. before the buckets are rehashed. The threshold is kept.
+			void delete_indexes( void )
+			{
+				if( m_indexes == nullptr )
+					return;
+
+				IndexAlloc alloc( m_alloc );
 				for( size_t i = 0 ; i < m_size ; i++ )
-					m_data_table[i].clear();
+					m_indexes[i].~Index();
+				IndexTraits::deallocate( alloc, m_indexes, m_size );
+				m_indexes = nullptr;
+				m_indexed = 0;
 			}
-	
-			/// Returns true if the Hashtable is empty, returns false otherwise.
-			bool empty ( void ) const
-			{ return m_count == 0; }
-	
-			/// Returns the number of elements stored in the Hashtable.
-			size_t size( void ) const
-			{ return m_count; }
-	
-			/// Returns a reference to the data associated to the k_ key, if the key is not on the table the method throws an std::out_of_range exception.
-			DataType& at ( const KeyType& k_ )
+
+			/// Allocates n_ empty buckets, all using the table's allocator, or returns nullptr if n_ is zero.
+			Bucket * new_buckets( size_t n_ )
 			{
-				KeyHash hashFunc;
-				KeyEqual equalFunc;
+				if( n_ == 0 )
+					return nullptr;
+
+				BucketAlloc alloc( m_alloc );
+				Bucket * buckets = BucketTraits::allocate( alloc, n_ );
+				for( size_t i = 0 ; i < n_ ; i++ )
+					::new ( static_cast< void* >( buckets + i ) ) Bucket( EntryAlloc( m_alloc ) );
+				return buckets;
+			}
+
+			/// Destroys the n_ buckets of buckets_, with their entries, and frees the array. Does nothing for nullptr.
+			void delete_buckets( Bucket * buckets_, size_t n_ )
+			{
+				if( buckets_ == nullptr )
+					return;
+
+				BucketAlloc alloc( m_alloc );
+				for( size_t i = 0 ; i < n_ ; i++ )
+					buckets_[i].~Bucket();
+				BucketTraits::deallocate( alloc, buckets_, n_ );
+			}
+
+			/// Makes this table an independent copy of other, without any rehash in progress.
+			void copy_from( const HashTbl & other )
+			{
+				m_data_table = new_buckets( other.m_size );
 	
-				auto end = hashFunc( k_ ) % m_size;
-				
-				auto it = m_data_table[end].begin();
+				m_size = other.m_size;
+				m_reduce = other.m_reduce;
+				m_count = other.m_count;
+				m_rehash_step = other.m_rehash_step;
+				m_rehash_threads = other.m_rehash_threads;
+				m_treeify = other.m_treeify;
+				m_max_load = other.m_max_load;
+				m_min_load = other.m_min_load;
 	
-				while( it != m_data_table[end].end() )
+				for( size_t i = 0 ; i < m_size ; i++ )
 				{
-					if(equalFunc( it->m_key, k_) )
+					auto otherIt = other.m_data_table[i].begin();
+	
+					while( otherIt != other.m_data_table[i].end() )
 					{
-						return it->m_data;
+						m_data_table[i].push_front( *otherIt );
+						otherIt++;
 					}
-	
-					it++;
 				}
-				
-				throw std::out_of_range("out of range, bro");
+	
+				// Entries other didn't move yet go straight to their bucket in the new array.
+				if( other.m_old_table != nullptr )
+					for( size_t i = other.m_migrated ; i < other.m_old_size ; i++ )
+						for( const Entry & e : other.m_old_table[i] )
+							m_data_table[ m_reduce( hash_of_entry( e ) ) ].push_front( e );
+
+				index_long_chains();
 			}
 	
-			/// Returns a reference to the data associated to the k_ key. If the key is not on the table the method inserts it and returns a reference to it.
-			DataType& operator[]( const KeyType& k_ )
+			/// Private method to be called when the hashtable's load factor reached max_load_factor(). Resizes the table to the SizePolicy capacity of double its size.
+			void rehash()
 			{
-				KeyHash hashFunc;
-				KeyEqual equalFunc;
+				resize( SizePolicy::capacity( m_size == 0 ? 1 : m_size * 2 ) );
+			}
+
+			/// Creates a new bucket array with new_size_ buckets. Then every list node is relinked into its new bucket, according to the new table's size, so no entry is copied and no node is allocated. In incremental mode the old array is kept and its buckets are moved a few at a time by later operations.
+			void resize( size_t new_size_ )
+			{
+				auto timer = this->time_rehash();
+				finish_rehash();
+				delete_indexes();
 	
-				auto end = hashFunc( k_ ) % m_size;
-				
-				auto it = m_data_table[end].begin();
+				size_t new_size = new_size_;
 	
-				while( it != m_data_table[end].end() )
-				{
-					if(equalFunc( it->m_key, k_) )
-					{
-						return it->m_data;
-					}
+				m_old_table = m_data_table;
+				m_old_size = m_size;
+				m_old_reduce = m_reduce;
+				m_migrated = 0;
 	
-					it++;
-				}
-				
+				m_data_table = new_buckets( new_size );
+				m_size = new_size;
+				m_reduce = Reducer( new_size );
 	
-				DataType new_data = {0};
-				insert( k_, new_data);
-				auto it2 = m_data_table[end].begin();
-				return it2->m_data; 
+				if( m_old_size == 0 )
+				{
+					delete_buckets( m_old_table, m_old_size );
+					m_old_table = nullptr;
+					index_long_chains();
+				}
+				else if( m_rehash_step == 0 )
+					finish_rehash();
 			}
 	
-			/// Returns the number of elemets from the hashtable that are on the list associated to the k_ key.
-			size_t count( const KeyType& k_ ) const
+			/// Moves up to buckets_ buckets of the old array into the current one. The old array is freed once it is empty.
+			void migrate( size_t buckets_ )
 			{
-				KeyHash hashFunc;
-	
-				auto end = hashFunc( k_ ) % m_size;			
-				auto it = m_data_table[end].begin();
+				for( ; buckets_ > 0 and m_old_table != nullptr ; buckets_-- )
+				{
+					Bucket & bucket = m_old_table[ m_migrated ];
 	
-				size_t counter = 0u;
+					while( not bucket.empty() )
+					{
+						auto end = m_reduce( hash_of_entry( bucket.front() ) );
+						// Moves the first node of the old bucket to the front of the new one.
+						m_data_table[end].splice_after( m_data_table[end].before_begin(), bucket, bucket.before_begin() );
+					}
 	
-				while( it != m_data_table[end].end() )
-				{
-					counter++;
-					it++;
+					if( ++m_migrated == m_old_size )
+					{
+						delete_buckets( m_old_table, m_old_size );
+						m_old_table = nullptr;
+						index_long_chains();
+					}
 				}
+			}
 	
-				return counter;
+			/// Moves whatever is left of the old bucket array, on m_rehash_threads threads if it is large enough.
+			void finish_rehash( void )
+			{
+				if( m_old_table == nullptr )
+					return;
+
+				if( m_rehash_threads > 1 and m_old_size - m_migrated >= PARALLEL_MIN )
+					parallel_migrate();
+				else
+					migrate( m_old_size - m_migrated );
 			}
 
-			/// A depuration method used to generate a textual representation of the hashtable and it's elements.
-			friend std::ostream& operator<< ( std::ostream & os, const HashTbl & tbl )
+			/// Same as finish_rehash(), on m_rehash_threads threads. Thread t moves the nodes of its share of the old buckets, in order, to the back of staging[ t * threads + p ], p being the share of the new buckets each node goes to. Then thread p links the nodes staged for its share, see link_staged().
+			void parallel_migrate( void )
 			{
-				for(int i=0; i<tbl.prime_size; i++)
-				{
-					os << "[" << i << "]";
-					for(auto it = tbl.m_data_table[i].begin(); it != tbl.m_data_table[i].end(); it++)
+				size_t threads = m_rehash_threads;
+				size_t first = m_migrated, left = m_old_size - m_migrated;
+				std::vector< Bucket > staging = new_lists( threads * threads );
+
+				run_parallel( threads, [&]( size_t t_ ){
+					std::vector< typename Bucket::iterator > tails;
+					for( size_t p = 0 ; p < threads ; p++ )
+						tails.push_back( staging[ t_ * threads + p ].before_begin() );
+
+					for( size_t i = first + share_begin( t_, left, threads ) ; i < first + share_begin( t_ + 1, left, threads ) ; i++ )
 					{
-						os << " -> " << it->m_data;
+						Bucket & bucket = m_old_table[i];
+
+						while( not bucket.empty() )
+						{
+							size_t p = share_of( m_reduce( hash_of_entry( bucket.front() ) ), m_size, threads );
+							staging[ t_ * threads + p ].splice_after( tails[p], bucket, bucket.before_begin() );
+							++tails[p];
+						}
 					}
-					os << std::endl;
+				} );
+
+				run_parallel( threads, [&]( size_t p_ ){ link_staged( staging, threads, p_, true ); } );
+
+				m_migrated = m_old_size;
+				delete_buckets( m_old_table, m_old_size );
+				m_old_table = nullptr;
+				index_long_chains();
+			}
+
+			/// Builds the entries of the n_ elements from first_ on threads_ threads, into a table sized for them. Thread t builds the entries of its share of the elements and stages them as parallel_migrate() does, then link_staged() inserts them.
+			template < typename It >
+			void parallel_build( It first_, size_t n_, size_t threads_ )
+			{
+				std::vector< It > starts;
+				for( size_t t = 0 ; t < threads_ ; t++ )
+				{
+					starts.push_back( first_ );
+					std::advance( first_, share_begin( t + 1, n_, threads_ ) - share_begin( t, n_, threads_ ) );
 				}
-				return os;
+
+				std::vector< Bucket > staging = new_lists( threads_ * threads_ );
+				std::vector< Bucket > pending = new_lists( threads_ );
+
+				run_parallel( threads_, [&]( size_t t_ ){
+					KeyHash hashFunc;
+					std::vector< typename Bucket::iterator > tails;
+					for( size_t p = 0 ; p < threads_ ; p++ )
+						tails.push_back( staging[ t_ * threads_ + p ].before_begin() );
+
+					It it = starts[t_];
+					for( size_t i = share_begin( t_, n_, threads_ ) ; i < share_begin( t_ + 1, n_, threads_ ) ; i++, ++it )
+					{
+						Bucket & built = pending[t_];
+						emplace_element( built, *it );
+
+						size_t hash = hashFunc( built.front().m_key );
+						built.front().set_hash( hash );
+
+						size_t p = share_of( m_reduce( hash ), m_size, threads_ );
+						staging[ t_ * threads_ + p ].splice_after( tails[p], built, built.before_begin() );
+						++tails[p];
+					}
+				} );
+
+				std::vector< size_t > added( threads_ );
+				run_parallel( threads_, [&]( size_t p_ ){ added[p_] = link_staged( staging, threads_, p_, false ); } );
+
+				for( size_t a : added )
+					m_count += a;
 			}
-	
-		private:
-			/// Private method to be called when the hashtable's load factor is greater than 1. It creates a new hashtable whose size will be equal to the smallest prime number equal or greater than double the size of the table before rehash was called. Then all the elements will be inserted on the new table according to a new secondary hash funcion, based on the new table's size.
-			void rehash()
+
+			/// Moves the nodes staged for share p_ of the buckets, from staging_[ t * threads_ + p_ ] for every t in order, to the front of their buckets, exactly as a serial rehash or insertion loop would. Unless unique_ is set, a staged key already in its bucket assigns its data to that entry instead, as insert_or_assign() does. Returns the number of nodes linked.
+			size_t link_staged( std::vector< Bucket > & staging_, size_t threads_, size_t p_, bool unique_ )
 			{
-				KeyHash hashFunc;
-	
-				size_t m_count_backup = m_count;
-				size_t new_size = next_prime(m_size*2);
-				if( m_size == 0)
-					new_size = next_prime(1);
-	
-				std::forward_list<Entry> * new_data_table = new std::forward_list< Entry >[ new_size ];
-	
-				for( size_t i = 0u; i < m_size ; i++ )
+				KeyEqual equalFunc;
+				size_t linked = 0;
+
+				for( size_t t = 0 ; t < threads_ ; t++ )
 				{
-					auto it = m_data_table[i].begin();
-					while( it != m_data_table[i].end() )
+					Bucket & staged = staging_[ t * threads_ + p_ ];
+
+					while( not staged.empty() )
 					{
-						Entry new_entry( it->m_key, it->m_data );
-						auto end = hashFunc( it->m_key ) % new_size;
-						new_data_table[end].push_front( new_entry );
-						it++;
+						Entry & e = staged.front();
+						size_t hash = hash_of_entry( e );
+						Bucket & bucket = m_data_table[ m_reduce( hash ) ];
+
+						if( not unique_ )
+						{
+							auto same = std::find_if( bucket.begin(), bucket.end(), [&]( const Entry & other_ )
+									{ return other_.same_hash( hash ) and equalFunc( other_.m_key, e.m_key ); } );
+
+							if( same != bucket.end() )
+							{
+								same->m_data = std::move( e.m_data );
+								staged.pop_front();
+								continue;
+							}
+						}
+
+						bucket.splice_after( bucket.before_begin(), staged, staged.before_begin() );
+						linked++;
 					}
 				}
-	
-				clear();
-				delete [] m_data_table;
-				
-				m_data_table = new_data_table;
-	
-				m_size = new_size;
-				m_count = m_count_backup;
+
+				return linked;
 			}
-			
-			size_t m_size = 0u; //!< Table's size.
-			size_t m_count = 0u; //!< Number of elements on the table.
-			std::forward_list< Entry > * m_data_table; //!< Data structure used as basis to the table.
-			static const short DEFAULT_SIZE = 11;
 
-	
-			/// Function used to find the first prime equal or greater than the size given to build the hashtable.
-			size_t next_prime( size_t num )
+			/// Builds, at the front of list_, the entry of a range element: an entry, or a std::pair or std::tuple holding a key and its data. Members of an rvalue element are moved.
+			template < typename V >
+			static void emplace_element( Bucket & list_, V && v_ )
 			{
-				if( num == 0 or num == 1)
-					return num;
-	
-				while( true )
+				if constexpr ( is_entry< typename std::decay< V >::type >::value )
+					list_.emplace_front( std::forward< V >( v_ ).m_key, std::forward< V >( v_ ).m_data );
+				else
+					list_.emplace_front( std::get< 0 >( std::forward< V >( v_ ) ), std::get< 1 >( std::forward< V >( v_ ) ) );
+			}
+
+			/// n_ empty lists using the table's allocator, for staging nodes.
+			std::vector< Bucket > new_lists( size_t n_ ) const
+			{
+				std::vector< Bucket > lists;
+				lists.reserve( n_ );
+				for( size_t i = 0 ; i < n_ ; i++ )
+					lists.emplace_back( EntryAlloc( m_alloc ) );
+				return lists;
+			}
+
+			/// Runs fn_( i ) for every i below threads_, each on a thread of its own but the last, which runs on the calling thread. A part whose thread can't be started runs on the calling thread too. Rethrows the first exception thrown by a part, once every part is done.
+			template < typename Fn >
+			static void run_parallel( size_t threads_, Fn && fn_ )
+			{
+				std::vector< std::exception_ptr > errors( threads_ );
+				auto part = [&]( size_t i_ ){
+					try { fn_( i_ ); }
+					catch( ... ) { errors[i_] = std::current_exception(); }
+				};
+
+				std::vector< std::thread > workers;
+				workers.reserve( threads_ );
+				for( size_t i = 0 ; i + 1 < threads_ ; i++ )
 				{
-					int numdiv = 0;
-					for( size_t i = 2 ; i <= (size_t)sqrt(num) ; i++ )
-						if( num % i == 0 )
-							numdiv++;
-	
-					if( numdiv == 0 )
-						return num;
-					else
-						num++;
+					try { workers.emplace_back( part, i ); }
+					catch( const std::system_error & ) { part( i ); }
 				}
+				part( threads_ - 1 );
+
+				for( auto & w : workers )
+					w.join();
+				for( auto & e : errors )
+					if( e )
+						std::rethrow_exception( e );
 			}
+
+			/// First of the n_ items handled by part i_, when they are split in parts_ contiguous parts.
+			static size_t share_begin( size_t i_, size_t n_, size_t parts_ )
+			{ return i_ * n_ / parts_; }
+
+			/// Part handling item i_, when n_ items are split in parts_ contiguous parts.
+			static size_t share_of( size_t i_, size_t n_, size_t parts_ )
+			{ return i_ * parts_ / n_; }
+			
+			Allocator m_alloc; //!< Allocator of the nodes and bucket arrays, rebound as needed.
+			size_t m_size = 0u; //!< Table's size.
+			Reducer m_reduce; //!< Hash to bucket reduction for m_size.
+			size_t m_count = 0u; //!< Number of elements on the table.
+			Bucket * m_data_table = nullptr; //!< Data structure used as basis to the table.
+			Bucket * m_old_table = nullptr; //!< Bucket array being emptied by an incremental rehash, or nullptr.
+			size_t m_old_size = 0u; //!< Size of m_old_table.
+			Reducer m_old_reduce; //!< Hash to bucket reduction for m_old_size.
+			size_t m_migrated = 0u; //!< Old buckets below this index were already moved.
+			size_t m_rehash_step = 0u; //!< Old buckets moved per operation, 0 for all at once.
+			size_t m_rehash_threads = 0u; //!< Threads moving the buckets of a whole table rehash, 0 or 1 for the calling thread only.
+			size_t m_treeify = 0u; //!< Chain length past which a bucket is indexed, 0 for never.
+			Index * m_indexes = nullptr; //!< One index per bucket, empty for the scanned ones, or nullptr when no bucket is indexed. Always nullptr during an incremental rehash.
+			size_t m_indexed = 0u; //!< Number of indexed buckets.
+			float m_max_load = 1.0f; //!< Load factor the table grows past.
+			static constexpr float MAX_LOAD = std::numeric_limits< float >::max(); //!< Chains have no highest load factor.
+			float m_min_load = 0.0f; //!< Load factor erase() shrinks the table below, 0 for never.
+			static const short DEFAULT_SIZE = 11;
+			static constexpr size_t PREFETCH_DISTANCE = 8; //!< How many keys ahead retrieve_many() prefetches.
 	
 }; // HashTbl class
 } // ac Namespace
+
+#include "flat_hashtbl.h"
+#include "swiss_hashtbl.h"
+#include "cuckoo_hashtbl.h"
+
 #endif
@@ -0,0 +1,172 @@
+#ifndef KEY_HASH_H
+#define KEY_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "size_policy.h"
+
+/*! \file key_hash.h
+	\brief Hashing of composite keys: a wyhash style byte hash for strings, and a functor that folds every member of a tuple or pair into one hash.
+
+	The members are hashed in order, each one seeded with the hash of the members before it,
+	so ( 1, 2 ) and ( 2, 1 ), or ( "a", "bc" ) and ( "ab", "c" ), hash apart. Integers are
+	mixed with one 64 x 64 -> 128 bit multiplication, strings with one per 16 bytes. Hashes
+	are meant for tables in memory: they depend on the byte order and may change between
+	versions, so they should not be stored.
+*/
+namespace ac
+{
+	inline constexpr uint64_t HASH_SEED = 0x9e3779b97f4a7c15ULL; //!< Seed of composite_hash and of hash_bytes() by default.
+	inline constexpr uint64_t WY_P0 = 0xa0761d6478bd642fULL; //!< Mixing constants of wyhash.
+	inline constexpr uint64_t WY_P1 = 0xe7037ed1a0b428dbULL; //!< Mixing constants of wyhash.
+	inline constexpr uint64_t WY_P2 = 0x8ebc6af09c88c6e3ULL; //!< Mixing constants of wyhash.
+	inline constexpr uint64_t WY_P3 = 0x589965cc75374cc3ULL; //!< Mixing constants of wyhash.
+
+	/// Both halves of the 128-bit product a_ * b_, folded with xor. Every input bit reaches the result, which is the mixing step of wyhash.
+	inline uint64_t mum( uint64_t a_, uint64_t b_ )
+	{ return mul_high( a_, b_ ) ^ ( a_ * b_ ); }
+
+	/// 8 bytes from p_, in the machine's byte order.
+	inline uint64_t read64( const unsigned char * p_ )
+	{
+		uint64_t v;
+		std::memcpy( &v, p_, sizeof( v ) );
+		return v;
+	}
+
+	/// 4 bytes from p_, in the machine's byte order.
+	inline uint64_t read32( const unsigned char * p_ )
+	{
+		uint32_t v;
+		std::memcpy( &v, p_, sizeof( v ) );
+		return v;
+	}
+
+	/// Hashes the n_ bytes from p_, starting from seed_, the way wyhash does: up to 16 bytes are read as two overlapping words and mixed once, longer inputs take one mum() per 16 bytes, on three independent lanes past 48 bytes.
+	inline uint64_t hash_bytes( const void * p_, size_t n_, uint64_t seed_ = HASH_SEED )
+	{
+		const unsigned char * p = static_cast< const unsigned char* >( p_ );
+		uint64_t a = 0, b = 0;
+		seed_ ^= mum( seed_ ^ WY_P0, WY_P1 );
+
+		if( n_ <= 16 )
+		{
+			if( n_ >= 4 )
+			{
+				size_t mid = ( n_ >> 3 ) << 2;
+				a = ( read32( p ) << 32 ) | read32( p + mid );
+				b = ( read32( p + n_ - 4 ) << 32 ) | read32( p + n_ - 4 - mid );
+			}
+			else if( n_ > 0 )
+				a = ( static_cast< uint64_t >( p[0] ) << 16 ) | ( static_cast< uint64_t >( p[ n_ >> 1 ] ) << 8 ) | p[ n_ - 1 ];
+		}
+		else
+		{
+			size_t left = n_;
+			if( left > 48 )
+			{
+				uint64_t lane1 = seed_, lane2 = seed_;
+				do
+				{
+					seed_ = mum( read64( p ) ^ WY_P1, read64( p + 8 ) ^ seed_ );
+					lane1 = mum( read64( p + 16 ) ^ WY_P2, read64( p + 24 ) ^ lane1 );
+					lane2 = mum( read64( p + 32 ) ^ WY_P3, read64( p + 40 ) ^ lane2 );
+					p += 48;
+					left -= 48;
+				} while( left > 48 );
+				seed_ ^= lane1 ^ lane2;
+			}
+
+			while( left > 16 )
+			{
+				seed_ = mum( read64( p ) ^ WY_P1, read64( p + 8 ) ^ seed_ );
+				p += 16;
+				left -= 16;
+			}
+
+			a = read64( p + left - 16 );
+			b = read64( p + left - 8 );
+		}
+
+		a ^= WY_P1;
+		b ^= seed_;
+		return mum( ( a * b ) ^ WY_P0 ^ n_, mul_high( a, b ) ^ WY_P1 );
+	}
+
+	/// Folds h_ into seed_, e.g. the hash of one more member of a key.
+	inline uint64_t hash_combine( uint64_t seed_, uint64_t h_ )
+	{ return mum( seed_ ^ WY_P0, h_ ^ WY_P1 ); }
+
+	/// True for std::tuple and std::pair, whose members are hashed one after the other.
+	template < typename T >
+	struct is_hash_tuple : std::false_type {};
+
+	template < typename... Ts >
+	struct is_hash_tuple< std::tuple< Ts... > > : std::true_type {};
+
+	template < typename A, typename B >
+	struct is_hash_tuple< std::pair< A, B > > : std::true_type {};
+
+	/// Hash of a string, from seed_. std::string, std::string_view and C strings with the same characters hash alike.
+	inline uint64_t hash_value( std::string_view v_, uint64_t seed_ )
+	{ return hash_bytes( v_.data(), v_.size(), seed_ ); }
+
+	inline uint64_t hash_value( const std::string & v_, uint64_t seed_ )
+	{ return hash_bytes( v_.data(), v_.size(), seed_ ); }
+
+	inline uint64_t hash_value( const char * v_, uint64_t seed_ )
+	{ return hash_value( std::string_view( v_ ), seed_ ); }
+
+	/// Hash of an integer or enumeration, from seed_: its value is mixed in directly, with no call to std::hash.
+	template < typename T, typename std::enable_if< std::is_integral< T >::value or std::is_enum< T >::value, int >::type = 0 >
+	uint64_t hash_value( const T & v_, uint64_t seed_ )
+	{ return hash_combine( seed_, static_cast< uint64_t >( v_ ) ); }
+
+	/// Hash of any other type, from seed_: its std::hash, mixed in.
+	template < typename T, typename std::enable_if< not std::is_integral< T >::value and not std::is_enum< T >::value and not is_hash_tuple< T >::value
+													and not std::is_convertible< const T&, std::string_view >::value, int >::type = 0 >
+	uint64_t hash_value( const T & v_, uint64_t seed_ )
+	{ return hash_combine( seed_, std::hash< T >()( v_ ) ); }
+
+	/// Hash of a tuple or pair, from seed_: every member is hashed from the hash of the members before it.
+	template < typename T, typename std::enable_if< is_hash_tuple< T >::value, int >::type = 0 >
+	uint64_t hash_value( const T & v_, uint64_t seed_ )
+	{
+		std::apply( [&seed_]( const auto &... m_ ) { ( ( seed_ = hash_value( m_, seed_ ) ), ... ); }, v_ );
+		return seed_;
+	}
+
+	/// Hash of several values taken as one key, e.g. hash_members( a.bank, a.number ) for a struct key: the same as the hash of their std::tie().
+	template < typename... Ts >
+	size_t hash_members( const Ts &... members_ )
+	{
+		uint64_t seed = HASH_SEED;
+		( ( seed = hash_value( members_, seed ) ), ... );
+		return static_cast< size_t >( seed );
+	}
+
+	/*! \struct composite_hash
+		\brief Hash functor for tuple, pair, string and integer keys, e.g. HashTbl< std::tuple< std::string, int >, Data, composite_hash >.
+
+		It is transparent: a tuple holding std::string_view hashes like the same tuple holding
+		std::string, so with a transparent KeyEqual such keys can be looked up without copying
+		the strings. For a struct key, hash the std::tie() of its members, or call hash_members().
+	*/
+	struct composite_hash
+	{
+		using is_transparent = void;
+
+		template < typename T >
+		size_t operator()( const T & k_ ) const
+		{ return static_cast< size_t >( hash_value( k_, HASH_SEED ) ); }
+	};
+} // ac Namespace
+#endif
@@ -0,0 +1,468 @@
+#ifndef MAPPED_HASH_H
+#define MAPPED_HASH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/// True for std::tuple and std::pair, which snapshot_traits stores member by member.
+	template < typename T >
+	struct is_tuple_like : std::false_type {};
+
+	template < typename... Ts >
+	struct is_tuple_like< std::tuple< Ts... > > : std::true_type {};
+
+	template < typename A, typename B >
+	struct is_tuple_like< std::pair< A, B > > : std::true_type {};
+
+	/*! \struct snapshot_traits
+		\brief How a key or data type is laid out in a snapshot file.
+
+		Every value takes size bytes of its record. store() writes it, appending any variable
+		length part to the arena; load() rebuilds it; equal() compares it to a stored one
+		without rebuilding it. Provided for trivially copyable types other than pointers,
+		std::string and std::tuple or std::pair of supported types; specialize it for other types.
+	*/
+	template < typename T, typename = void >
+	struct snapshot_traits;
+
+	/// Trivially copyable values are stored as they are in memory. Pointers are refused: the addresses they hold mean nothing once the file is mapped again.
+	template < typename T >
+	struct snapshot_traits< T, typename std::enable_if< std::is_trivially_copyable< T >::value and not is_tuple_like< T >::value >::type >
+	{
+		static_assert( not std::is_pointer< T >::value and not std::is_member_pointer< T >::value,
+		               "snapshot_traits<T>: T is a pointer type, whose address can't be stored in a snapshot; specialize snapshot_traits for it" );
+
+		static constexpr size_t size = sizeof( T );
+
+		static void store( const T & v_, char * dst_, std::string & )
+		{ std::memcpy( dst_, &v_, sizeof( T ) ); }
+
+		static T load( const char * src_, const char * )
+		{
+			T v;
+			std::memcpy( &v, src_, sizeof( T ) );
+			return v;
+		}
+
+		static bool equal( const T & v_, const char * src_, const char * arena_ )
+		{ return load( src_, arena_ ) == v_; }
+	};
+
+	/// Strings are stored as the offset and length of their characters in the arena.
+	template < >
+	struct snapshot_traits< std::string >
+	{
+		static constexpr size_t size = 2 * sizeof( uint64_t );
+
+		static void store( const std::string & v_, char * dst_, std::string & arena_ )
+		{
+			uint64_t place[2] = { arena_.size(), v_.size() };
+			std::memcpy( dst_, place, size );
+			arena_ += v_;
+		}
+
+		static std::string load( const char * src_, const char * arena_ )
+		{ return std::string( view( src_, arena_ ) ); }
+
+		static bool equal( const std::string & v_, const char * src_, const char * arena_ )
+		{ return view( src_, arena_ ) == v_; }
+
+		/// The stored characters, read in place.
+		static std::string_view view( const char * src_, const char * arena_ )
+		{
+			uint64_t place[2];
+			std::memcpy( place, src_, size );
+			return std::string_view( arena_ + place[0], place[1] );
+		}
+	};
+
+	/// Tuples and pairs are stored member after member, e.g. Account::AcctKey as a string then three ints.
+	template < typename T >
+	struct snapshot_traits< T, typename std::enable_if< is_tuple_like< T >::value >::type >
+	{
+		template < size_t I >
+		using member = snapshot_traits< typename std::tuple_element< I, T >::type >;
+
+		static constexpr size_t COUNT = std::tuple_size< T >::value;
+
+		/// Offset of the I-th member within the stored tuple.
+		template < size_t I >
+		static constexpr size_t offset( void )
+		{
+			if constexpr ( I == 0 )
+				return 0;
+			else
+				return offset< I - 1 >() + member< I - 1 >::size;
+		}
+
+		static constexpr size_t size = offset< COUNT >();
+
+		static void store( const T & v_, char * dst_, std::string & arena_ )
+		{ store_each( v_, dst_, arena_, std::make_index_sequence< COUNT >() ); }
+
+		static T load( const char * src_, const char * arena_ )
+		{ return load_each( src_, arena_, std::make_index_sequence< COUNT >() ); }
+
+		static bool equal( const T & v_, const char * src_, const char * arena_ )
+		{ return equal_each( v_, src_, arena_, std::make_index_sequence< COUNT >() ); }
+
+		private:
+			template < size_t... I >
+			static void store_each( const T & v_, char * dst_, std::string & arena_, std::index_sequence< I... > )
+			{ ( member< I >::store( std::get< I >( v_ ), dst_ + offset< I >(), arena_ ), ... ); }
+
+			template < size_t... I >
+			static T load_each( const char * src_, const char * arena_, std::index_sequence< I... > )
+			{ return T( member< I >::load( src_ + offset< I >(), arena_ )... ); }
+
+			template < size_t... I >
+			static bool equal_each( const T & v_, const char * src_, const char * arena_, std::index_sequence< I... > )
+			{ return ( member< I >::equal( std::get< I >( v_ ), src_ + offset< I >(), arena_ ) and ... ); }
+	};
+
+	/*! \struct SnapshotHeader
+		\brief First bytes of a snapshot file.
+
+		The file is position independent: every part is found through an offset from the
+		start of the file. After the header come bucket_count + 1 record indices, bucket b
+		holding the records from index b up to index b + 1; then the records, each made of
+		the full 64 bit hash of its key, the key and the data, as laid out by
+		snapshot_traits; then the arena holding the characters of the strings.
+
+		The stored hashes are whatever the writer's KeyHash returned, so hash_check
+		identifies that KeyHash: it folds the hashes of a few records spread over the file,
+		and the reader rehashes the same stored keys with its own KeyHash to compare.
+	*/
+	struct SnapshotHeader
+	{
+		char magic[8]; //!< SNAPSHOT_MAGIC.
+		uint32_t version; //!< SNAPSHOT_VERSION of the writer.
+		uint32_t byte_order; //!< SNAPSHOT_BYTE_ORDER as the writer saw it, so a file from a machine of the other endianness is rejected.
+		uint64_t key_size; //!< Bytes per stored key.
+		uint64_t data_size; //!< Bytes per stored data.
+		uint64_t hash_check; //!< snapshot_hash_check() of the records, to reject a reader whose KeyHash differs from the writer's.
+		uint64_t count; //!< Number of records.
+		uint64_t bucket_count; //!< Number of buckets, a power of two.
+		uint64_t buckets_offset; //!< Where the record indices start.
+		uint64_t records_offset; //!< Where the records start.
+		uint64_t arena_offset; //!< Where the arena starts.
+		uint64_t file_size; //!< Total size of the file, arena included.
+	};
+
+	inline constexpr char SNAPSHOT_MAGIC[8] = "ACHTSNP"; //!< Identifies snapshot files.
+	inline constexpr uint32_t SNAPSHOT_VERSION = 2; //!< Bumped whenever the layout changes; other versions are rejected.
+	inline constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304; //!< Read back differently on a machine of the other endianness.
+
+	inline constexpr uint64_t SNAPSHOT_HASH_SAMPLES = 16; //!< About how many records hash_check is made of.
+
+	/// Bucket of a key whose KeyHash is hash_, in a snapshot with mask_ + 1 buckets.
+	inline size_t snapshot_bucket( uint64_t hash_, uint64_t mask_ )
+	{ return static_cast< size_t >( mix_hash( hash_ ) & mask_ ); }
+
+	/// Folds hash_( i ), the KeyHash of the key of record i, for about SNAPSHOT_HASH_SAMPLES records evenly spread over count_ records.
+	template < typename Fn >
+	uint64_t snapshot_hash_check( uint64_t count_, Fn && hash_ )
+	{
+		uint64_t check = count_;
+		uint64_t step = std::max< uint64_t >( 1, count_ / SNAPSHOT_HASH_SAMPLES );
+		for( uint64_t i = 0 ; i < count_ ; i += step )
+			check = mix_hash( check ^ hash_( i ) );
+		return check;
+	}
+
+	/// Flushes the file or directory at path_ to disk. Returns false if it can't be opened or synced.
+	inline bool sync_path( const std::string & path_ )
+	{
+		int fd = ::open( path_.c_str(), O_RDONLY );
+		if( fd < 0 )
+			return false;
+		bool synced = ::fsync( fd ) == 0;
+		::close( fd );
+		return synced;
+	}
+
+	/// Writes every entry of tbl_ to a snapshot file at path_, to be opened with MappedHashTbl. The file is written under a temporary name, synced to disk, and renamed over path_ when complete, so readers never see a partial snapshot, even after a crash. Throws std::runtime_error if the file can't be written.
+	template < typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename StoragePolicy, typename SizePolicy, typename HashPolicy, typename Allocator, typename StatsPolicy >
+	void save_snapshot( const HashTbl< KeyType, DataType, KeyHash, KeyEqual, StoragePolicy, SizePolicy, HashPolicy, Allocator, StatsPolicy > & tbl_, const std::string & path_ )
+	{
+		using KeyTraits = snapshot_traits< KeyType >;
+		using DataTraits = snapshot_traits< DataType >;
+		const size_t record_size = sizeof( uint64_t ) + KeyTraits::size + DataTraits::size;
+
+		SnapshotHeader header{};
+		std::memcpy( header.magic, SNAPSHOT_MAGIC, sizeof( header.magic ) );
+		header.version = SNAPSHOT_VERSION;
+		header.byte_order = SNAPSHOT_BYTE_ORDER;
+		header.key_size = KeyTraits::size;
+		header.data_size = DataTraits::size;
+		header.count = tbl_.size();
+		header.bucket_count = 1;
+		while( header.bucket_count < header.count )
+			header.bucket_count *= 2;
+
+		// Counting sort of the entries by bucket: first the hashes and bucket sizes, then every record at its place.
+		KeyHash hashFunc;
+		std::vector< uint64_t > hashes;
+		std::vector< uint64_t > starts( header.bucket_count + 1, 0 );
+		hashes.reserve( header.count );
+		for( const auto & e : tbl_ )
+		{
+			hashes.push_back( hashFunc( e.m_key ) );
+			starts[ snapshot_bucket( hashes.back(), header.bucket_count - 1 ) + 1 ]++;
+		}
+		for( size_t b = 0 ; b < header.bucket_count ; b++ )
+			starts[ b + 1 ] += starts[b];
+
+		std::vector< char > records( header.count * record_size );
+		std::vector< uint64_t > next( starts.begin(), starts.end() - 1 );
+		std::string arena;
+		size_t i = 0;
+		for( const auto & e : tbl_ )
+		{
+			uint64_t hash = hashes[ i++ ];
+			char * record = records.data() + next[ snapshot_bucket( hash, header.bucket_count - 1 ) ]++ * record_size;
+			std::memcpy( record, &hash, sizeof( hash ) );
+			KeyTraits::store( e.m_key, record + sizeof( hash ), arena );
+			DataTraits::store( e.m_data, record + sizeof( hash ) + KeyTraits::size, arena );
+		}
+
+		header.hash_check = snapshot_hash_check( header.count, [&]( uint64_t i_ ) {
+			uint64_t hash;
+			std::memcpy( &hash, records.data() + i_ * record_size, sizeof( hash ) );
+			return hash;
+		} );
+
+		header.buckets_offset = sizeof( SnapshotHeader );
+		header.records_offset = header.buckets_offset + starts.size() * sizeof( uint64_t );
+		header.arena_offset = header.records_offset + records.size();
+		header.file_size = header.arena_offset + arena.size();
+
+		std::string temp = path_ + ".tmp";
+		{
+			std::ofstream out( temp, std::ios::binary | std::ios::trunc );
+			out.write( reinterpret_cast< const char* >( &header ), sizeof( header ) );
+			out.write( reinterpret_cast< const char* >( starts.data() ), starts.size() * sizeof( uint64_t ) );
+			out.write( records.data(), records.size() );
+			out.write( arena.data(), arena.size() );
+			out.close();
+			if( not out or not sync_path( temp ) )
+			{
+				std::remove( temp.c_str() );
+				throw std::runtime_error( "save_snapshot: can't write " + temp );
+			}
+		}
+		if( std::rename( temp.c_str(), path_.c_str() ) != 0 )
+		{
+			std::remove( temp.c_str() );
+			throw std::runtime_error( "save_snapshot: can't rename " + temp + " to " + path_ );
+		}
+
+		// The rename itself is only durable once the directory holding path_ is synced.
+		size_t slash = path_.find_last_of( '/' );
+		std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : path_.substr( 0, slash );
+		if( not sync_path( dir ) )
+			throw std::runtime_error( "save_snapshot: can't sync " + dir );
+	}
+
+	/*! \class MappedHashTbl
+		\brief Read only view of a snapshot file written by save_snapshot(), mapped in memory.
+
+		Opening a snapshot maps it and checks its header, nothing is read or rebuilt: pages
+		are loaded by the OS as lookups touch them, and are shared by every process mapping
+		the same file. A lookup hashes the key with KeyHash, which must be the one the table
+		was saved with, checked on open through the header's hash_check, walks the records of its bucket comparing the stored hashes, then
+		compares the stored key in place with snapshot_traits::equal(), i.e. member by member
+		with ==. Only the data of the key found is rebuilt, by retrieve().
+
+		The header is checked against the file's size and this table's types; a lookup never
+		reads a record past the last one, but string offsets are trusted as written.
+	*/
+	template < typename KeyType, typename DataType, typename KeyHash = std::hash< KeyType > >
+	class MappedHashTbl
+	{
+		using KeyTraits = snapshot_traits< KeyType >;
+		using DataTraits = snapshot_traits< DataType >;
+
+		public:
+			//== Constructors
+			/// Maps the snapshot at path_. Throws std::runtime_error if the file can't be mapped, isn't a snapshot of this version, was saved for keys or data of other sizes, or with another KeyHash.
+			explicit MappedHashTbl( const std::string & path_ )
+			{
+				int fd = ::open( path_.c_str(), O_RDONLY );
+				if( fd < 0 )
+					throw std::runtime_error( "MappedHashTbl: can't open " + path_ );
+
+				struct stat st;
+				if( ::fstat( fd, &st ) != 0 or static_cast< size_t >( st.st_size ) < sizeof( SnapshotHeader ) )
+				{
+					::close( fd );
+					throw std::runtime_error( "MappedHashTbl: " + path_ + " is not a snapshot" );
+				}
+
+				m_length = static_cast< size_t >( st.st_size );
+				void * base = ::mmap( nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0 );
+				::close( fd );
+				if( base == MAP_FAILED )
+					throw std::runtime_error( "MappedHashTbl: can't map " + path_ );
+				m_base = static_cast< const char* >( base );
+
+				std::memcpy( &m_header, m_base, sizeof( m_header ) );
+				if( not valid_header() )
+				{
+					::munmap( const_cast< char* >( m_base ), m_length );
+					throw std::runtime_error( "MappedHashTbl: " + path_ + " is not a compatible snapshot" );
+				}
+
+				m_records = m_base + m_header.records_offset;
+				m_arena = m_base + m_header.arena_offset;
+			}
+
+			/// The mapping belongs to one table: it can be moved but not copied.
+			MappedHashTbl( MappedHashTbl && other ) noexcept
+				: m_base( other.m_base ), m_length( other.m_length ), m_header( other.m_header ),
+				  m_records( other.m_records ), m_arena( other.m_arena )
+			{
+				other.m_base = nullptr;
+				other.m_length = 0;
+			}
+
+			MappedHashTbl( const MappedHashTbl & ) = delete;
+			MappedHashTbl& operator=( const MappedHashTbl & ) = delete;
+
+			/// Unmaps the file.
+			~MappedHashTbl()
+			{
+				if( m_base != nullptr )
+					::munmap( const_cast< char* >( m_base ), m_length );
+			}
+
+			//=== Methods
+			/// Copies in d_ the data of the k_ key and returns true, or returns false if the key is not in the snapshot.
+			bool retrieve ( const KeyType & k_, DataType & d_ ) const
+			{
+				const char * record = find_record( k_ );
+				if( record == nullptr )
+					return false;
+
+				d_ = DataTraits::load( record + sizeof( uint64_t ) + KeyTraits::size, m_arena );
+				return true;
+			}
+
+			/// Returns true if the k_ key is in the snapshot.
+			bool contains ( const KeyType & k_ ) const
+			{ return find_record( k_ ) != nullptr; }
+
+			/// Calls fn_( key, data ) on every record, both rebuilt from the file, in bucket order.
+			template < typename Fn >
+			void for_each ( Fn && fn_ ) const
+			{
+				for( size_t i = 0 ; i < m_header.count ; i++ )
+				{
+					const char * record = m_records + i * RECORD_SIZE;
+					const KeyType key = KeyTraits::load( record + sizeof( uint64_t ), m_arena );
+					const DataType data = DataTraits::load( record + sizeof( uint64_t ) + KeyTraits::size, m_arena );
+					fn_( key, data );
+				}
+			}
+
+			/// Returns the number of records.
+			size_t size ( void ) const
+			{ return m_header.count; }
+
+			/// Returns true if the snapshot holds no record.
+			bool empty ( void ) const
+			{ return m_header.count == 0; }
+
+			/// Returns the number of buckets.
+			size_t bucket_count ( void ) const
+			{ return m_header.bucket_count; }
+
+		private:
+			/// Record of the k_ key, or nullptr if it is not in the snapshot.
+			const char * find_record( const KeyType & k_ ) const
+			{
+				KeyHash hashFunc;
+				uint64_t hash = hashFunc( k_ );
+				size_t b = snapshot_bucket( hash, m_header.bucket_count - 1 );
+
+				uint64_t end = std::min< uint64_t >( index( b + 1 ), m_header.count );
+				for( uint64_t i = index( b ) ; i < end ; i++ )
+				{
+					const char * record = m_records + i * RECORD_SIZE;
+					uint64_t stored;
+					std::memcpy( &stored, record, sizeof( stored ) );
+					if( stored == hash and KeyTraits::equal( k_, record + sizeof( uint64_t ), m_arena ) )
+						return record;
+				}
+
+				return nullptr;
+			}
+
+			/// First record of bucket b_, or one past the last record for b_ == bucket_count().
+			uint64_t index( size_t b_ ) const
+			{
+				uint64_t i;
+				std::memcpy( &i, m_base + m_header.buckets_offset + b_ * sizeof( uint64_t ), sizeof( i ) );
+				return i;
+			}
+
+			/// True when the header matches this build, this table's types and KeyHash, and every part it points to lies within the file.
+			bool valid_header( void ) const
+			{
+				const SnapshotHeader & h = m_header;
+				if( std::memcmp( h.magic, SNAPSHOT_MAGIC, sizeof( h.magic ) ) != 0 or h.version != SNAPSHOT_VERSION
+					or h.byte_order != SNAPSHOT_BYTE_ORDER or h.key_size != KeyTraits::size or h.data_size != DataTraits::size )
+					return false;
+
+				if( h.bucket_count == 0 or ( h.bucket_count & ( h.bucket_count - 1 ) ) != 0 or h.file_size != m_length
+					or h.bucket_count >= m_length / sizeof( uint64_t ) or h.count > m_length / RECORD_SIZE )
+					return false;
+
+				if( h.buckets_offset != sizeof( SnapshotHeader )
+					or h.records_offset != h.buckets_offset + ( h.bucket_count + 1 ) * sizeof( uint64_t )
+					or h.arena_offset != h.records_offset + h.count * RECORD_SIZE
+					or h.arena_offset > h.file_size
+					or index( h.bucket_count ) != h.count )
+					return false;
+
+				// Rehash a few stored keys: a KeyHash other than the writer's would put lookups in the wrong buckets.
+				KeyHash hashFunc;
+				const char * records = m_base + h.records_offset;
+				const char * arena = m_base + h.arena_offset;
+				return h.hash_check == snapshot_hash_check( h.count, [&]( uint64_t i_ ) {
+					return static_cast< uint64_t >( hashFunc( KeyTraits::load( records + i_ * RECORD_SIZE + sizeof( uint64_t ), arena ) ) );
+				} );
+			}
+
+			static constexpr size_t RECORD_SIZE = sizeof( uint64_t ) + KeyTraits::size + DataTraits::size; //!< Bytes per record: hash, key and data.
+
+			const char * m_base = nullptr; //!< Start of the mapping.
+			size_t m_length = 0u; //!< Length of the mapping, the whole file.
+			SnapshotHeader m_header; //!< Copy of the file's header.
+			const char * m_records = nullptr; //!< First record.
+			const char * m_arena = nullptr; //!< Start of the string arena.
+
+	}; // MappedHashTbl Class
+} // ac Namespace
+#endif
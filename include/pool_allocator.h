@@ -0,0 +1,200 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace ac
+{
+	/*! \class node_pool
+		\brief Fixed size blocks carved out of chunks, recycled through a free list.
+
+		Blocks are handed out from the free list first, then from the current chunk; a new
+		chunk of blocks_per_chunk blocks is allocated when both run out. Freed blocks go back
+		to the free list, chunks are only released when the pool is destroyed. Not thread safe.
+	*/
+	class node_pool
+	{
+		public:
+			/// Pool of blocks able to hold block_size_ bytes with the given alignment.
+			node_pool( size_t block_size_, size_t align_, size_t blocks_per_chunk_ )
+				: m_block_size( block_size_for( block_size_, align_ ) ),
+				  m_per_chunk( blocks_per_chunk_ == 0 ? 1 : blocks_per_chunk_ )
+			{  }
+
+			node_pool( const node_pool & ) = delete;
+			node_pool& operator=( const node_pool & ) = delete;
+
+			/// Releases every chunk, whether its blocks were freed or not.
+			~node_pool()
+			{
+				for( void * chunk : m_chunks )
+					::operator delete( chunk );
+			}
+
+			/// Returns one block.
+			void * allocate( void )
+			{
+				if( m_free != nullptr )
+				{
+					FreeBlock * block = m_free;
+					m_free = block->next;
+					return block;
+				}
+
+				if( m_cursor == m_end )
+				{
+					m_chunks.reserve( m_chunks.size() + 1 );
+					m_cursor = static_cast< char* >( ::operator new( m_block_size * m_per_chunk ) );
+					m_end = m_cursor + m_block_size * m_per_chunk;
+					m_chunks.push_back( m_cursor );
+				}
+
+				void * block = m_cursor;
+				m_cursor += m_block_size;
+				return block;
+			}
+
+			/// Gives a block back, to be reused by the next allocate().
+			void deallocate( void * p_ ) noexcept
+			{
+				FreeBlock * block = static_cast< FreeBlock* >( p_ );
+				block->next = m_free;
+				m_free = block;
+			}
+
+			/// Size of the blocks, after rounding up for alignment.
+			size_t block_size( void ) const
+			{ return m_block_size; }
+
+			/// Block size used for objects of size_ bytes with the given alignment: room for a free list link, rounded up to the alignment.
+			static size_t block_size_for( size_t size_, size_t align_ )
+			{
+				size_t size = size_ < sizeof( FreeBlock ) ? sizeof( FreeBlock ) : size_;
+				size_t align = align_ < alignof( FreeBlock ) ? alignof( FreeBlock ) : align_;
+				return ( size + align - 1 ) / align * align;
+			}
+
+		private:
+			/// A block on the free list.
+			struct FreeBlock
+			{
+				FreeBlock * next;
+			};
+
+			size_t m_block_size; //!< Bytes per block.
+			size_t m_per_chunk; //!< Blocks per chunk.
+			FreeBlock * m_free = nullptr; //!< Blocks given back, most recent first.
+			char * m_cursor = nullptr; //!< Next never used block of the last chunk.
+			char * m_end = nullptr; //!< End of the last chunk.
+			std::vector< void* > m_chunks; //!< Every chunk, released by the destructor.
+	};
+
+	/*! \class pool_set
+		\brief One node_pool per block size, shared by a pool_allocator and all its copies and rebinds.
+
+	*/
+	class pool_set
+	{
+		public:
+			explicit pool_set( size_t blocks_per_chunk_ ) : m_per_chunk( blocks_per_chunk_ )
+			{  }
+
+			/// The pool serving blocks of size_ bytes, created on first use.
+			node_pool & pool_for( size_t size_, size_t align_ )
+			{
+				for( auto & pool : m_pools )
+					if( pool->block_size() == node_pool::block_size_for( size_, align_ ) )
+						return *pool;
+
+				m_pools.emplace_back( new node_pool( size_, align_, m_per_chunk ) );
+				return *m_pools.back();
+			}
+
+		private:
+			size_t m_per_chunk; //!< Blocks per chunk of every pool.
+			std::vector< std::unique_ptr< node_pool > > m_pools;
+	};
+
+	/*! \class pool_allocator
+		\brief std::allocator compatible node allocator for HashTbl.
+
+		Single object requests, i.e. the chained table's list nodes, come from a node_pool
+		for their size, so inserting and erasing recycles memory instead of calling the
+		global new and delete each time. Arrays (the bucket and slot arrays) go to the
+		global operator new. Copies and rebinds share the pools, which live until the last
+		of them is destroyed; a default constructed allocator, and thus every table and table
+		copy, starts its own. Not thread safe, like the tables using it.
+	*/
+	template < typename T, size_t BlocksPerChunk = 256 >
+	class pool_allocator
+	{
+		static_assert( alignof( T ) <= alignof( std::max_align_t ), "pool_allocator doesn't support over-aligned types" );
+
+		template < typename U, size_t N >
+		friend class pool_allocator;
+
+		public:
+			using value_type = T;
+			using propagate_on_container_copy_assignment = std::false_type;
+			using propagate_on_container_move_assignment = std::true_type;
+			using propagate_on_container_swap = std::true_type;
+			using is_always_equal = std::false_type;
+
+			template < typename U >
+			struct rebind
+			{
+				using other = pool_allocator< U, BlocksPerChunk >;
+			};
+
+			/// Allocator with new, empty, pools.
+			pool_allocator( void )
+				: m_pools( std::make_shared< pool_set >( BlocksPerChunk ) ),
+				  m_pool( &m_pools->pool_for( sizeof( T ), alignof( T ) ) )
+			{  }
+
+			/// Allocator sharing the pools of other.
+			template < typename U >
+			pool_allocator( const pool_allocator< U, BlocksPerChunk > & other )
+				: m_pools( other.m_pools ),
+				  m_pool( &m_pools->pool_for( sizeof( T ), alignof( T ) ) )
+			{  }
+
+			/// A container copy gets new pools of its own, so the copy can be handed to another thread.
+			pool_allocator select_on_container_copy_construction( void ) const
+			{ return pool_allocator(); }
+
+			T * allocate( size_t n_ )
+			{
+				if( n_ == 1 )
+					return static_cast< T* >( m_pool->allocate() );
+
+				return static_cast< T* >( ::operator new( n_ * sizeof( T ) ) );
+			}
+
+			void deallocate( T * p_, size_t n_ ) noexcept
+			{
+				if( n_ == 1 )
+					m_pool->deallocate( p_ );
+				else
+					::operator delete( p_ );
+			}
+
+			/// Allocators are equal when they share their pools, so either can free what the other allocated.
+			template < typename U >
+			bool operator==( const pool_allocator< U, BlocksPerChunk > & other ) const
+			{ return m_pools == other.m_pools; }
+
+			template < typename U >
+			bool operator!=( const pool_allocator< U, BlocksPerChunk > & other ) const
+			{ return m_pools != other.m_pools; }
+
+		private:
+			std::shared_ptr< pool_set > m_pools; //!< Pools shared with copies and rebinds.
+			node_pool * m_pool; //!< The pool for sizeof( T ) blocks.
+	};
+} // ac Namespace
+#endif
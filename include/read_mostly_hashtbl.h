@@ -0,0 +1,471 @@
+#ifndef READ_MOSTLY_HASH_H
+#define READ_MOSTLY_HASH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/*! \class ReadMostlyHashTbl
+		\brief Chained hash table whose lookups never take a lock, for tables read far more often than written.
+
+		Buckets and list links are atomic pointers. A lookup only announces itself in a
+		reader slot, picked from the thread id so that threads don't share cache lines, walks
+		the list and copies the data out: it never waits for a writer, nor for a rehash, nor
+		for another reader. When all READER_SLOTS slots are taken, the reader announces itself
+		in a shared overflow counter instead, and reclaiming waits until it drops to zero.
+
+		Writers are serialized by a mutex and never modify a node readers may be looking at:
+		a new key is linked in front of its bucket, a new value replaces the node holding the
+		old one, and a rehash builds a whole new bucket array of new nodes before publishing
+		it. Unlinked nodes and arrays are reclaimed with epochs: each one is stamped with the
+		global epoch when it is retired, and freed once every reader inside the table entered
+		it in a later epoch.
+	*/
+	template < typename KeyType,
+			   typename DataType,
+			   typename KeyHash = std::hash< KeyType >,
+			   typename KeyEqual = std::equal_to< KeyType >,
+			   typename SizePolicy = prime_size >
+	class ReadMostlyHashTbl
+	{
+		public:
+			/// Lookup methods taking a K key are only enabled for KeyType itself, or for any K when KeyHash and KeyEqual are transparent.
+			template < typename K >
+			using lookup_key = typename std::enable_if< std::is_same< K, KeyType >::value or transparent_key< KeyHash, KeyEqual, K >::value >::type;
+
+			//== Constructors
+			/// Constructor with a defined number of buckets.
+			explicit ReadMostlyHashTbl( size_t tbl_size_ = DEFAULT_SIZE )
+			{
+				m_array.store( new Array( SizePolicy::capacity( tbl_size_ == 0 ? 1 : tbl_size_ ) ) );
+			}
+
+			/// Frees every node and array. No reader may still be inside the table.
+			~ReadMostlyHashTbl()
+			{
+				Array * array = m_array.load();
+				free_nodes( array );
+				delete array;
+
+				for( auto & r : m_retired_nodes )
+					delete r.second;
+				for( auto & r : m_retired_arrays )
+					delete r.second;
+			}
+
+			/// Readers hold pointers into the table, it can be neither copied nor moved.
+			ReadMostlyHashTbl( const ReadMostlyHashTbl & ) = delete;
+			ReadMostlyHashTbl& operator=( const ReadMostlyHashTbl & ) = delete;
+
+			//=== Read methods, lock free
+			/// Copies in d_ the data of the k_ key and returns true, or returns false if the key is not on the table.
+			bool retrieve ( const KeyType & k_, DataType & d_ ) const
+			{ return retrieve< KeyType >( k_, d_ ); }
+
+			/// Same as the retrieve() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool retrieve ( const K & k_, DataType & d_ ) const
+			{
+				ReadGuard guard( *this );
+				const Node * node = find_node( k_ );
+
+				if( node == nullptr )
+					return false;
+
+				d_ = node->data;
+				return true;
+			}
+
+			/// Returns true if the k_ key is on the table.
+			bool contains ( const KeyType & k_ ) const
+			{ return contains< KeyType >( k_ ); }
+
+			/// Same as the contains() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool contains ( const K & k_ ) const
+			{
+				ReadGuard guard( *this );
+				return find_node( k_ ) != nullptr;
+			}
+
+			/// Calls fn_( key, data ) on every entry of the bucket array current when the walk starts. Entries changed meanwhile may be seen with their old or new data.
+			template < typename Fn >
+			void for_each ( Fn && fn_ ) const
+			{
+				ReadGuard guard( *this );
+				const Array * array = m_array.load( std::memory_order_acquire );
+
+				for( size_t b = 0 ; b < array->size ; b++ )
+					for( const Node * n = array->buckets[b].load( std::memory_order_acquire ) ; n != nullptr ; n = n->next.load( std::memory_order_acquire ) )
+						fn_( n->key, n->data );
+			}
+
+			/// Returns the number of elements stored in the table.
+			size_t size ( void ) const
+			{ return m_count.load( std::memory_order_relaxed ); }
+
+			/// Returns true if the table is empty.
+			bool empty ( void ) const
+			{ return size() == 0; }
+
+			/// Returns the number of buckets.
+			size_t bucket_count ( void ) const
+			{
+				ReadGuard guard( *this );
+				return m_array.load( std::memory_order_acquire )->size;
+			}
+
+			//=== Write methods, serialized
+			/// Stores d_ for the k_ key, replacing the data of an existing key. Returns true if the key is new.
+			bool insert ( const KeyType & k_, const DataType & d_ )
+			{ return store( KeyType( k_ ), DataType( d_ ) ); }
+
+			/// Same as the insert() above, but k_ and d_ are moved into the table instead of copied.
+			bool insert ( KeyType && k_, DataType && d_ )
+			{ return store( std::move( k_ ), std::move( d_ ) ); }
+
+			/// Inserts d_ for the k_ key if it is new and returns true. Otherwise calls update_( data ) on a copy of the existing data, which then replaces it, and returns false. Readers see either the old or the new data, never a partial update.
+			template < typename Fn >
+			bool upsert ( const KeyType & k_, const DataType & d_, Fn && update_ )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				KeyHash hashFunc;
+				size_t hash = hashFunc( k_ );
+				Array * array = m_array.load( std::memory_order_relaxed );
+				Link * link = find_link( array, k_, hash );
+				Node * old = link->load( std::memory_order_relaxed );
+
+				if( old == nullptr )
+				{
+					push_front( array, new Node( k_, d_, hash ) );
+					return true;
+				}
+
+				Node * node = new Node( old->key, old->data, hash );
+				update_( node->data );
+				replace( link, old, node );
+				return false;
+			}
+
+			/// Removes the k_ key from the table. Returns true if it was there. Its node is freed once no reader can be looking at it.
+			bool erase ( const KeyType & k_ )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				KeyHash hashFunc;
+				Link * link = find_link( m_array.load( std::memory_order_relaxed ), k_, hashFunc( k_ ) );
+				Node * old = link->load( std::memory_order_relaxed );
+
+				if( old == nullptr )
+					return false;
+
+				link->store( old->next.load( std::memory_order_relaxed ), std::memory_order_release );
+				m_count.fetch_sub( 1, std::memory_order_relaxed );
+				retire( old );
+				reclaim();
+				return true;
+			}
+
+			/// Removes every entry.
+			void clear ( void )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				Array * array = m_array.load( std::memory_order_relaxed );
+
+				for( size_t b = 0 ; b < array->size ; b++ )
+				{
+					Node * n = array->buckets[b].load( std::memory_order_relaxed );
+					array->buckets[b].store( nullptr, std::memory_order_release );
+					for( ; n != nullptr ; n = n->next.load( std::memory_order_relaxed ) )
+						retire( n );
+				}
+
+				m_count.store( 0, std::memory_order_relaxed );
+				reclaim();
+			}
+
+			/// Resizes the table to SizePolicy::capacity() of n_ buckets, or of size() if that is larger. Readers go on using the old array until the new one is published.
+			void rehash ( size_t n_ )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				resize( SizePolicy::capacity( std::max< size_t >( { n_, m_count.load( std::memory_order_relaxed ), 1 } ) ) );
+			}
+
+			/// Makes room for n_ entries, so inserting up to n_ entries triggers no rehash.
+			void reserve ( size_t n_ )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				if( n_ > m_array.load( std::memory_order_relaxed )->size )
+					resize( SizePolicy::capacity( n_ ) );
+			}
+
+		private:
+			using Reducer = typename SizePolicy::reducer; //!< Maps hashes to buckets for the current size.
+
+			/// List node. Key, data and hash never change once the node is published.
+			struct Node
+			{
+				template < typename K, typename D >
+				Node( K && k_, D && d_, size_t hash_ ) : key( std::forward< K >( k_ ) ), data( std::forward< D >( d_ ) ), hash( hash_ )
+				{  }
+
+				KeyType key;
+				DataType data;
+				size_t hash;
+				std::atomic< Node* > next { nullptr };
+			};
+
+			using Link = std::atomic< Node* >; //!< A bucket head or a node's next pointer.
+
+			/// A bucket array with its size and reducer, swapped as a whole by a rehash.
+			struct Array
+			{
+				explicit Array( size_t size_ ) : size( size_ ), reduce( size_ ), buckets( new Link[ size_ ] )
+				{
+					for( size_t b = 0 ; b < size ; b++ )
+						buckets[b].store( nullptr, std::memory_order_relaxed );
+				}
+
+				size_t size;
+				Reducer reduce;
+				std::unique_ptr< Link[] > buckets;
+			};
+
+			/// Epoch a reader entered the table in, 0 when the slot is free. One cache line per slot.
+			struct alignas( 64 ) ReaderSlot
+			{
+				std::atomic< uint64_t > epoch { 0 };
+			};
+
+			/*! \class ReadGuard
+				\brief Announces a reader in a free slot for its lifetime, so nothing it can reach is freed.
+
+				Each slot is tried once. If none is free, the reader counts itself in the overflow
+				counter, which holds back every reclaim() until it is zero again.
+			*/
+			class ReadGuard
+			{
+				public:
+					explicit ReadGuard( const ReadMostlyHashTbl & tbl_ )
+					{
+						size_t start = slot_hint();
+
+						for( size_t i = 0 ; i < READER_SLOTS and m_slot == nullptr ; i++ )
+						{
+							ReaderSlot & slot = tbl_.m_readers[ ( start + i ) % READER_SLOTS ];
+							uint64_t expected = 0;
+							if( slot.epoch.compare_exchange_strong( expected, tbl_.m_epoch.load() ) )
+								m_slot = &slot;
+						}
+
+						if( m_slot == nullptr )
+						{
+							m_overflow = &tbl_.m_overflow;
+							m_overflow->fetch_add( 1 );
+						}
+
+						// Pairs with the fence of reclaim(): either it sees this reader, or this reader sees every unlink made before it.
+						std::atomic_thread_fence( std::memory_order_seq_cst );
+					}
+
+					~ReadGuard()
+					{
+						if( m_slot != nullptr )
+							m_slot->epoch.store( 0, std::memory_order_release );
+						else
+							m_overflow->fetch_sub( 1, std::memory_order_release );
+					}
+
+					ReadGuard( const ReadGuard & ) = delete;
+					ReadGuard& operator=( const ReadGuard & ) = delete;
+
+				private:
+					/// First slot tried by the calling thread, worked out once per thread.
+					static size_t slot_hint( void )
+					{
+						static thread_local size_t hint = std::hash< std::thread::id >()( std::this_thread::get_id() );
+						return hint;
+					}
+
+					ReaderSlot * m_slot = nullptr; //!< Slot announcing the reader, nullptr if it overflowed.
+					std::atomic< size_t > * m_overflow = nullptr; //!< Overflow counter the reader is counted in, if it got no slot.
+			};
+
+			/// Node of the k_ key in the current array, or nullptr. Must be called with a ReadGuard alive.
+			template < typename K >
+			const Node * find_node( const K & k_ ) const
+			{
+				KeyHash hashFunc;
+				KeyEqual equalFunc;
+				size_t hash = hashFunc( k_ );
+				const Array * array = m_array.load( std::memory_order_acquire );
+
+				for( const Node * n = array->buckets[ array->reduce( hash ) ].load( std::memory_order_acquire ) ; n != nullptr ; n = n->next.load( std::memory_order_acquire ) )
+					if( n->hash == hash and equalFunc( n->key, k_ ) )
+						return n;
+
+				return nullptr;
+			}
+
+			/// The link pointing at the node of the k_ key, or the null link ending its bucket if the key is not on the table. Writers only.
+			Link * find_link( Array * array_, const KeyType & k_, size_t hash_ )
+			{
+				KeyEqual equalFunc;
+				Link * link = &array_->buckets[ array_->reduce( hash_ ) ];
+
+				for( Node * n = link->load( std::memory_order_relaxed ) ; n != nullptr ; n = link->load( std::memory_order_relaxed ) )
+				{
+					if( n->hash == hash_ and equalFunc( n->key, k_ ) )
+						return link;
+					link = &n->next;
+				}
+
+				return link;
+			}
+
+			/// Stores d_ for the k_ key, as insert() does.
+			bool store( KeyType && k_, DataType && d_ )
+			{
+				std::lock_guard< std::mutex > lock( m_write );
+				KeyHash hashFunc;
+				size_t hash = hashFunc( k_ );
+				Array * array = m_array.load( std::memory_order_relaxed );
+				Link * link = find_link( array, k_, hash );
+				Node * old = link->load( std::memory_order_relaxed );
+
+				if( old == nullptr )
+				{
+					push_front( array, new Node( std::move( k_ ), std::move( d_ ), hash ) );
+					return true;
+				}
+
+				replace( link, old, new Node( std::move( k_ ), std::move( d_ ), hash ) );
+				return false;
+			}
+
+			/// Publishes node_, whose key is new, at the front of its bucket, growing the table if its load factor goes over 1.
+			void push_front( Array * array_, Node * node_ )
+			{
+				Link & head = array_->buckets[ array_->reduce( node_->hash ) ];
+				node_->next.store( head.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+				head.store( node_, std::memory_order_release );
+
+				if( m_count.fetch_add( 1, std::memory_order_relaxed ) + 1 > array_->size )
+					resize( SizePolicy::capacity( array_->size * 2 ) );
+			}
+
+			/// Publishes node_ in place of old_, which link_ points at, then retires old_.
+			void replace( Link * link_, Node * old_, Node * node_ )
+			{
+				node_->next.store( old_->next.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+				link_->store( node_, std::memory_order_release );
+				retire( old_ );
+				reclaim();
+			}
+
+			/// Builds a new array of new_size_ buckets holding copies of every node, publishes it and retires the old array and nodes. Readers keep walking the old ones until they leave.
+			void resize( size_t new_size_ )
+			{
+				Array * old = m_array.load( std::memory_order_relaxed );
+				Array * array = new Array( new_size_ );
+
+				for( size_t b = 0 ; b < old->size ; b++ )
+				{
+					for( Node * n = old->buckets[b].load( std::memory_order_relaxed ) ; n != nullptr ; n = n->next.load( std::memory_order_relaxed ) )
+					{
+						Node * copy = new Node( n->key, n->data, n->hash );
+						Link & head = array->buckets[ array->reduce( n->hash ) ];
+						copy->next.store( head.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+						head.store( copy, std::memory_order_relaxed );
+					}
+				}
+
+				m_array.store( array, std::memory_order_release );
+
+				for( size_t b = 0 ; b < old->size ; b++ )
+					for( Node * n = old->buckets[b].load( std::memory_order_relaxed ) ; n != nullptr ; n = n->next.load( std::memory_order_relaxed ) )
+						retire( n );
+				m_retired_arrays.emplace_back( m_epoch.load(), old );
+				reclaim();
+			}
+
+			/// Stamps node_, already unlinked, with the current epoch, to be freed by a later reclaim().
+			void retire( Node * node_ )
+			{ m_retired_nodes.emplace_back( m_epoch.load(), node_ ); }
+
+			/// Starts a new epoch, then frees whatever was retired before the oldest epoch a reader is still in. Frees nothing while an overflowed reader, of unknown epoch, is inside.
+			void reclaim( void )
+			{
+				m_epoch.fetch_add( 1 );
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+
+				if( m_overflow.load( std::memory_order_acquire ) != 0 )
+					return;
+
+				uint64_t oldest = std::numeric_limits< uint64_t >::max();
+				for( size_t i = 0 ; i < READER_SLOTS ; i++ )
+				{
+					uint64_t e = m_readers[i].epoch.load();
+					if( e != 0 and e < oldest )
+						oldest = e;
+				}
+
+				free_retired( m_retired_nodes, oldest );
+				free_retired( m_retired_arrays, oldest );
+			}
+
+			/// Frees the entries of retired_ stamped before epoch_.
+			template < typename T >
+			static void free_retired( std::vector< std::pair< uint64_t, T* > > & retired_, uint64_t epoch_ )
+			{
+				size_t kept = 0;
+				for( auto & r : retired_ )
+				{
+					if( r.first < epoch_ )
+						delete r.second;
+					else
+						retired_[ kept++ ] = r;
+				}
+				retired_.resize( kept );
+			}
+
+			/// Frees every node linked in array_.
+			static void free_nodes( Array * array_ )
+			{
+				for( size_t b = 0 ; b < array_->size ; b++ )
+				{
+					Node * n = array_->buckets[b].load( std::memory_order_relaxed );
+					while( n != nullptr )
+					{
+						Node * next = n->next.load( std::memory_order_relaxed );
+						delete n;
+						n = next;
+					}
+				}
+			}
+
+			static const size_t READER_SLOTS = 64; //!< Readers that can be inside the table with their own slot.
+			static const short DEFAULT_SIZE = 11;
+
+			std::atomic< Array* > m_array { nullptr }; //!< Current bucket array.
+			std::atomic< size_t > m_count { 0 }; //!< Number of elements on the table.
+			mutable std::atomic< uint64_t > m_epoch { 1 }; //!< Global epoch, 0 is reserved for free reader slots.
+			mutable ReaderSlot m_readers[ READER_SLOTS ]; //!< Epoch of every reader inside the table.
+			mutable std::atomic< size_t > m_overflow { 0 }; //!< Readers inside the table that found no free slot.
+			std::mutex m_write; //!< Serializes the writers.
+			std::vector< std::pair< uint64_t, Node* > > m_retired_nodes; //!< Unlinked nodes and their retirement epoch.
+			std::vector< std::pair< uint64_t, Array* > > m_retired_arrays; //!< Replaced arrays and their retirement epoch.
+
+	}; // ReadMostlyHashTbl Class
+} // ac Namespace
+#endif
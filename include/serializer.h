@@ -0,0 +1,272 @@
+#ifndef SERIALIZER_H
+#define SERIALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/// 64 bit FNV-1a checksum of n_ bytes from p_, continued from state_.
+	inline uint64_t fnv1a( uint64_t state_, const void * p_, size_t n_ )
+	{
+		const unsigned char * bytes = static_cast< const unsigned char* >( p_ );
+		for( size_t i = 0 ; i < n_ ; i++ )
+		{
+			state_ ^= bytes[i];
+			state_ *= 0x100000001b3ULL;
+		}
+		return state_;
+	}
+
+	inline constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL; //!< Initial state of an fnv1a() checksum.
+
+	template < typename T, typename = void >
+	struct serializer;
+
+	/*! \class stream_writer
+		\brief Output stream of a save(), checksumming every byte written through it.
+
+	*/
+	class stream_writer
+	{
+		public:
+			explicit stream_writer( std::ostream & out_ ) : m_out( out_ )
+			{  }
+
+			/// Writes n_ raw bytes from p_.
+			void bytes( const void * p_, size_t n_ )
+			{
+				m_out.write( static_cast< const char* >( p_ ), n_ );
+				m_checksum = fnv1a( m_checksum, p_, n_ );
+			}
+
+			/// Writes v_ with its serializer.
+			template < typename T >
+			void value( const T & v_ )
+			{ serializer< T >::write( *this, v_ ); }
+
+			/// Writes the checksum of everything written since the last seal(), and starts a new one.
+			void seal( void )
+			{
+				uint64_t sum = m_checksum;
+				m_out.write( reinterpret_cast< const char* >( &sum ), sizeof( sum ) );
+				m_checksum = FNV_OFFSET;
+			}
+
+			/// Throws std::runtime_error if a write failed.
+			void check( void ) const
+			{
+				if( not m_out )
+					throw std::runtime_error( "save: can't write to the stream" );
+			}
+
+		private:
+			std::ostream & m_out;
+			uint64_t m_checksum = FNV_OFFSET; //!< Checksum of the bytes written since the last seal().
+	};
+
+	/*! \class stream_reader
+		\brief Input stream of a load(), checksumming every byte read through it.
+
+	*/
+	class stream_reader
+	{
+		public:
+			explicit stream_reader( std::istream & in_ ) : m_in( in_ )
+			{  }
+
+			/// Reads n_ raw bytes into p_. Throws std::runtime_error if the stream ends first.
+			void bytes( void * p_, size_t n_ )
+			{
+				if( not m_in.read( static_cast< char* >( p_ ), n_ ) )
+					throw std::runtime_error( "load: stream ended too early" );
+				m_checksum = fnv1a( m_checksum, p_, n_ );
+			}
+
+			/// Reads v_ with its serializer.
+			template < typename T >
+			void value( T & v_ )
+			{ serializer< T >::read( *this, v_ ); }
+
+			/// Reads the checksum written by stream_writer::seal() and throws std::runtime_error unless it matches everything read since the last unseal().
+			void unseal( void )
+			{
+				uint64_t sum = 0, expected = m_checksum;
+				if( not m_in.read( reinterpret_cast< char* >( &sum ), sizeof( sum ) ) )
+					throw std::runtime_error( "load: stream ended too early" );
+				if( sum != expected )
+					throw std::runtime_error( "load: checksum mismatch, the stream is corrupted" );
+				m_checksum = FNV_OFFSET;
+			}
+
+		private:
+			std::istream & m_in;
+			uint64_t m_checksum = FNV_OFFSET; //!< Checksum of the bytes read since the last unseal().
+	};
+
+	/// True for std::tuple and std::pair, which are serialized member by member.
+	template < typename T >
+	struct is_serial_tuple : std::false_type {};
+
+	template < typename... Ts >
+	struct is_serial_tuple< std::tuple< Ts... > > : std::true_type {};
+
+	template < typename A, typename B >
+	struct is_serial_tuple< std::pair< A, B > > : std::true_type {};
+
+	/*! \struct serializer
+		\brief How save() writes, and load() reads back, a key or data type.
+
+		write( out, v ) and read( in, v ) go through the stream_writer and stream_reader, so
+		everything is checksummed. Provided for trivially copyable types other than pointers,
+		std::string and std::tuple or std::pair of supported types; specialize it for other
+		types, e.g. by calling value() on each member.
+	*/
+	template < typename T >
+	struct serializer< T, typename std::enable_if< std::is_trivially_copyable< T >::value and not is_serial_tuple< T >::value >::type >
+	{
+		static_assert( not std::is_pointer< T >::value and not std::is_member_pointer< T >::value,
+		               "serializer<T>: T is a pointer type, whose address can't be saved; specialize serializer for it" );
+
+		static void write( stream_writer & out_, const T & v_ )
+		{ out_.bytes( &v_, sizeof( T ) ); }
+
+		static void read( stream_reader & in_, T & v_ )
+		{ in_.bytes( &v_, sizeof( T ) ); }
+	};
+
+	/// Strings are written as their length, then their characters.
+	template < >
+	struct serializer< std::string >
+	{
+		static void write( stream_writer & out_, const std::string & v_ )
+		{
+			uint64_t length = v_.size();
+			out_.bytes( &length, sizeof( length ) );
+			out_.bytes( v_.data(), v_.size() );
+		}
+
+		static void read( stream_reader & in_, std::string & v_ )
+		{
+			uint64_t length = 0;
+			in_.bytes( &length, sizeof( length ) );
+			v_.clear();
+
+			// Grown a piece at a time, so a corrupted length fails at the end of the stream instead of allocating it all first.
+			const uint64_t PIECE = 1 << 16;
+			while( length > 0 )
+			{
+				size_t n = static_cast< size_t >( length < PIECE ? length : PIECE );
+				size_t old = v_.size();
+				v_.resize( old + n );
+				in_.bytes( &v_[old], n );
+				length -= n;
+			}
+		}
+	};
+
+	/// Tuples and pairs are written member after member.
+	template < typename T >
+	struct serializer< T, typename std::enable_if< is_serial_tuple< T >::value >::type >
+	{
+		static void write( stream_writer & out_, const T & v_ )
+		{ std::apply( [&out_]( const auto &... m_ ) { ( out_.value( m_ ), ... ); }, v_ ); }
+
+		static void read( stream_reader & in_, T & v_ )
+		{ std::apply( [&in_]( auto &... m_ ) { ( in_.value( m_ ), ... ); }, v_ ); }
+	};
+
+	/*! \struct StreamHeader
+		\brief First bytes written by save(), followed by their own checksum.
+
+		Then come the count entries, key then data, in the table's iteration order, which is
+		bucket by bucket, followed by the checksum of all the entries.
+	*/
+	struct StreamHeader
+	{
+		char magic[8]; //!< STREAM_MAGIC.
+		uint32_t version; //!< STREAM_VERSION of the writer.
+		uint32_t byte_order; //!< STREAM_BYTE_ORDER as the writer saw it.
+		uint64_t count; //!< Number of entries.
+		float max_load; //!< max_load_factor() of the saved table.
+		float min_load; //!< min_load_factor() of the saved table.
+	};
+
+	inline constexpr char STREAM_MAGIC[8] = "ACHTSTM"; //!< Identifies streams written by save().
+	inline constexpr uint32_t STREAM_VERSION = 1; //!< Bumped whenever the format changes; other versions are rejected.
+	inline constexpr uint32_t STREAM_BYTE_ORDER = 0x01020304; //!< Read back differently on a machine of the other endianness.
+
+	/// Writes every entry of tbl_ to out_, straight from the table, one bucket after the other. Keys and data are written by their serializer. Throws std::runtime_error if the stream fails.
+	template < typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename StoragePolicy, typename SizePolicy, typename HashPolicy, typename Allocator, typename StatsPolicy >
+	void save( const HashTbl< KeyType, DataType, KeyHash, KeyEqual, StoragePolicy, SizePolicy, HashPolicy, Allocator, StatsPolicy > & tbl_, std::ostream & out_ )
+	{
+		StreamHeader header{};
+		std::memcpy( header.magic, STREAM_MAGIC, sizeof( header.magic ) );
+		header.version = STREAM_VERSION;
+		header.byte_order = STREAM_BYTE_ORDER;
+		header.count = tbl_.size();
+		header.max_load = tbl_.max_load_factor();
+		header.min_load = tbl_.min_load_factor();
+
+		stream_writer out( out_ );
+		out.bytes( &header, sizeof( header ) );
+		out.seal();
+
+		for( const auto & e : tbl_ )
+		{
+			out.value( e.m_key );
+			out.value( e.m_data );
+		}
+		out.seal();
+		out.check();
+	}
+
+	/// Replaces the contents of tbl_ with the entries written by save() to in_. The header is checked first, then the table is sized for all the entries at once, so none of the insertions rehashes. Throws std::runtime_error if the stream is not a compatible one, ends too early or fails its checksums: a rejected header leaves tbl_ untouched, a failure past it leaves tbl_ empty.
+	template < typename KeyType, typename DataType, typename KeyHash, typename KeyEqual, typename StoragePolicy, typename SizePolicy, typename HashPolicy, typename Allocator, typename StatsPolicy >
+	void load( HashTbl< KeyType, DataType, KeyHash, KeyEqual, StoragePolicy, SizePolicy, HashPolicy, Allocator, StatsPolicy > & tbl_, std::istream & in_ )
+	{
+		stream_reader in( in_ );
+		StreamHeader header;
+		in.bytes( &header, sizeof( header ) );
+		in.unseal();
+
+		if( std::memcmp( header.magic, STREAM_MAGIC, sizeof( header.magic ) ) != 0 or header.version != STREAM_VERSION
+			or header.byte_order != STREAM_BYTE_ORDER )
+			throw std::runtime_error( "load: not a compatible HashTbl stream" );
+
+		// Nothing was changed yet: from here on, a failure empties the table instead of leaving it half loaded.
+		tbl_.clear();
+		try
+		{
+			tbl_.max_load_factor( header.max_load );
+			tbl_.reserve( header.count );
+
+			for( uint64_t i = 0 ; i < header.count ; i++ )
+			{
+				KeyType k{};
+				DataType d{};
+				in.value( k );
+				in.value( d );
+				tbl_.insert( std::move( k ), std::move( d ) );
+			}
+			in.unseal();
+			tbl_.min_load_factor( header.min_load );
+		}
+		catch( ... )
+		{
+			tbl_.clear();
+			throw;
+		}
+	}
+} // ac Namespace
+#endif
@@ -0,0 +1,280 @@
+#ifndef SIZE_POLICY_H
+#define SIZE_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <math.h>
+
+/*! \file size_policy.h
+	\brief Policies deciding which table sizes are valid and how a hash is reduced to a bucket.
+
+	A size policy is a type with:
+	- static capacity( n ): the smallest valid table size that is at least n.
+	- a nested reducer class, built from a size returned by capacity() whenever the table
+	  is resized, whose operator()( hash ) returns the bucket in [0, size) for a hash.
+	  Anything that only depends on the size is worked out once in the reducer constructor.
+*/
+namespace ac
+{
+	/// Function used to find the first prime equal or greater than the size given to build the hashtable.
+	inline size_t next_prime( size_t num )
+	{
+		if( num == 0 or num == 1)
+			return num;
+
+		while( true )
+		{
+			int numdiv = 0;
+			for( size_t i = 2 ; i <= (size_t)sqrt(num) ; i++ )
+				if( num % i == 0 )
+					numdiv++;
+
+			if( numdiv == 0 )
+				return num;
+			else
+				num++;
+		}
+	}
+
+	/// Finalizer of MurmurHash3: every input bit affects every output bit, so weak hashes (e.g. the identity) stop clustering.
+	inline uint64_t mix_hash( uint64_t h_ )
+	{
+		h_ ^= h_ >> 33;
+		h_ *= 0xff51afd7ed558ccdULL;
+		h_ ^= h_ >> 33;
+		h_ *= 0xc4ceb9fe1a85ec53ULL;
+		h_ ^= h_ >> 33;
+
+		return h_;
+	}
+
+	/// High half of the 128-bit product a_ * b_.
+	inline uint64_t mul_high( uint64_t a_, uint64_t b_ )
+	{
+#if defined(__SIZEOF_INT128__)
+		return static_cast< uint64_t >( ( static_cast< unsigned __int128 >( a_ ) * b_ ) >> 64 );
+#else
+		uint64_t a_lo = a_ & 0xFFFFFFFFu, a_hi = a_ >> 32;
+		uint64_t b_lo = b_ & 0xFFFFFFFFu, b_hi = b_ >> 32;
+
+		uint64_t lo_lo = a_lo * b_lo;
+		uint64_t hi_lo = a_hi * b_lo;
+		uint64_t lo_hi = a_lo * b_hi;
+		uint64_t cross = ( lo_lo >> 32 ) + ( hi_lo & 0xFFFFFFFFu ) + lo_hi;
+
+		return a_hi * b_hi + ( hi_lo >> 32 ) + ( cross >> 32 );
+#endif
+	}
+
+	/*! \struct prime_size
+		\brief Prime table sizes, hash reduced with the modulo operator (default).
+
+	*/
+	struct prime_size
+	{
+		static size_t capacity( size_t n_ )
+		{ return next_prime( n_ ); }
+
+		/// Maps a hash to one of size buckets.
+		class reducer
+		{
+			public:
+				explicit reducer( size_t size_ = 1 ) : m_size( size_ )
+				{  }
+
+				size_t operator()( size_t hash_ ) const
+				{ return hash_ % m_size; }
+
+			private:
+				size_t m_size;
+		};
+	};
+
+	/*! \struct power_of_two_size
+		\brief Power of two table sizes, mixed hash reduced with a bit mask.
+
+		The mask keeps only the low bits of the hash, so the hash is mixed first.
+	*/
+	struct power_of_two_size
+	{
+		static size_t capacity( size_t n_ )
+		{
+			size_t size = 1;
+			while( size < n_ )
+				size <<= 1;
+			return size;
+		}
+
+		/// Maps a hash to one of size buckets.
+		class reducer
+		{
+			public:
+				explicit reducer( size_t size_ = 1 ) : m_mask( size_ - 1 )
+				{  }
+
+				size_t operator()( size_t hash_ ) const
+				{ return static_cast< size_t >( mix_hash( hash_ ) & m_mask ); }
+
+			private:
+				size_t m_mask;
+		};
+	};
+
+	/*! \struct fast_range_size
+		\brief Any table size, mixed hash reduced with Lemire's multiply-shift ( hash * size ) >> 64.
+
+		The reduction uses the high bits of the hash, so the hash is mixed first.
+	*/
+	struct fast_range_size
+	{
+		static size_t capacity( size_t n_ )
+		{ return n_ == 0 ? 1 : n_; }
+
+		/// Maps a hash to one of size buckets.
+		class reducer
+		{
+			public:
+				explicit reducer( size_t size_ = 1 ) : m_size( size_ )
+				{  }
+
+				size_t operator()( size_t hash_ ) const
+				{ return static_cast< size_t >( mul_high( mix_hash( hash_ ), m_size ) ); }
+
+			private:
+				size_t m_size;
+		};
+	};
+
+	/*! \namespace ac::primes
+		\brief Compile-time table of growth primes used by prime_table_size.
+
+	*/
+	namespace primes
+	{
+		/// A growth prime and its fastmod reciprocal.
+		struct entry
+		{
+			uint64_t prime;
+			uint64_t magic;
+		};
+
+		/// Every growth prime, smallest first.
+		template < size_t N >
+		struct table
+		{
+			entry entries[ N ];
+		};
+
+		constexpr uint64_t FIRST = 5; //!< Smallest table size.
+		constexpr uint64_t LIMIT = 0xFFFFFFFFull; //!< fastmod only holds for 32-bit divisors.
+
+		constexpr bool is_prime( uint64_t n_ )
+		{
+			if( n_ < 2 )
+				return false;
+			if( n_ % 2 == 0 )
+				return n_ == 2;
+			for( uint64_t d = 3 ; d * d <= n_ ; d += 2 )
+				if( n_ % d == 0 )
+					return false;
+			return true;
+		}
+
+		constexpr uint64_t at_least( uint64_t n_ )
+		{
+			while( not is_prime( n_ ) )
+				n_++;
+			return n_;
+		}
+
+		/// fastmod reciprocal M = floor( ( 2^64 - 1 ) / d ) + 1.
+		constexpr uint64_t magic_for( uint64_t d_ )
+		{ return 0xFFFFFFFFFFFFFFFFull / d_ + 1; }
+
+		/// Number of growth primes: FIRST, then the first prime after twice the previous one, up to LIMIT.
+		constexpr size_t count()
+		{
+			size_t n = 0;
+			for( uint64_t p = FIRST ; p <= LIMIT ; p = at_least( 2 * p ) )
+				n++;
+			return n;
+		}
+
+		constexpr size_t COUNT = count();
+
+		template < size_t N >
+		constexpr table< N > make_table()
+		{
+			table< N > t{};
+			uint64_t p = FIRST;
+			for( size_t i = 0 ; i < N ; i++ )
+			{
+				t.entries[i] = entry{ p, magic_for( p ) };
+				p = at_least( 2 * p );
+			}
+			return t;
+		}
+
+		/// The table, generated by the compiler.
+		inline const table< COUNT > & growth()
+		{
+			static constexpr table< COUNT > generated = make_table< COUNT >();
+			return generated;
+		}
+
+		/// Entry of the smallest growth prime not below n_, or the largest one.
+		inline const entry & entry_for( size_t n_ )
+		{
+			const entry * first = growth().entries;
+			const entry * last = first + COUNT - 1;
+
+			while( first != last )
+			{
+				const entry * mid = first + ( last - first ) / 2;
+				if( mid->prime < n_ )
+					first = mid + 1;
+				else
+					last = mid;
+			}
+			return *first;
+		}
+	} // primes Namespace
+
+	/*! \struct prime_table_size
+		\brief Growth primes from a compile-time table, hash reduced without any division.
+
+		Sizes are the roughly doubling primes of ac::primes, each stored next to its fastmod
+		reciprocal M. With it, a % p is the high half of ( ( M * a ) mod 2^64 ) * p, exact for
+		any 32-bit a (Lemire, Kaser and Kurz, "Faster Remainder by Direct Computation"), so the
+		hash is folded to 32 bits first. Picking a size is a search in the table instead of
+		trial division. Sizes stop at the largest prime below 2^32.
+	*/
+	struct prime_table_size
+	{
+		static size_t capacity( size_t n_ )
+		{ return static_cast< size_t >( primes::entry_for( n_ ).prime ); }
+
+		/// Maps a hash to one of size buckets.
+		class reducer
+		{
+			public:
+				explicit reducer( size_t size_ = 1 ) : m_size( size_ )
+				{
+					const primes::entry & e = primes::entry_for( size_ );
+					m_magic = ( e.prime == size_ ) ? e.magic : primes::magic_for( size_ );
+				}
+
+				size_t operator()( size_t hash_ ) const
+				{
+					uint64_t h = static_cast< uint64_t >( hash_ );
+					uint32_t folded = static_cast< uint32_t >( h ^ ( h >> 32 ) );
+					return static_cast< size_t >( mul_high( m_magic * folded, m_size ) );
+				}
+
+			private:
+				uint64_t m_size;
+				uint64_t m_magic;
+		};
+	};
+} // ac Namespace
+#endif
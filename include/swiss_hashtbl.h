@@ -0,0 +1,829 @@
+#ifndef SWISS_HASH_H
+#define SWISS_HASH_H
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <new>
+
+#if defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 )
+#include <emmintrin.h>
+#define AC_SWISS_SSE2 1
+#endif
+
+#include "hashtbl.h"
+
+namespace ac
+{
+	/*! \namespace ac::swiss
+		\brief Control byte helpers used by the swiss_table storage.
+
+	*/
+	namespace swiss
+	{
+		typedef int8_t ctrl_t; //!< One control byte: a 7-bit hash fragment, or one of the markers below.
+
+		static const ctrl_t EMPTY = -128; //!< 0b10000000: slot never used since the last rehash.
+		static const ctrl_t DELETED = -2; //!< 0b11111110: tombstone, the slot may be part of some probe sequence.
+		static const size_t GROUP_WIDTH = 16; //!< Number of slots probed at once.
+
+		/// Index of the lowest set bit of a non-zero mask.
+		inline unsigned lowest_bit( uint32_t mask )
+		{
+#if defined(__GNUC__)
+			return __builtin_ctz( mask );
+#else
+			unsigned i = 0;
+			while( ( mask & 1u ) == 0 )
+			{
+				mask >>= 1;
+				i++;
+			}
+			return i;
+#endif
+		}
+
+		/*! \struct Group
+			\brief GROUP_WIDTH control bytes loaded at once; every query returns one bit per matching slot.
+
+		*/
+		struct Group
+		{
+#if defined(AC_SWISS_SSE2)
+			__m128i ctrl;
+
+			explicit Group( const ctrl_t * pos_ )
+				: ctrl( _mm_loadu_si128( reinterpret_cast< const __m128i* >( pos_ ) ) )
+			{  }
+
+			/// Slots whose control byte is equal to the hash fragment h2_.
+			uint32_t match( ctrl_t h2_ ) const
+			{ return static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_set1_epi8( h2_ ), ctrl ) ) ); }
+
+			/// Slots that are EMPTY.
+			uint32_t match_empty( void ) const
+			{ return match( EMPTY ); }
+
+			/// Slots that are EMPTY or DELETED, the only control bytes below -1.
+			uint32_t match_empty_or_deleted( void ) const
+			{ return static_cast< uint32_t >( _mm_movemask_epi8( _mm_cmpgt_epi8( _mm_set1_epi8( -1 ), ctrl ) ) ); }
+
+			/// Slots holding an entry.
+			uint32_t match_full( void ) const
+			{ return static_cast< uint32_t >( _mm_movemask_epi8( ctrl ) ) ^ 0xFFFFu; }
+#else
+			ctrl_t ctrl[ GROUP_WIDTH ];
+
+			explicit Group( const ctrl_t * pos_ )
+			{ std::memcpy( ctrl, pos_, GROUP_WIDTH ); }
+
+			/// Slots whose control byte is equal to the hash fragment h2_.
+			uint32_t match( ctrl_t h2_ ) const
+			{
+				uint32_t mask = 0;
+				for( size_t i = 0 ; i < GROUP_WIDTH ; i++ )
+					if( ctrl[i] == h2_ )
+						mask |= 1u << i;
+				return mask;
+			}
+
+			/// Slots that are EMPTY.
+			uint32_t match_empty( void ) const
+			{ return match( EMPTY ); }
+
+			/// Slots that are EMPTY or DELETED, the only control bytes below -1.
+			uint32_t match_empty_or_deleted( void ) const
+			{
+				uint32_t mask = 0;
+				for( size_t i = 0 ; i < GROUP_WIDTH ; i++ )
+					if( ctrl[i] < -1 )
+						mask |= 1u << i;
+				return mask;
+			}
+
+			/// Slots holding an entry.
+			uint32_t match_full( void ) const
+			{ return match_empty_or_deleted() ^ 0xFFFFu; }
+#endif
+		};
+	} // swiss Namespace
+
+	/*! \class HashTbl< KeyType, DataType, KeyHash, KeyEqual, swiss_table, SizePolicy, HashPolicy >
+		\brief Swiss table version of the HashTbl.
+
+		Besides the flat entry array, the table keeps one control byte per slot holding
+		the low 7 bits of the key's hash (or an EMPTY/DELETED marker). Slots are probed
+		GROUP_WIDTH at a time: one SIMD compare of the control bytes against the key's
+		fragment yields the few candidates worth a KeyEqual call, and a group containing
+		an EMPTY slot ends the search. The capacity is always a power of two, whatever
+		the SizePolicy, and the hash is always mixed.
+	*/
+	template < typename KeyType,
+			   typename DataType,
+			   typename KeyHash,
+			   typename KeyEqual,
+			   typename SizePolicy,
+			   typename HashPolicy,
+			   typename Allocator,
+			   typename StatsPolicy >
+	class HashTbl< KeyType, DataType, KeyHash, KeyEqual, swiss_table, SizePolicy, HashPolicy, Allocator, StatsPolicy >
+		: public table_base< HashTbl< KeyType, DataType, KeyHash, KeyEqual, swiss_table, SizePolicy, HashPolicy, Allocator, StatsPolicy >,
+							 KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >
+	{
+		using Base = table_base< HashTbl, KeyType, DataType, KeyHash, KeyEqual, HashPolicy, Allocator, StatsPolicy >; //!< Shared interface, built on the primitives below.
+		friend Base;
+
+		public:
+			using Entry = typename Base::Entry; //!< Alias
+
+			template < typename K >
+			using lookup_key = typename Base::template lookup_key< K >; //!< Alias
+
+			/*! \class basic_iterator
+				\brief Forward iterator over the entries, slot by slot in memory order.
+
+				Any insertion may rehash the table and invalidate every iterator; erasing only invalidates the erased entry's, unless a min_load_factor() makes it shrink the table.
+			*/
+			template < bool Const >
+			class basic_iterator
+			{
+				friend class HashTbl;
+				friend class basic_iterator< not Const >;
+
+				using Table = typename std::conditional< Const, const HashTbl, HashTbl >::type;
+
+				public:
+					using iterator_category = std::forward_iterator_tag;
+					using value_type = Entry;
+					using difference_type = std::ptrdiff_t;
+					using pointer = typename std::conditional< Const, const Entry *, Entry * >::type;
+					using reference = typename std::conditional< Const, const Entry &, Entry & >::type;
+
+					basic_iterator( void ) = default;
+
+					/// An iterator converts to a const_iterator.
+					template < bool C, typename = typename std::enable_if< Const and not C >::type >
+					basic_iterator( const basic_iterator< C > & other ) : m_tbl( other.m_tbl ), m_pos( other.m_pos )
+					{  }
+
+					reference operator*( void ) const
+					{ return m_tbl->entry_at( m_pos ); }
+
+					pointer operator->( void ) const
+					{ return &m_tbl->entry_at( m_pos ); }
+
+					basic_iterator& operator++( void )
+					{
+						m_pos++;
+						skip_empty();
+						return *this;
+					}
+
+					basic_iterator operator++( int )
+					{
+						basic_iterator old( *this );
+						++( *this );
+						return old;
+					}
+
+					template < bool C >
+					bool operator==( const basic_iterator< C > & other ) const
+					{ return m_pos == other.m_pos; }
+
+					template < bool C >
+					bool operator!=( const basic_iterator< C > & other ) const
+					{ return not ( *this == other ); }
+
+				private:
+					basic_iterator( Table * tbl_, size_t pos_ ) : m_tbl( tbl_ ), m_pos( pos_ )
+					{  }
+
+					/// Moves to the first full slot at or after the current one, or to the end.
+					void skip_empty( void )
+					{
+						while( m_pos < m_tbl->m_size and m_tbl->m_ctrl[m_pos] < 0 )
+							m_pos++;
+					}
+
+					Table * m_tbl = nullptr;
+					size_t m_pos = 0u; //!< Slot index, m_size at the end.
+			};
+
+			using iterator = basic_iterator< false >; //!< Alias
+			using const_iterator = basic_iterator< true >; //!< Alias
+
+			//== Constructors
+			/// Constructor with a defined size. The control bytes and slots come from alloc_.
+			HashTbl( size_t tbl_size_ = DEFAULT_SIZE, const Allocator & alloc_ = Allocator() ) : m_alloc( alloc_ )
+			{
+				allocate( capacity_for( tbl_size_ ) );
+			}
+
+			/// Constructor with the default size and an allocator.
+			explicit HashTbl( const Allocator & alloc_ ) : HashTbl( DEFAULT_SIZE, alloc_ )
+			{  }
+
+			/// Default destructor.
+			virtual ~HashTbl()
+			{
+				clear();
+				release( m_ctrl, m_slots, m_size );
+			}
+
+			/// Copy constructor. The allocator is obtained as for the standard containers, from select_on_container_copy_construction().
+			HashTbl( const HashTbl& other )
+				: m_alloc( std::allocator_traits< Allocator >::select_on_container_copy_construction( other.m_alloc ) ),
+				  m_max_load( other.m_max_load ), m_min_load( other.m_min_load )
+			{
+				allocate( other.m_size );
+				copy_slots( other );
+			}
+
+			/// Move constructor. Takes over the slots and the allocator of other, which is left empty and without slots until its next insertion.
+			HashTbl( HashTbl&& other ) noexcept : m_alloc( other.m_alloc )
+			{
+				swap_contents( other );
+			}
+
+			/// Range constructor: builds the table from [first_, last_), whose elements are entries or key/data pairs. With forward iterators the range is counted first and the table allocated once, at its final size. A key appearing twice keeps its last data, as with insert().
+			template < typename InputIt, typename = require_iterator< InputIt > >
+			HashTbl( InputIt first_, InputIt last_, const Allocator & alloc_ = Allocator() )
+				: HashTbl( initial_size( range_length( first_, last_ ) ), alloc_ )
+			{
+				this->insert( first_, last_ );
+			}
+
+			/// std::initializer_list copy constructor.
+			HashTbl( std::initializer_list < Entry > ilist, const Allocator & alloc_ = Allocator() )
+				: HashTbl( ilist.begin(), ilist.end(), alloc_ )
+			{  }
+
+			//=== Operators
+			/// Operator = overload for HashTbl objects.
+			HashTbl& operator=( const HashTbl & other )
+			{
+				if( this == &other )
+					return *this;
+
+				clear();
+				release( m_ctrl, m_slots, m_size );
+				if constexpr ( std::allocator_traits< Allocator >::propagate_on_container_copy_assignment::value )
+					m_alloc = other.m_alloc;
+				m_max_load = other.m_max_load;
+				m_min_load = other.m_min_load;
+				allocate( other.m_size );
+				copy_slots( other );
+
+				return *this;
+			}
+
+			/// Move assignment, see table_base::move_assign().
+			HashTbl& operator=( HashTbl && other )
+				noexcept( std::allocator_traits< Allocator >::propagate_on_container_move_assignment::value )
+			{
+				if( this != &other )
+					this->move_assign( other );
+				return *this;
+			}
+
+			/// Operator = overload for std::initializer_list
+			HashTbl& operator=( std::initializer_list < Entry > ilist )
+			{
+				clear();
+				this->insert( ilist.begin(), ilist.end() );
+
+				return *this;
+			}
+
+			//=== Methods
+			/// Removes from the table an item identified by its k_ key. If the key is found, this method returns true, otherwise it returns false.
+			bool erase ( const KeyType & k_ )
+			{ return erase< KeyType >( k_ ); }
+
+			/// Same as the erase() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			bool erase ( const K & k_ )
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+
+				if( pos == npos )
+					return false;
+
+				entry( pos ).~Entry();
+
+				// If the group still has an EMPTY slot no probe sequence ever went past it, so the
+				// slot can go back to EMPTY. Otherwise leave a tombstone to keep later keys reachable.
+				size_t group = pos & ~( swiss::GROUP_WIDTH - 1 );
+				if( swiss::Group( m_ctrl + group ).match_empty() )
+				{
+					m_ctrl[pos] = swiss::EMPTY;
+					m_growth_left++;
+				}
+				else
+					m_ctrl[pos] = swiss::DELETED;
+
+				m_count--;
+				shrink_if_sparse();
+				return true;
+			}
+
+			/// Looks up the n_ keys of keys_ in one go. Keys are hashed and the control bytes of their first group prefetched 2 * PREFETCH_DISTANCE keys ahead of the one being searched, then the slot of their first fragment match PREFETCH_DISTANCE keys ahead, so the cache misses of successive keys overlap instead of being paid one after the other. For each keys_[i] found, its data is copied to data_[i]; found_[i], unless found_ is nullptr, tells whether keys_[i] was found. Returns the number of keys found.
+			size_t retrieve_many ( const KeyType * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{ return retrieve_many< KeyType >( keys_, n_, data_, found_ ); }
+
+			/// Same as the retrieve_many() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t retrieve_many ( const K * keys_, size_t n_, DataType * data_, bool * found_ = nullptr ) const
+			{
+				const size_t ring = 2 * PREFETCH_DISTANCE;
+				size_t hashes[ ring ];
+				size_t found = 0;
+
+				if( m_count == 0 )
+				{
+					if( found_ != nullptr )
+						std::fill( found_, found_ + n_, false );
+					this->count_lookups( 0, n_ );
+					return 0;
+				}
+
+				auto prefetch_ctrl = [&]( size_t j_ )
+				{
+					size_t r = j_ % ring;
+					hashes[r] = hash_of( keys_[j_] );
+					prefetch( m_ctrl + home_group( hashes[r] ) );
+				};
+
+				auto prefetch_slot = [&]( size_t j_ )
+				{
+					size_t hash = hashes[ j_ % ring ];
+					size_t group = home_group( hash );
+					uint32_t match = swiss::Group( m_ctrl + group ).match( fragment( hash ) );
+					if( match != 0 )
+						prefetch( &m_slots[ group + swiss::lowest_bit( match ) ] );
+				};
+
+				for( size_t j = 0 ; j < ring and j < n_ ; j++ )
+					prefetch_ctrl( j );
+				for( size_t j = 0 ; j < PREFETCH_DISTANCE and j < n_ ; j++ )
+					prefetch_slot( j );
+
+				for( size_t i = 0 ; i < n_ ; i++ )
+				{
+					size_t pos = find_slot( keys_[i], hashes[ i % ring ] );
+					if( pos != npos )
+					{
+						data_[i] = entry( pos ).m_data;
+						found++;
+					}
+					if( found_ != nullptr )
+						found_[i] = ( pos != npos );
+
+					if( i + PREFETCH_DISTANCE < n_ )
+						prefetch_slot( i + PREFETCH_DISTANCE );
+					if( i + ring < n_ )
+						prefetch_ctrl( i + ring );
+				}
+
+				this->count_lookups( found, n_ - found );
+				return found;
+			}
+
+			/// Clears all memory associated to the Hashtable's slots, removing all it's elements.
+			void clear ( void )
+			{
+				if( m_size == 0 )
+					return;
+
+				for( size_t i = 0 ; i < m_size ; i++ )
+					if( m_ctrl[i] >= 0 )
+						entry( i ).~Entry();
+
+				std::memset( m_ctrl, static_cast< unsigned char >( swiss::EMPTY ), m_size );
+				m_count = 0;
+				m_growth_left = max_load( m_size );
+			}
+
+			/// Sets the number of slots to the power of two at least n_, and at least the number needed to keep size() entries under max_load_factor(). Shrinks the table if that is less than bucket_count(); tombstones are dropped in any case.
+			void rehash( size_t n_ )
+			{
+				size_t new_size = capacity_for( m_count );
+				while( new_size < n_ )
+					new_size *= 2;
+
+				if( new_size != m_size or m_growth_left + m_count != max_load( m_size ) )
+					resize( new_size );
+			}
+
+			/// Makes room for n_ entries, so inserting up to n_ entries triggers no rehash.
+			void reserve( size_t n_ )
+			{
+				size_t needed = capacity_for( n_ );
+				if( needed > m_size )
+					resize( needed );
+			}
+
+			/// Returns the number of elements stored in the first group probed for the k_ key.
+			size_t count( const KeyType& k_ ) const
+			{ return count< KeyType >( k_ ); }
+
+			/// Same as the count() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			size_t count( const K& k_ ) const
+			{
+				size_t counter = 0u;
+
+				if( m_size == 0 )
+					return counter;
+
+				uint32_t full = swiss::Group( m_ctrl + home_group( hash_of( k_ ) ) ).match_full();
+
+				for( ; full != 0 ; full &= full - 1 )
+					counter++;
+
+				return counter;
+			}
+
+			/// Returns an iterator to the first entry, or end() if the table is empty.
+			iterator begin( void )
+			{ return first< iterator >( this ); }
+
+			/// Returns the past-the-end iterator.
+			iterator end( void )
+			{ return iterator( this, m_size ); }
+
+			/// Returns a const_iterator to the first entry, or end() if the table is empty.
+			const_iterator begin( void ) const
+			{ return first< const_iterator >( this ); }
+
+			/// Returns the past-the-end const_iterator.
+			const_iterator end( void ) const
+			{ return const_iterator( this, m_size ); }
+
+			/// Returns an iterator to the entry of the k_ key, or end() if the key is not on the table.
+			iterator find( const KeyType & k_ )
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			iterator find( const K & k_ )
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+				return iterator( this, pos == npos ? m_size : pos );
+			}
+
+			/// Returns a const_iterator to the entry of the k_ key, or end() if the key is not on the table.
+			const_iterator find( const KeyType & k_ ) const
+			{ return find< KeyType >( k_ ); }
+
+			/// Same as the find() above, for any key type K accepted by a transparent KeyHash and KeyEqual.
+			template < typename K, typename = lookup_key< K > >
+			const_iterator find( const K & k_ ) const
+			{
+				size_t pos = find_slot( k_, hash_of( k_ ) );
+				return const_iterator( this, pos == npos ? m_size : pos );
+			}
+
+			/// Calls fn_( key, data ) on every entry, a group of control bytes at a time in memory order, so empty slots are skipped GROUP_WIDTH at once. The data may be modified, the key may not.
+			template < typename Fn >
+			void for_each( Fn && fn_ )
+			{
+				for( size_t group = 0 ; group < m_size ; group += swiss::GROUP_WIDTH )
+					for( uint32_t full = swiss::Group( m_ctrl + group ).match_full() ; full != 0 ; full &= full - 1 )
+					{
+						Entry & e = entry( group + swiss::lowest_bit( full ) );
+						fn_( std::as_const( e.m_key ), e.m_data );
+					}
+			}
+
+			/// Calls fn_( key, data ) on every entry, a group of control bytes at a time in memory order, so empty slots are skipped GROUP_WIDTH at once.
+			template < typename Fn >
+			void for_each( Fn && fn_ ) const
+			{
+				for( size_t group = 0 ; group < m_size ; group += swiss::GROUP_WIDTH )
+					for( uint32_t full = swiss::Group( m_ctrl + group ).match_full() ; full != 0 ; full &= full - 1 )
+					{
+						const Entry & e = entry( group + swiss::lowest_bit( full ) );
+						fn_( e.m_key, e.m_data );
+					}
+			}
+
+			/// A depuration method used to generate a textual representation of the hashtable and it's elements.
+			friend std::ostream& operator<< ( std::ostream & os, const HashTbl & tbl )
+			{
+				for( size_t i = 0 ; i < tbl.m_size ; i++ )
+				{
+					os << "[" << i << "]";
+					if( tbl.m_ctrl[i] >= 0 )
+						os << " -> " << tbl.entry( i ).m_data;
+					else if( tbl.m_ctrl[i] == swiss::DELETED )
+						os << " (deleted)";
+					os << std::endl;
+				}
+				return os;
+			}
+
+		private:
+			typedef typename std::aligned_storage< sizeof( Entry ), alignof( Entry ) >::type Slot;
+
+			Entry& entry( size_t pos_ )
+			{ return *reinterpret_cast< Entry* >( &m_slots[pos_] ); }
+
+			const Entry& entry( size_t pos_ ) const
+			{ return *reinterpret_cast< const Entry* >( &m_slots[pos_] ); }
+
+			Entry& entry_at( size_t pos_ )
+			{ return entry( pos_ ); }
+
+			const Entry& entry_at( size_t pos_ ) const
+			{ return entry( pos_ ); }
+
+			/// Iterator to the first entry of tbl_, or the end.
+			template < typename It, typename Table >
+			static It first( Table * tbl_ )
+			{
+				It it( tbl_, 0 );
+				it.skip_empty();
+				return it;
+			}
+
+			/// Hash of k_, with its bits spread so both the group index (high bits) and the fragment (low 7 bits) are usable.
+			template < typename K >
+			static size_t hash_of( const K & k_ )
+			{
+				KeyHash hashFunc;
+
+				return static_cast< size_t >( mix_hash( hashFunc( k_ ) ) );
+			}
+
+			/// Mixed hash of the key of e_: the stored one with cache_hash, otherwise KeyHash is called again.
+			static size_t hash_of_entry( const Entry & e_ )
+			{
+				if constexpr ( std::is_same< HashPolicy, cache_hash >::value )
+					return e_.m_hash;
+				else
+					return hash_of( e_.m_key );
+			}
+
+			/// The 7-bit fragment stored on the control byte.
+			static swiss::ctrl_t fragment( size_t hash_ )
+			{ return static_cast< swiss::ctrl_t >( hash_ & 0x7F ); }
+
+			/// First slot of the first group probed for hash_.
+			size_t home_group( size_t hash_ ) const
+			{ return ( ( hash_ >> 7 ) * swiss::GROUP_WIDTH ) & ( m_size - 1 ); }
+
+			/// Triangular probing over groups: visits every group once because the number of groups is a power of two.
+			size_t next_group( size_t group_, size_t step_ ) const
+			{ return ( group_ + step_ * swiss::GROUP_WIDTH ) & ( m_size - 1 ); }
+
+			/// Maximum number of entries for a table of size_ slots, under max_load_factor(). Always leaves one slot EMPTY, and allows at least one entry.
+			size_t max_load( size_t size_ ) const
+			{
+				if( size_ == 0 )
+					return 0;
+				return std::min( std::max( static_cast< size_t >( m_max_load * size_ ), size_t( 1 ) ), size_ - 1 );
+			}
+
+			/// Smallest power of two capacity, at least one group, that holds n_ entries.
+			size_t capacity_for( size_t n_ ) const
+			{
+				size_t cap = swiss::GROUP_WIDTH;
+				while( max_load( cap ) < n_ )
+					cap *= 2;
+				return cap;
+			}
+
+			/// Returns the slot holding the k_ key, or npos if the key is not on the table.
+			template < typename K >
+			size_t find_slot( const K & k_, size_t hash_ ) const
+			{
+				KeyEqual equalFunc;
+				swiss::ctrl_t h2 = fragment( hash_ );
+				size_t group = home_group( hash_ );
+
+				if( m_count == 0 )
+					return npos;
+
+				for( size_t step = 1 ; step <= m_size / swiss::GROUP_WIDTH ; step++ )
+				{
+					swiss::Group g( m_ctrl + group );
+
+					for( uint32_t match = g.match( h2 ) ; match != 0 ; match &= match - 1 )
+					{
+						size_t pos = group + swiss::lowest_bit( match );
+						if( entry( pos ).same_hash( hash_ ) and equalFunc( entry( pos ).m_key, k_ ) )
+							return pos;
+					}
+
+					if( g.match_empty() )
+						return npos;
+
+					group = next_group( group, step );
+				}
+
+				return npos;
+			}
+
+			/// First EMPTY or DELETED slot along the probe sequence of hash_.
+			size_t find_free( size_t hash_ ) const
+			{
+				size_t group = home_group( hash_ );
+
+				for( size_t step = 1 ; ; step++ )
+				{
+					uint32_t candidates = swiss::Group( m_ctrl + group ).match_empty_or_deleted();
+					if( candidates )
+						return group + swiss::lowest_bit( candidates );
+
+					group = next_group( group, step );
+				}
+			}
+
+			/// Entry of the k_ key, whose mixed hash is hash_, or nullptr if the key is not on the table.
+			template < typename K >
+			Entry * find_entry( const K & k_, size_t hash_ ) const
+			{
+				size_t pos = find_slot( k_, hash_ );
+				return pos == npos ? nullptr : reinterpret_cast< Entry* >( &m_slots[pos] );
+			}
+
+			/// Constructs, in its slot, the entry built from args_ for a key that is known not to be on the table, growing it first if needed. Returns the new entry.
+			template < typename... Args >
+			Entry & place( size_t hash_, Args &&... args_ )
+			{
+				if( m_size == 0 )
+					allocate( capacity_for( 1 ) );
+
+				size_t pos = find_free( hash_ );
+
+				while( m_growth_left == 0 and m_ctrl[pos] == swiss::EMPTY )
+				{
+					// Mostly tombstones: clean them up in place. Otherwise the table is really full and doubles.
+					resize( m_count * 2 < max_load( m_size ) ? m_size : m_size * 2 );
+					pos = find_free( hash_ );
+				}
+
+				if( m_ctrl[pos] == swiss::EMPTY )
+					m_growth_left--;
+
+				::new ( static_cast< void* >( &m_slots[pos] ) ) Entry( std::forward< Args >( args_ )... );
+				entry( pos ).set_hash( hash_ );
+				m_ctrl[pos] = fragment( hash_ );
+				m_count++;
+
+				return entry( pos );
+			}
+
+			/// Number of entries to size the table for when n_ entries are about to be inserted.
+			static size_t initial_size( size_t n_ )
+			{ return n_ == 0 ? DEFAULT_SIZE : n_; }
+
+			/// Resizes the table for a new max_load_factor(), which also drops its tombstones.
+			void refit( void )
+			{
+				if( m_size != 0 )
+					resize( std::max( m_size, capacity_for( m_count ) ) );
+			}
+
+			/// Fills the shape part of s_, for stats(), by walking every slot: histogram of how many groups past their home group the entries sit, longest such distance, empty slots (tombstones included) and memory held. Each entry's hash is needed, so KeyHash is called once per entry unless hashes are cached. Entries often outside their home group point to a weak KeyHash.
+			void measure( HashStats & s_ ) const
+			{
+				size_t empty = 0;
+				for( size_t i = 0 ; i < m_size ; i++ )
+				{
+					if( m_ctrl[i] < 0 )
+					{
+						empty++;
+						continue;
+					}
+
+					size_t group = home_group( hash_of_entry( entry( i ) ) );
+					size_t step = 0;
+					while( i < group or i >= group + swiss::GROUP_WIDTH )
+						group = next_group( group, ++step );
+					count_length( s_.histogram, step );
+					s_.longest = std::max( s_.longest, step );
+				}
+
+				s_.empty_ratio = m_size == 0 ? 0.0 : static_cast< double >( empty ) / m_size;
+				s_.bytes = m_size * ( sizeof( Slot ) + sizeof( swiss::ctrl_t ) );
+			}
+
+			/// Shrinks the table, to at most half of max_load_factor(), when its load fell below min_load_factor().
+			void shrink_if_sparse( void )
+			{
+				if( m_min_load > 0 and m_size > swiss::GROUP_WIDTH and this->load_factor() < m_min_load )
+					resize( capacity_for( 2 * m_count ) );
+			}
+
+			/// Moves every entry to a new table with new_size_ slots, dropping all tombstones.
+			void resize( size_t new_size_ )
+			{
+				auto timer = this->time_rehash();
+				swiss::ctrl_t * old_ctrl = m_ctrl;
+				Slot * old_slots = m_slots;
+				size_t old_size = m_size;
+
+				allocate( new_size_ );
+
+				for( size_t i = 0 ; i < old_size ; i++ )
+				{
+					if( old_ctrl[i] >= 0 )
+					{
+						Entry & e = *reinterpret_cast< Entry* >( &old_slots[i] );
+						size_t hash = hash_of_entry( e );
+						size_t pos = find_free( hash );
+
+						::new ( static_cast< void* >( &m_slots[pos] ) ) Entry( std::move( e ) );
+						m_ctrl[pos] = fragment( hash );
+						e.~Entry();
+						m_count++;
+					}
+				}
+
+				m_growth_left -= m_count;
+
+				release( old_ctrl, old_slots, old_size );
+			}
+
+			/// Copies every entry from other, which must have the same size, keeping their slots.
+			void copy_slots( const HashTbl & other )
+			{
+				for( size_t i = 0 ; i < m_size ; i++ )
+				{
+					if( other.m_ctrl[i] >= 0 )
+					{
+						const Entry & e = other.entry( i );
+						::new ( static_cast< void* >( &m_slots[i] ) ) Entry( e );
+					}
+				}
+
+				std::memcpy( m_ctrl, other.m_ctrl, m_size );
+				m_count = other.m_count;
+				m_growth_left = other.m_growth_left;
+			}
+
+			using CtrlAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< swiss::ctrl_t >;
+			using SlotAlloc = typename std::allocator_traits< Allocator >::template rebind_alloc< Slot >;
+
+			/// Allocates an empty table with size_ slots, without any array if size_ is zero. The previous arrays must have been released.
+			void allocate( size_t size_ )
+			{
+				m_size = size_;
+				m_ctrl = nullptr;
+				m_slots = nullptr;
+
+				if( m_size != 0 )
+				{
+					CtrlAlloc ctrl_alloc( m_alloc );
+					SlotAlloc slot_alloc( m_alloc );
+					m_ctrl = std::allocator_traits< CtrlAlloc >::allocate( ctrl_alloc, m_size );
+					m_slots = std::allocator_traits< SlotAlloc >::allocate( slot_alloc, m_size );
+					std::memset( m_ctrl, static_cast< unsigned char >( swiss::EMPTY ), m_size );
+				}
+
+				m_count = 0;
+				m_growth_left = max_load( m_size );
+			}
+
+			/// Frees the arrays of a table with size_ slots, whose entries must have been destroyed already.
+			void release( swiss::ctrl_t * ctrl_, Slot * slots_, size_t size_ )
+			{
+				if( size_ == 0 )
+					return;
+
+				CtrlAlloc ctrl_alloc( m_alloc );
+				SlotAlloc slot_alloc( m_alloc );
+				std::allocator_traits< CtrlAlloc >::deallocate( ctrl_alloc, ctrl_, size_ );
+				std::allocator_traits< SlotAlloc >::deallocate( slot_alloc, slots_, size_ );
+			}
+
+			/// Exchanges everything but the allocators. Both must be equal, or their slots be exchanged back before any allocation.
+			void swap_contents ( HashTbl & other ) noexcept
+			{
+				std::swap( m_size, other.m_size );
+				std::swap( m_count, other.m_count );
+				std::swap( m_growth_left, other.m_growth_left );
+				std::swap( m_ctrl, other.m_ctrl );
+				std::swap( m_slots, other.m_slots );
+				std::swap( m_max_load, other.m_max_load );
+				std::swap( m_min_load, other.m_min_load );
+			}
+
+			Allocator m_alloc; //!< Allocator of the control bytes and slots, rebound to each.
+			size_t m_size = 0u; //!< Number of slots, a power of two.
+			size_t m_count = 0u; //!< Number of elements on the table.
+			size_t m_growth_left = 0u; //!< EMPTY slots that may still be used before the table must grow.
+			swiss::ctrl_t * m_ctrl = nullptr; //!< One control byte per slot.
+			Slot * m_slots = nullptr; //!< Flat array of entries.
+			float m_max_load = MAX_LOAD; //!< Load factor the table grows past.
+			float m_min_load = 0.0f; //!< Load factor erase() shrinks the table below, 0 for never.
+			static constexpr float MAX_LOAD = 0.875f; //!< Highest allowed maximum load factor, so every probe sequence meets an EMPTY slot.
+			static const short DEFAULT_SIZE = 11;
+			static constexpr size_t PREFETCH_DISTANCE = 8; //!< How many keys ahead retrieve_many() prefetches.
+			static const size_t npos = static_cast< size_t >( -1 ); //!< "Not found" slot index.
+
+	}; // HashTbl swiss table specialization
+} // ac Namespace
+#endif
@@ -3,10 +3,29 @@
 #include <algorithm>            // std::min_element
 #include <array>
 #include <map>
+#include <set>
+#include <tuple>
+#include <vector>
+#include <random>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <memory_resource>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 #include "gtest/gtest.h"        // gtest lib
 #include "../include/hashtbl.h"   // header file for tested functions
 #include "../include/account.h"  // To get the account class
+#include "../include/pool_allocator.h"
+#include "../include/concurrent_hashtbl.h"
+#include "../include/read_mostly_hashtbl.h"
+#include "../include/mapped_hashtbl.h"
+#include "../include/serializer.h"
+#include "../include/key_hash.h"
 
 // ============================================================================
 // Test Fxture
@@ -458,6 +477,25 @@ TEST_F(HTTest, EraseNonExisting)
     }
 }
 
+TEST_F(HTTest, EraseSharedBucket)
+{
+    // 11, 22 and 33 share bucket 0 of an 11 bucket table.
+    ac::HashTbl<int, std::string> htable (11);
+    htable.insert( 11, "eleven" );
+    htable.insert( 22, "twenty two" );
+    htable.insert( 33, "thirty three" );
+
+    ASSERT_TRUE( htable.erase( 22 ) );
+
+    std::string data;
+    ASSERT_FALSE( htable.retrieve( 22, data ) );
+    ASSERT_TRUE( htable.retrieve( 11, data ) );
+    ASSERT_EQ( "eleven", data );
+    ASSERT_TRUE( htable.retrieve( 33, data ) );
+    ASSERT_EQ( "thirty three", data );
+    ASSERT_EQ( 2u, htable.size() );
+}
+
 TEST_F(HTTest, Clear)
 {
     ac::HashTbl<char, int> htable {{'x', 2}, {'y', 1}, {'w', 4}, {'a', 5}, {'b', 8}, {'c', 7}};
@@ -512,6 +550,127 @@ TEST_F(HTTest, Rehash)
 }
 
 
+/// Value type that counts how many times it gets copied.
+struct CopyCounter
+{
+    static size_t copies;
+    int value;
+
+    CopyCounter( int value_ = 0 ) : value( value_ ) {}
+    CopyCounter( const CopyCounter & other ) : value( other.value ) { copies++; }
+    CopyCounter( CopyCounter && other ) = default;
+    CopyCounter& operator=( const CopyCounter & other ) { value = other.value; copies++; return *this; }
+    CopyCounter& operator=( CopyCounter && other ) = default;
+    bool operator==( const CopyCounter & other ) const { return value == other.value; }
+};
+size_t CopyCounter::copies = 0;
+
+struct CopyCounterHash
+{
+    size_t operator()( const CopyCounter & c_ ) const { return std::hash<int>()( c_.value ); }
+};
+
+TEST_F(HTTest, RehashDoesNotCopy)
+{
+    ac::HashTbl<CopyCounter, CopyCounter, CopyCounterHash> htable (2);
+
+    // Any insert costs the same number of copies, including the ones that trigger rehash().
+    CopyCounter::copies = 0;
+    htable.insert( CopyCounter( -1 ), CopyCounter( -1 ) );
+    const size_t per_insert = CopyCounter::copies;
+
+    for( int i = 0 ; i < 1000 ; i++ )
+    {
+        CopyCounter::copies = 0;
+        htable.insert( CopyCounter( i ), CopyCounter( i * 2 ) );
+        ASSERT_EQ( per_insert, CopyCounter::copies );
+    }
+
+    for( int i = 0 ; i < 1000 ; i++ )
+    {
+        CopyCounter data;
+        ASSERT_TRUE( htable.retrieve( CopyCounter( i ), data ) );
+        ASSERT_EQ( i * 2, data.value );
+    }
+    ASSERT_EQ( 1001u, htable.size() );
+}
+
+TEST_F(HTTest, IncrementalRehash)
+{
+    ac::HashTbl<int, int> htable (2);
+    std::map<int, int> expected;
+    std::mt19937 gen( 11 );
+    std::uniform_int_distribution<int> key( 0, 20000 );
+    bool seen_rehashing{ false };
+
+    htable.incremental_rehash( 1 );
+
+    for( int i = 0 ; i < 50000 ; i++ )
+    {
+        int k = key( gen );
+        if( gen() % 4 == 0 )
+        {
+            ASSERT_EQ( expected.erase( k ) == 1, htable.erase( k ) );
+        }
+        else
+        {
+            ASSERT_EQ( expected.count( k ) == 0, htable.insert( k, i ) );
+            expected[k] = i;
+        }
+
+        if( htable.rehashing() )
+        {
+            seen_rehashing = true;
+            // Keys still in the old bucket array must be found, whatever the method.
+            int data;
+            ASSERT_TRUE( htable.retrieve( k, data ) or expected.count( k ) == 0 );
+            if( expected.count( k ) )
+            {
+                ASSERT_EQ( expected[k], htable.at( k ) );
+                ASSERT_EQ( expected[k], htable[k] );
+            }
+        }
+    }
+    ASSERT_TRUE( seen_rehashing );
+    ASSERT_EQ( expected.size(), htable.size() );
+
+    for( const auto &e : expected )
+    {
+        int data;
+        ASSERT_TRUE( htable.retrieve( e.first, data ) );
+        ASSERT_EQ( e.second, data );
+    }
+}
+
+TEST_F(HTTest, IncrementalRehashCopyAndStop)
+{
+    ac::HashTbl<int, int> htable (2);
+    htable.incremental_rehash( 1 );
+
+    int n = 0;
+    do
+    {
+        htable.insert( n, -n );
+        n++;
+    } while( n < 100 or not htable.rehashing() );
+
+    // A copy taken in the middle of a rehash holds every entry.
+    ac::HashTbl<int, int> copy( htable );
+    ASSERT_FALSE( copy.rehashing() );
+    for( int i = 0 ; i < n ; i++ )
+        ASSERT_EQ( -i, copy.at( i ) );
+
+    // Going back to one-shot rehash moves whatever is left.
+    htable.incremental_rehash( 0 );
+    ASSERT_FALSE( htable.rehashing() );
+    for( int i = 0 ; i < n ; i++ )
+        ASSERT_EQ( -i, htable.at( i ) );
+    ASSERT_EQ( size_t( n ), htable.size() );
+
+    htable.clear();
+    ASSERT_TRUE( htable.empty() );
+}
+
 TEST_F(HTTest, Count)
 {
     ac::HashTbl<int, std::string> htable (9);
@@ -547,6 +706,2349 @@ TEST_F(HTTest, Count)
     //std::cout << "The table: \n" << htable << std::endl;
 }
 
+// ============================================================================
+// TESTING OPEN ADDRESSING STORAGE
+// ============================================================================
+
+TEST_F(HTTest, OpenAddressingAccounts)
+{
+    ac::HashTbl< Account::AcctKey, Account, KeyHash, KeyEqual, ac::open_addressing > ht{ 4 };
+    Account temp;
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.insert( e.get_key(), e ) );
+    ASSERT_EQ( m_accounts.size(), ht.size() );
+
+    for( auto & e : m_accounts )
+    {
+        ASSERT_TRUE( ht.retrieve( e.get_key(), temp ) );
+        ASSERT_EQ( temp, e );
+        ASSERT_EQ( ht[e.get_key()], e );
+        ASSERT_EQ( ht.at(e.get_key()), e );
+    }
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.erase( e.get_key() ) );
+    ASSERT_TRUE( ht.empty() );
+}
+
+TEST_F(HTTest, OpenAddressingWordCount)
+{
+    std::map<std::string, size_t> expected;
+    ac::HashTbl<std::string, size_t, std::hash<std::string>, std::equal_to<std::string>, ac::open_addressing> word_map;
+    for (const auto &w : { "this", "sentence", "is", "not", "a", "sentence",
+                           "this", "sentence", "is", "a", "hoax"})
+    {
+        ++word_map[w];
+        ++expected[w];
+    }
+
+    ASSERT_EQ( expected.size(), word_map.size() );
+    for (const auto &pair : expected )
+        ASSERT_EQ( pair.second, word_map.at(pair.first) );
+
+    bool worked{ false };
+    try { word_map.at( "missing" ); }
+    catch( const std::out_of_range& e ) { worked = true; }
+    ASSERT_TRUE( worked );
+}
+
+TEST_F(HTTest, OpenAddressingInsertExisting)
+{
+    ac::HashTbl<char, int, std::hash<char>, std::equal_to<char>, ac::open_addressing> htable {{'x', 2}, {'y', 1}, {'w', 4}};
+
+    ASSERT_FALSE( htable.insert( 'x', 27 ) );
+    ASSERT_TRUE( htable.insert( 'z', 5 ) );
+
+    int data;
+    ASSERT_TRUE( htable.retrieve( 'x', data ) );
+    ASSERT_EQ( 27, data );
+    ASSERT_EQ( 4u, htable.size() );
+}
+
+TEST_F(HTTest, OpenAddressingCopyAndAssign)
+{
+    ac::HashTbl<char, int, std::hash<char>, std::equal_to<char>, ac::open_addressing> htable {{'a', 27}, {'b', 3}, {'c', 1}};
+    ac::HashTbl<char, int, std::hash<char>, std::equal_to<char>, ac::open_addressing> copy( htable );
+    ac::HashTbl<char, int, std::hash<char>, std::equal_to<char>, ac::open_addressing> assigned;
+
+    assigned = htable;
+    htable.clear();
+
+    for( const auto &e : std::map<char, int>{{'a', 27}, {'b', 3}, {'c', 1}} )
+    {
+        int data;
+        ASSERT_TRUE( copy.retrieve( e.first, data ) );
+        ASSERT_EQ( e.second, data );
+        ASSERT_TRUE( assigned.retrieve( e.first, data ) );
+        ASSERT_EQ( e.second, data );
+    }
+    ASSERT_TRUE( htable.empty() );
+}
+
+TEST_F(HTTest, OpenAddressingCollisions)
+{
+    // Every key below lands on the same home slot, so probing and backward-shift do all the work.
+    ac::HashTbl<int, std::string, std::hash<int>, std::equal_to<int>, ac::open_addressing> htable (11);
+    std::map<int, std::string> set1 {{11, "eleven"}, {2*11, "twenty two"}, {3*11, "thirty three"}, {4*11, "fourty four"} };
+
+    for( const auto &e : set1 )
+        ASSERT_TRUE( htable.insert( e.first, e.second ) );
+    ASSERT_TRUE( htable.insert( 1, "one" ) );
+
+    for( const auto &e : set1 )
+        ASSERT_EQ( set1.size(), htable.count( e.first ) );
+
+    ASSERT_TRUE( htable.erase( 2*11 ) );
+    ASSERT_EQ( set1.size() - 1, htable.count( 11 ) );
+
+    std::string data;
+    ASSERT_FALSE( htable.retrieve( 2*11, data ) );
+    ASSERT_TRUE( htable.retrieve( 4*11, data ) );
+    ASSERT_EQ( "fourty four", data );
+    ASSERT_TRUE( htable.retrieve( 1, data ) );
+    ASSERT_EQ( "one", data );
+}
+
+TEST_F(HTTest, OpenAddressingRandomized)
+{
+    // Mirror a long random sequence of operations on a std::map.
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::open_addressing> htable (2);
+    std::map<int, int> expected;
+    std::mt19937 gen( 42 );
+    std::uniform_int_distribution<int> key( 0, 500 );
+
+    for( int i = 0 ; i < 20000 ; i++ )
+    {
+        int k = key( gen );
+        if( gen() % 3 == 0 )
+        {
+            ASSERT_EQ( expected.erase( k ) == 1, htable.erase( k ) );
+        }
+        else
+        {
+            ASSERT_EQ( expected.count( k ) == 0, htable.insert( k, i ) );
+            expected[k] = i;
+        }
+    }
+
+    ASSERT_EQ( expected.size(), htable.size() );
+    for( int k = 0 ; k <= 500 ; k++ )
+    {
+        int data;
+        auto it = expected.find( k );
+        ASSERT_EQ( it != expected.end(), htable.retrieve( k, data ) );
+        if( it != expected.end() )
+        {
+            ASSERT_EQ( it->second, data );
+        }
+    }
+}
+
+// ============================================================================
+// TESTING SWISS TABLE STORAGE
+// ============================================================================
+
+TEST_F(HTTest, SwissTableAccounts)
+{
+    ac::HashTbl< Account::AcctKey, Account, KeyHash, KeyEqual, ac::swiss_table > ht{ 4 };
+    Account temp;
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.insert( e.get_key(), e ) );
+    ASSERT_EQ( m_accounts.size(), ht.size() );
+
+    for( auto & e : m_accounts )
+    {
+        ASSERT_TRUE( ht.retrieve( e.get_key(), temp ) );
+        ASSERT_EQ( temp, e );
+        ASSERT_EQ( ht[e.get_key()], e );
+        ASSERT_EQ( ht.at(e.get_key()), e );
+    }
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.erase( e.get_key() ) );
+    ASSERT_TRUE( ht.empty() );
+    ASSERT_FALSE( ht.retrieve( target.get_key(), temp ) );
+}
+
+TEST_F(HTTest, SwissTableWordCount)
+{
+    std::map<std::string, size_t> expected;
+    ac::HashTbl<std::string, size_t, std::hash<std::string>, std::equal_to<std::string>, ac::swiss_table> word_map;
+    for (const auto &w : { "this", "sentence", "is", "not", "a", "sentence",
+                           "this", "sentence", "is", "a", "hoax"})
+    {
+        ++word_map[w];
+        ++expected[w];
+    }
+
+    ASSERT_EQ( expected.size(), word_map.size() );
+    for (const auto &pair : expected )
+        ASSERT_EQ( pair.second, word_map.at(pair.first) );
+
+    ac::HashTbl<std::string, size_t, std::hash<std::string>, std::equal_to<std::string>, ac::swiss_table> copy( word_map );
+    word_map.clear();
+    for (const auto &pair : expected )
+        ASSERT_EQ( pair.second, copy.at(pair.first) );
+}
+
+TEST_F(HTTest, SwissTableRandomized)
+{
+    // A narrow key range with many erasures keeps the table full of tombstones.
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::swiss_table> htable;
+    std::map<int, int> expected;
+    std::mt19937 gen( 7 );
+    std::uniform_int_distribution<int> key( 0, 3000 );
+
+    for( int i = 0 ; i < 100000 ; i++ )
+    {
+        int k = key( gen );
+        if( gen() % 2 == 0 )
+        {
+            ASSERT_EQ( expected.erase( k ) == 1, htable.erase( k ) );
+        }
+        else
+        {
+            ASSERT_EQ( expected.count( k ) == 0, htable.insert( k, i ) );
+            expected[k] = i;
+        }
+    }
+
+    ASSERT_EQ( expected.size(), htable.size() );
+    for( int k = 0 ; k <= 3000 ; k++ )
+    {
+        int data;
+        auto it = expected.find( k );
+        ASSERT_EQ( it != expected.end(), htable.retrieve( k, data ) );
+        if( it != expected.end() )
+        {
+            ASSERT_EQ( it->second, data );
+        }
+    }
+}
+
+// ============================================================================
+// TESTING CUCKOO TABLE STORAGE
+// ============================================================================
+
+TEST_F(HTTest, CuckooTableAccounts)
+{
+    ac::HashTbl< Account::AcctKey, Account, KeyHash, KeyEqual, ac::cuckoo_table > ht{ 4 };
+    Account temp;
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.insert( e.get_key(), e ) );
+    ASSERT_EQ( m_accounts.size(), ht.size() );
+
+    for( auto & e : m_accounts )
+    {
+        ASSERT_TRUE( ht.retrieve( e.get_key(), temp ) );
+        ASSERT_EQ( temp, e );
+        ASSERT_EQ( ht[e.get_key()], e );
+        ASSERT_EQ( ht.at(e.get_key()), e );
+    }
+
+    for( auto & e : m_accounts )
+        ASSERT_TRUE( ht.erase( e.get_key() ) );
+    ASSERT_TRUE( ht.empty() );
+    ASSERT_FALSE( ht.retrieve( target.get_key(), temp ) );
+}
+
+TEST_F(HTTest, CuckooTableRandomized)
+{
+    // At the highest load factor most inserts have to displace entries.
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::cuckoo_table> htable;
+    htable.max_load_factor( 1.0f );
+    ASSERT_FLOAT_EQ( 0.95f, htable.max_load_factor() );
+    std::map<int, int> expected;
+    std::mt19937 gen( 7 );
+    std::uniform_int_distribution<int> key( 0, 3000 );
+
+    for( int i = 0 ; i < 100000 ; i++ )
+    {
+        int k = key( gen );
+        if( gen() % 2 == 0 )
+        {
+            ASSERT_EQ( expected.erase( k ) == 1, htable.erase( k ) );
+        }
+        else
+        {
+            ASSERT_EQ( expected.count( k ) == 0, htable.insert( k, i ) );
+            expected[k] = i;
+        }
+    }
+
+    ASSERT_EQ( expected.size(), htable.size() );
+    ASSERT_EQ( expected.size(), size_t( std::distance( htable.begin(), htable.end() ) ) );
+    for( int k = 0 ; k <= 3000 ; k++ )
+    {
+        int data;
+        auto it = expected.find( k );
+        ASSERT_EQ( it != expected.end(), htable.retrieve( k, data ) );
+        if( it != expected.end() )
+        {
+            ASSERT_EQ( it->second, data );
+        }
+    }
+}
+
+TEST_F(HTTest, CuckooTableHighLoad)
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::cuckoo_table> htable;
+    htable.max_load_factor( 0.95f );
+    htable.reserve( 3800 );
+    size_t slots = htable.bucket_count();
+    ASSERT_EQ( 4096u, slots );
+
+    // Displacement paths fill the table past 90% without growing it.
+    for( int i = 0 ; i < 3800 ; i++ )
+        ASSERT_TRUE( htable.insert( i, -i ) );
+    ASSERT_EQ( slots, htable.bucket_count() );
+    ASSERT_GT( htable.load_factor(), 0.9f );
+
+    // Every entry sits in one of its two buckets, or in the stash.
+    ac::HashStats s = htable.stats();
+    ASSERT_LE( s.longest, 2u );
+    ASSERT_GT( s.histogram[0], s.histogram[1] );
+    for( int i = 0 ; i < 3800 ; i++ )
+        ASSERT_EQ( -i, htable.at( i ) );
+}
+
+struct SameHash
+{
+    size_t operator()( int ) const
+    { return 7; }
+};
+
+TEST_F(HTTest, CuckooTableStash)
+{
+    // Keys sharing their hash share both buckets: past them the stash takes the overflow, then inserting throws.
+    ac::HashTbl<int, int, SameHash, std::equal_to<int>, ac::cuckoo_table> htable;
+    int n = 0;
+    ASSERT_THROW( { for( ; n < 100 ; n++ ) htable.insert( n, n ); }, std::length_error );
+    ASSERT_GE( n, 12 );
+    ASSERT_LE( n, 16 );
+
+    // The failed insert leaves the table as it was.
+    ASSERT_EQ( size_t( n ), htable.size() );
+    ASSERT_TRUE( htable.find( n ) == htable.end() );
+    for( int i = 0 ; i < n ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+    ac::HashStats s = htable.stats();
+    ASSERT_EQ( 3u, s.histogram.size() );
+    ASSERT_EQ( 8u, s.histogram[2] );
+
+    // Erasing an entry from a bucket moves a stashed one back there.
+    ASSERT_TRUE( htable.erase( 0 ) );
+    ASSERT_EQ( 7u, htable.stats().histogram[2] );
+    ASSERT_TRUE( htable.insert( n, n ) );
+    for( int i = 1 ; i <= n ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+}
+
+/// Six keys per hash: groups share both their buckets, and crowd small tables.
+struct SixPerHash
+{
+    size_t operator()( int k_ ) const
+    { return std::hash<int>()( k_ / 6 ); }
+};
+
+TEST_F(HTTest, CuckooTableResizeRetries)
+{
+    using Table = ac::HashTbl<int, int, SixPerHash, std::equal_to<int>, ac::cuckoo_table, ac::prime_size, ac::recompute_hash,
+                              std::allocator<std::pair<const int, int>>, ac::collect_stats>;
+    Table htable;
+    htable.max_load_factor( 0.95f );
+    for( int i = 0 ; i < 60 ; i++ )
+        htable.insert( i, i );
+
+    // Shrinking to fit leaves too little slack for these groups: the resize doubles again, and counts as one rehash.
+    size_t rehashes = htable.stats().rehashes;
+    htable.rehash( 0 );
+    ASSERT_EQ( rehashes + 1, htable.stats().rehashes );
+    ASSERT_EQ( 60u, htable.size() );
+    for( int i = 0 ; i < 60 ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+}
+
+// ============================================================================
+// TESTING SIZE POLICIES
+// ============================================================================
+
+TEST_F(HTTest, PowerOfTwoSize)
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::chained_storage, ac::power_of_two_size> htable (2);
+    std::map<int, int> expected;
+
+    for( int i = 0 ; i < 1000 ; i++ )
+    {
+        ASSERT_TRUE( htable.insert( i * 7, i ) );
+        expected[i * 7] = i;
+    }
+    for( int i = 0 ; i < 1000 ; i += 2 )
+    {
+        ASSERT_TRUE( htable.erase( i * 7 ) );
+        expected.erase( i * 7 );
+    }
+
+    ASSERT_EQ( expected.size(), htable.size() );
+    for( int i = 0 ; i < 1000 ; i++ )
+    {
+        int data;
+        ASSERT_EQ( expected.count( i * 7 ) == 1, htable.retrieve( i * 7, data ) );
+    }
+}
+
+TEST_F(HTTest, FastRangeSize)
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::open_addressing, ac::fast_range_size> htable (10);
+
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_TRUE( htable.insert( i, -i ) );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_EQ( -i, htable.at( i ) );
+    ASSERT_EQ( 1000u, htable.size() );
+}
+
+TEST_F(HTTest, MixedHashSpreadsStridedKeys)
+{
+    // With the identity hash and a power of two table, keys with a 1024 stride would share
+    // one bucket if the hash was only masked.
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::chained_storage, ac::power_of_two_size> pow2 (1024);
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::chained_storage, ac::fast_range_size> range (1000);
+
+    for( int i = 0 ; i < 512 ; i++ )
+    {
+        pow2.insert( i * 1024, i );
+        range.insert( i * 1024, i );
+    }
+
+    for( int i = 0 ; i < 512 ; i++ )
+    {
+        ASSERT_LT( pow2.count( i * 1024 ), 8u );
+        ASSERT_LT( range.count( i * 1024 ), 8u );
+    }
+}
+
+TEST_F(HTTest, PrimeTableSize)
+{
+    const auto & table = ac::primes::growth();
+
+    // Every entry is a prime, roughly twice the previous one.
+    for( size_t i = 0 ; i < ac::primes::COUNT ; i++ )
+    {
+        ASSERT_EQ( ac::primes::is_prime( table.entries[i].prime ), true );
+        if( i > 0 )
+        {
+            ASSERT_GE( table.entries[i].prime, 2 * table.entries[i-1].prime );
+        }
+    }
+
+    ASSERT_EQ( 5u, ac::prime_table_size::capacity( 0 ) );
+    ASSERT_EQ( 11u, ac::prime_table_size::capacity( 11 ) );
+    ASSERT_EQ( 23u, ac::prime_table_size::capacity( 12 ) );
+
+    // The division-free reduction must agree with the modulo of the folded hash.
+    for( size_t i = 0 ; i < ac::primes::COUNT ; i += 3 )
+    {
+        uint64_t p = table.entries[i].prime;
+        ac::prime_table_size::reducer reduce( p );
+        for( uint64_t h : { uint64_t( 0 ), uint64_t( 1 ), p - 1, p, p + 1, uint64_t( 123456789 ), uint64_t( 0xFFFFFFFF ), uint64_t( 0xDEADBEEFCAFEBABE ) } )
+        {
+            uint32_t folded = static_cast<uint32_t>( h ^ ( h >> 32 ) );
+            ASSERT_EQ( folded % p, reduce( h ) );
+        }
+    }
+}
+
+TEST_F(HTTest, PrimeTableSizeTable)
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::chained_storage, ac::prime_table_size> chained (2);
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::open_addressing, ac::prime_table_size> flat (2);
+
+    for( int i = 0 ; i < 5000 ; i++ )
+    {
+        ASSERT_TRUE( chained.insert( i * 31, i ) );
+        ASSERT_TRUE( flat.insert( i * 31, i ) );
+    }
+    for( int i = 0 ; i < 5000 ; i += 2 )
+    {
+        ASSERT_TRUE( chained.erase( i * 31 ) );
+        ASSERT_TRUE( flat.erase( i * 31 ) );
+    }
+    for( int i = 0 ; i < 5000 ; i++ )
+    {
+        int data;
+        ASSERT_EQ( i % 2 == 1, chained.retrieve( i * 31, data ) );
+        ASSERT_EQ( i % 2 == 1, flat.retrieve( i * 31, data ) );
+    }
+}
+
+// ============================================================================
+// TESTING MOVE SEMANTICS AND IN-PLACE CONSTRUCTION
+// ============================================================================
+
+template < typename Storage >
+using MoveTbl = ac::HashTbl<CopyCounter, CopyCounter, CopyCounterHash, std::equal_to<CopyCounter>, Storage>;
+
+template < typename Storage >
+void check_move_and_swap( void )
+{
+    ac::HashTbl<int, std::string, std::hash<int>, std::equal_to<int>, Storage> htable;
+    for( int i = 0 ; i < 100 ; i++ )
+        htable.insert( i, std::to_string( i ) );
+
+    // The moved-from table is empty, and usable again.
+    auto moved( std::move( htable ) );
+    ASSERT_EQ( 100u, moved.size() );
+    ASSERT_EQ( "42", moved.at( 42 ) );
+    ASSERT_TRUE( htable.empty() );
+    ASSERT_EQ( 0u, htable.count( 42 ) );
+    ASSERT_FALSE( htable.erase( 42 ) );
+    ASSERT_THROW( htable.at( 42 ), std::out_of_range );
+    ASSERT_TRUE( htable.insert( 7, "seven" ) );
+    ASSERT_EQ( "seven", htable[7] );
+
+    decltype( htable ) other;
+    other = std::move( moved );
+    ASSERT_EQ( 100u, other.size() );
+    ASSERT_TRUE( moved.empty() );
+    moved = other; // copy into a moved-from table
+    ASSERT_EQ( 100u, moved.size() );
+
+    swap( htable, other );
+    ASSERT_EQ( 1u, other.size() );
+    ASSERT_EQ( "seven", other.at( 7 ) );
+    ASSERT_EQ( 100u, htable.size() );
+    for( int i = 0 ; i < 100 ; i++ )
+        ASSERT_EQ( std::to_string( i ), htable.at( i ) );
+}
+
+template < typename Storage >
+void check_emplace_family( void )
+{
+    MoveTbl<Storage> htable (2);
+
+    // Rvalues are moved all the way into the table.
+    CopyCounter::copies = 0;
+    for( int i = 0 ; i < 50 ; i++ )
+        ASSERT_TRUE( htable.insert( CopyCounter( i ), CopyCounter( i * 2 ) ) );
+    for( int i = 50 ; i < 100 ; i++ )
+        ASSERT_TRUE( htable.try_emplace( CopyCounter( i ), i * 2 ) );
+    for( int i = 100 ; i < 150 ; i++ )
+        ASSERT_TRUE( htable.emplace( i, i * 2 ) );
+    ASSERT_EQ( 0u, CopyCounter::copies );
+    ASSERT_EQ( 150u, htable.size() );
+
+    // try_emplace and emplace leave an existing entry alone, insert_or_assign overwrites it.
+    ASSERT_FALSE( htable.try_emplace( CopyCounter( 3 ), -1 ) );
+    ASSERT_FALSE( htable.emplace( 3, -1 ) );
+    ASSERT_EQ( 6, htable.at( CopyCounter( 3 ) ).value );
+    ASSERT_FALSE( htable.insert_or_assign( CopyCounter( 3 ), CopyCounter( -3 ) ) );
+    ASSERT_EQ( -3, htable.at( CopyCounter( 3 ) ).value );
+    ASSERT_TRUE( htable.insert_or_assign( CopyCounter( 1000 ), CopyCounter( 1 ) ) );
+    ASSERT_EQ( 151u, htable.size() );
+
+    for( int i = 4 ; i < 150 ; i++ )
+        ASSERT_EQ( i * 2, htable.at( CopyCounter( i ) ).value );
+}
+
+TEST_F(HTTest, MoveAndSwap)
+{
+    check_move_and_swap<ac::chained_storage>();
+    check_move_and_swap<ac::open_addressing>();
+    check_move_and_swap<ac::swiss_table>();
+    check_move_and_swap<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, EmplaceFamily)
+{
+    check_emplace_family<ac::chained_storage>();
+    check_emplace_family<ac::open_addressing>();
+    check_emplace_family<ac::swiss_table>();
+    check_emplace_family<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, MoveOnlyData)
+{
+    ac::HashTbl<int, std::unique_ptr<int>> htable;
+
+    ASSERT_TRUE( htable.try_emplace( 1, new int( 10 ) ) );
+    ASSERT_TRUE( htable.insert_or_assign( 2, std::unique_ptr<int>( new int( 20 ) ) ) );
+    ASSERT_TRUE( htable.emplace( 3, std::unique_ptr<int>( new int( 30 ) ) ) );
+    ASSERT_EQ( 10, *htable.at( 1 ) );
+    ASSERT_EQ( 20, *htable.at( 2 ) );
+    ASSERT_EQ( 30, *htable.at( 3 ) );
+
+    auto moved( std::move( htable ) );
+    ASSERT_EQ( 30, *moved.at( 3 ) );
+}
+
+struct CountingHash
+{
+    static size_t calls;
+    size_t operator()( int k_ ) const { calls++; return std::hash<int>()( k_ ); }
+};
+size_t CountingHash::calls = 0;
+
+template < typename Storage >
+void check_single_probe_subscript( void )
+{
+    ac::HashTbl<int, int, CountingHash, std::equal_to<int>, Storage> htable (1000);
+    for( int i = 0 ; i < 10 ; i++ )
+        htable.insert( i, i );
+
+    // A new key and an existing key are both hashed once.
+    CountingHash::calls = 0;
+    htable[500] = 5;
+    ASSERT_EQ( 1u, CountingHash::calls );
+    CountingHash::calls = 0;
+    htable[500] += 1;
+    ASSERT_EQ( 1u, CountingHash::calls );
+    ASSERT_EQ( 6, htable.at( 500 ) );
+
+    // References handed out by operator[] survive the rehash the insertion triggers.
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> small (2);
+    for( int i = 0 ; i < 1000 ; i++ )
+        small[i] = i;
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, small.at( i ) );
+}
+
+TEST_F(HTTest, OperatorSquareBraketsSingleProbe)
+{
+    check_single_probe_subscript<ac::chained_storage>();
+    check_single_probe_subscript<ac::open_addressing>();
+    check_single_probe_subscript<ac::swiss_table>();
+    check_single_probe_subscript<ac::cuckoo_table>();
+
+    // The data is value-initialized, so it doesn't need to be copyable.
+    ac::HashTbl<std::string, std::unique_ptr<int>> htable;
+    ASSERT_EQ( nullptr, htable["one"] );
+    htable["one"].reset( new int( 1 ) );
+    ASSERT_EQ( 1, *htable[ std::string( "one" ) ] );
+}
+
+template < typename Storage >
+void check_transparent_lookup( void )
+{
+    ac::HashTbl<std::string, int, ac::string_hash, std::equal_to<>, Storage> htable;
+    for( int i = 0 ; i < 100 ; i++ )
+        htable.insert( "key" + std::to_string( i ), i );
+
+    std::string_view view = "key42";
+    int data = 0;
+    ASSERT_TRUE( htable.retrieve( view, data ) );
+    ASSERT_EQ( 42, data );
+    ASSERT_EQ( 7, htable.at( "key7" ) );
+    ASSERT_FALSE( htable.retrieve( std::string_view( "key420" ), data ) );
+    ASSERT_THROW( htable.at( std::string_view( "nope" ) ), std::out_of_range );
+    ASSERT_LE( 1u, htable.count( view ) );
+    ASSERT_EQ( htable.count( std::string( view ) ), htable.count( view ) );
+
+    ASSERT_TRUE( htable.erase( view ) );
+    ASSERT_FALSE( htable.erase( "key42" ) );
+    ASSERT_EQ( 99u, htable.size() );
+    ASSERT_EQ( 43, htable.at( std::string( "key43" ) ) );
+}
+
+TEST_F(HTTest, TransparentLookup)
+{
+    check_transparent_lookup<ac::chained_storage>();
+    check_transparent_lookup<ac::open_addressing>();
+    check_transparent_lookup<ac::swiss_table>();
+    check_transparent_lookup<ac::cuckoo_table>();
+}
+
+// ============================================================================
+// TESTING HASH POLICIES
+// ============================================================================
+
+struct CountingEqual
+{
+    static size_t calls;
+    bool operator()( int lhs, int rhs ) const { calls++; return lhs == rhs; }
+};
+size_t CountingEqual::calls = 0;
+
+template < typename Storage >
+void check_cached_hash( void )
+{
+    ac::HashTbl<int, int, CountingHash, CountingEqual, Storage, ac::prime_size, ac::cache_hash> htable (2);
+
+    // Each key is hashed once, when it is inserted, however many rehashes follow.
+    CountingHash::calls = 0;
+    for( int i = 0 ; i < 2000 ; i++ )
+        ASSERT_TRUE( htable.insert( i, -i ) );
+    ASSERT_EQ( 2000u, CountingHash::calls );
+
+    // Entries whose stored hash differs are rejected without calling KeyEqual.
+    CountingEqual::calls = 0;
+    for( int i = 0 ; i < 2000 ; i++ )
+        ASSERT_EQ( -i, htable.at( i ) );
+    ASSERT_EQ( 2000u, CountingEqual::calls );
+
+    CountingEqual::calls = 0;
+    int data;
+    for( int i = 2000 ; i < 4000 ; i++ )
+        ASSERT_FALSE( htable.retrieve( i, data ) );
+    ASSERT_EQ( 0u, CountingEqual::calls );
+
+    // Copies keep the stored hashes.
+    auto copy( htable );
+    for( int i = 0 ; i < 2000 ; i += 2 )
+        ASSERT_TRUE( copy.erase( i ) );
+    for( int i = 2000 ; i < 3000 ; i++ )
+        ASSERT_TRUE( copy.emplace( i, -i ) );
+    for( int i = 0 ; i < 3000 ; i++ )
+        ASSERT_EQ( i % 2 == 1 or i >= 2000, copy.retrieve( i, data ) );
+}
+
+TEST_F(HTTest, CachedHash)
+{
+    check_cached_hash<ac::chained_storage>();
+    check_cached_hash<ac::open_addressing>();
+    check_cached_hash<ac::swiss_table>();
+    check_cached_hash<ac::cuckoo_table>();
+
+    // Incremental rehash moves entries with their stored hash too.
+    ac::HashTbl<int, int, CountingHash, std::equal_to<int>, ac::chained_storage, ac::prime_size, ac::cache_hash> htable;
+    htable.incremental_rehash( 1 );
+    CountingHash::calls = 0;
+    for( int i = 0 ; i < 1000 ; i++ )
+        htable[i] = i;
+    ASSERT_EQ( 1000u, CountingHash::calls );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+}
+
+// ============================================================================
+// TESTING ITERATORS
+// ============================================================================
+
+template < typename Storage >
+void check_iterators( void )
+{
+    using Table = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage>;
+    Table htable;
+    const Table & chtable = htable;
+
+    ASSERT_TRUE( htable.begin() == htable.end() );
+    ASSERT_TRUE( htable.find( 1 ) == htable.end() );
+
+    for( int i = 0 ; i < 1000 ; i++ )
+        htable.insert( i, i * 3 );
+    for( int i = 0 ; i < 1000 ; i += 3 )
+        htable.erase( i );
+
+    // Every entry is visited exactly once, by iterators and by for_each.
+    std::map<int, int> seen;
+    for( auto & e : htable )
+        seen[ e.m_key ] += e.m_data;
+    ASSERT_EQ( htable.size(), seen.size() );
+    ASSERT_EQ( htable.size(), size_t( std::distance( chtable.cbegin(), chtable.cend() ) ) );
+    for( const auto & p : seen )
+    {
+        ASSERT_NE( 0, p.first % 3 );
+        ASSERT_EQ( p.first * 3, p.second );
+    }
+
+    size_t visited = 0;
+    chtable.for_each( [&]( const int & k_, const int & d_ ) { ASSERT_EQ( k_ * 3, d_ ); visited++; } );
+    ASSERT_EQ( htable.size(), visited );
+
+    // Data can be modified through iterators and for_each.
+    for( auto it = htable.begin() ; it != htable.end() ; ++it )
+        it->m_data = -it->m_key;
+    htable.for_each( []( const int &, int & d_ ) { d_ *= 2; } );
+
+    // find() points at the entry, or at end().
+    auto it = htable.find( 1 );
+    ASSERT_TRUE( it != htable.end() );
+    ASSERT_EQ( 1, it->m_key );
+    ASSERT_EQ( -2, it->m_data );
+    ASSERT_TRUE( htable.find( 3 ) == htable.end() );
+    typename Table::const_iterator cit = it;
+    ASSERT_TRUE( cit == chtable.find( 1 ) );
+    ASSERT_TRUE( chtable.find( 3 ) == chtable.cend() );
+
+    // Usable with standard algorithms.
+    auto big = std::count_if( chtable.begin(), chtable.end(), []( const typename Table::Entry & e_ ) { return e_.m_key >= 500; } );
+    ASSERT_EQ( 333, big );
+}
+
+TEST_F(HTTest, Iterators)
+{
+    check_iterators<ac::chained_storage>();
+    check_iterators<ac::open_addressing>();
+    check_iterators<ac::swiss_table>();
+    check_iterators<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, IteratorsDuringIncrementalRehash)
+{
+    ac::HashTbl<int, int> htable;
+    htable.incremental_rehash( 1 );
+
+    for( int i = 0 ; i < 500 ; i++ )
+        htable.insert( i, i );
+    ASSERT_TRUE( htable.rehashing() );
+
+    // Entries still on the old buckets are reached too.
+    std::vector<bool> seen( 500, false );
+    for( const auto & e : htable )
+    {
+        ASSERT_FALSE( seen[ e.m_key ] );
+        seen[ e.m_key ] = true;
+    }
+    ASSERT_EQ( 500, std::count( seen.begin(), seen.end(), true ) );
+
+    const auto & chtable = htable;
+    for( int i = 0 ; i < 500 ; i++ )
+        ASSERT_EQ( i, chtable.find( i )->m_data );
+
+    std::stringstream out;
+    out << htable;
+    ASSERT_FALSE( out.str().empty() );
+}
+
+// ============================================================================
+// TESTING ALLOCATORS
+// ============================================================================
+
+/// Memory resource that counts the bytes it hands out and takes back.
+class CountingResource : public std::pmr::memory_resource
+{
+    public:
+        size_t outstanding = 0;
+        size_t allocations = 0;
+
+    private:
+        void * do_allocate( size_t bytes_, size_t align_ ) override
+        {
+            outstanding += bytes_;
+            allocations++;
+            return std::pmr::new_delete_resource()->allocate( bytes_, align_ );
+        }
+
+        void do_deallocate( void * p_, size_t bytes_, size_t align_ ) override
+        {
+            outstanding -= bytes_;
+            std::pmr::new_delete_resource()->deallocate( p_, bytes_, align_ );
+        }
+
+        bool do_is_equal( const std::pmr::memory_resource & other_ ) const noexcept override
+        { return this == &other_; }
+};
+
+template < typename Storage >
+using PmrTbl = ac::HashTbl<int, std::string, std::hash<int>, std::equal_to<int>, Storage, ac::prime_size, ac::recompute_hash,
+                           std::pmr::polymorphic_allocator< ac::HashEntry<int, std::string> >>;
+
+template < typename Storage >
+void check_pmr( void )
+{
+    CountingResource resource, other_resource;
+    {
+        PmrTbl<Storage> htable ( &resource );
+        for( int i = 0 ; i < 1000 ; i++ )
+            htable.insert( i, std::to_string( i ) );
+        for( int i = 0 ; i < 1000 ; i += 2 )
+            htable.erase( i );
+        ASSERT_LT( 0u, resource.outstanding );
+        ASSERT_EQ( &resource, htable.get_allocator().resource() );
+
+        // Moving to a table on another resource moves the entries into that resource.
+        PmrTbl<Storage> moved ( &other_resource );
+        moved = std::move( htable );
+        ASSERT_EQ( 500u, moved.size() );
+        ASSERT_TRUE( htable.empty() );
+        ASSERT_EQ( "999", moved.at( 999 ) );
+        ASSERT_EQ( &other_resource, moved.get_allocator().resource() );
+
+        // Moving between tables on the same resource takes the whole storage.
+        PmrTbl<Storage> same ( &other_resource );
+        size_t before = other_resource.allocations;
+        same = std::move( moved );
+        ASSERT_EQ( before, other_resource.allocations );
+        ASSERT_EQ( "1", same.at( 1 ) );
+    }
+    ASSERT_EQ( 0u, resource.outstanding );
+    ASSERT_EQ( 0u, other_resource.outstanding );
+}
+
+TEST_F(HTTest, PmrAllocator)
+{
+    check_pmr<ac::chained_storage>();
+    check_pmr<ac::open_addressing>();
+    check_pmr<ac::swiss_table>();
+    check_pmr<ac::cuckoo_table>();
+}
+
+// Allocator whose storage must go back to the instance that handed it out: it propagates on move assignment but not on swap.
+template < typename T >
+struct TaggedAllocator
+{
+    using value_type = T;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::false_type;
+
+    static std::map<int, long> & outstanding( void )
+    {
+        static std::map<int, long> counts;
+        return counts;
+    }
+
+    int id;
+
+    explicit TaggedAllocator( int id_ ) : id( id_ ) {}
+    template < typename U >
+    TaggedAllocator( const TaggedAllocator<U> & other_ ) noexcept : id( other_.id ) {}
+
+    T * allocate( size_t n_ )
+    {
+        outstanding()[id] += long( n_ * sizeof( T ) );
+        return std::allocator<T>().allocate( n_ );
+    }
+
+    void deallocate( T * p_, size_t n_ )
+    {
+        outstanding()[id] -= long( n_ * sizeof( T ) );
+        std::allocator<T>().deallocate( p_, n_ );
+    }
+
+    template < typename U >
+    bool operator==( const TaggedAllocator<U> & other_ ) const noexcept { return id == other_.id; }
+    template < typename U >
+    bool operator!=( const TaggedAllocator<U> & other_ ) const noexcept { return id != other_.id; }
+};
+
+template < typename Storage >
+using TaggedTbl = ac::HashTbl<int, std::string, std::hash<int>, std::equal_to<int>, Storage, ac::prime_size, ac::recompute_hash,
+                              TaggedAllocator< ac::HashEntry<int, std::string> >>;
+
+template < typename Storage >
+void check_propagating_move( void )
+{
+    using Alloc = TaggedAllocator< ac::HashEntry<int, std::string> >;
+    Alloc::outstanding().clear();
+    {
+        TaggedTbl<Storage> source ( Alloc( 1 ) ), target ( Alloc( 2 ) );
+        for( int i = 0 ; i < 100 ; i++ )
+            source.insert( i, std::to_string( i ) );
+        for( int i = 0 ; i < 10 ; i++ )
+            target.insert( -i, "old" );
+
+        // The target takes over the source's storage along with the allocator that owns it.
+        target = std::move( source );
+        ASSERT_TRUE( Alloc( 1 ) == target.get_allocator() );
+        ASSERT_EQ( 100u, target.size() );
+        ASSERT_EQ( "42", target.at( 42 ) );
+        ASSERT_TRUE( target.find( -1 ) == target.end() );
+        ASSERT_EQ( 0l, Alloc::outstanding()[2] );
+
+        target.insert( 1000, "1000" );
+        ASSERT_EQ( "1000", target.at( 1000 ) );
+    }
+    for( const auto & count : Alloc::outstanding() )
+        ASSERT_EQ( 0l, count.second ) << "allocator " << count.first;
+}
+
+TEST_F(HTTest, MoveAssignPropagatesAllocator)
+{
+    check_propagating_move<ac::chained_storage>();
+    check_propagating_move<ac::open_addressing>();
+    check_propagating_move<ac::swiss_table>();
+    check_propagating_move<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, NodePoolRecycles)
+{
+    ac::node_pool pool ( 24, 8, 4 );
+    void * a = pool.allocate();
+    void * b = pool.allocate();
+    ASSERT_NE( a, b );
+    ASSERT_EQ( 24u, size_t( static_cast<char*>( b ) - static_cast<char*>( a ) ) );
+
+    // Freed blocks are handed out again, most recent first.
+    pool.deallocate( a );
+    pool.deallocate( b );
+    ASSERT_EQ( b, pool.allocate() );
+    ASSERT_EQ( a, pool.allocate() );
+
+    // Past the first chunk a new one is started.
+    for( int i = 0 ; i < 10 ; i++ )
+        ASSERT_NE( nullptr, pool.allocate() );
+}
+
+template < typename Storage >
+using PoolTbl = ac::HashTbl<int, std::string, std::hash<int>, std::equal_to<int>, Storage, ac::prime_size, ac::recompute_hash,
+                            ac::pool_allocator< ac::HashEntry<int, std::string> >>;
+
+template < typename Storage >
+void check_pool_allocator( void )
+{
+    PoolTbl<Storage> htable;
+    for( int round = 0 ; round < 3 ; round++ )
+    {
+        for( int i = 0 ; i < 2000 ; i++ )
+            ASSERT_TRUE( htable.insert( i, std::to_string( i ) ) );
+        for( int i = 0 ; i < 2000 ; i += 2 )
+            ASSERT_TRUE( htable.erase( i ) );
+        for( int i = 0 ; i < 2000 ; i++ )
+            ASSERT_EQ( i % 2 == 1, htable.count( i ) > 0 and htable.find( i ) != htable.end() );
+        htable.clear();
+    }
+
+    for( int i = 0 ; i < 100 ; i++ )
+        htable[i] = std::to_string( i );
+
+    // Copies get their own pools, moves and swaps take the pools along.
+    PoolTbl<Storage> copy( htable );
+    ASSERT_FALSE( copy.get_allocator() == htable.get_allocator() );
+    PoolTbl<Storage> moved( std::move( copy ) );
+    ASSERT_EQ( "42", moved.at( 42 ) );
+    swap( moved, htable );
+    htable.erase( 42 );
+    ASSERT_EQ( 99u, htable.size() );
+    ASSERT_EQ( "42", moved.at( 42 ) );
+    moved = htable;
+    ASSERT_EQ( 99u, moved.size() );
+}
+
+TEST_F(HTTest, PoolAllocator)
+{
+    check_pool_allocator<ac::chained_storage>();
+    check_pool_allocator<ac::open_addressing>();
+    check_pool_allocator<ac::swiss_table>();
+    check_pool_allocator<ac::cuckoo_table>();
+}
+
+// ============================================================================
+// TESTING CAPACITY
+// ============================================================================
+
+template < typename Storage >
+void check_capacity( void )
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> htable;
+
+    // reserve() presizes once: the inserts that follow never rehash.
+    htable.reserve( 5000 );
+    size_t reserved = htable.bucket_count();
+    ASSERT_GE( reserved * htable.max_load_factor(), 5000.0f );
+    for( int i = 0 ; i < 5000 ; i++ )
+        htable.insert( i, i );
+    ASSERT_EQ( reserved, htable.bucket_count() );
+    ASSERT_LE( htable.load_factor(), htable.max_load_factor() );
+
+    // A lower max_load_factor() takes effect at once, and on every later insert.
+    htable.max_load_factor( 0.5f );
+    ASSERT_FLOAT_EQ( 0.5f, htable.max_load_factor() );
+    ASSERT_LE( htable.load_factor(), 0.5f );
+    for( int i = 5000 ; i < 8000 ; i++ )
+        htable.insert( i, i );
+    ASSERT_LE( htable.load_factor(), 0.5f );
+
+    // clear() keeps the buckets, shrink_to_fit() gives them back.
+    size_t full = htable.bucket_count();
+    htable.clear();
+    ASSERT_EQ( full, htable.bucket_count() );
+    htable.shrink_to_fit();
+    ASSERT_LT( htable.bucket_count(), 100u );
+    ASSERT_TRUE( htable.insert( 1, 1 ) );
+
+    // rehash(n) sets the size explicitly, but never below what size() needs.
+    for( int i = 0 ; i < 1000 ; i++ )
+        htable.insert( i, i );
+    htable.rehash( 10000 );
+    ASSERT_GE( htable.bucket_count(), 10000u );
+    htable.rehash( 1 );
+    ASSERT_LT( htable.bucket_count(), 10000u );
+    ASSERT_LE( htable.load_factor(), 0.5f );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+
+    // With a min_load_factor(), a mass erase shrinks the table.
+    htable.min_load_factor( 0.1f );
+    ASSERT_FLOAT_EQ( 0.1f, htable.min_load_factor() );
+    size_t before = htable.bucket_count();
+    for( int i = 0 ; i < 990 ; i++ )
+        ASSERT_TRUE( htable.erase( i ) );
+    ASSERT_LT( htable.bucket_count(), before );
+    ASSERT_GE( htable.load_factor(), 0.1f );
+    ASSERT_EQ( 10u, htable.size() );
+    for( int i = 990 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+
+    // The minimum is capped at a quarter of the maximum.
+    htable.min_load_factor( 0.9f );
+    ASSERT_FLOAT_EQ( 0.125f, htable.min_load_factor() );
+
+    // Copies keep the load factors.
+    auto copy = htable;
+    ASSERT_FLOAT_EQ( 0.5f, copy.max_load_factor() );
+    ASSERT_FLOAT_EQ( 0.125f, copy.min_load_factor() );
+}
+
+TEST_F(HTTest, Capacity)
+{
+    check_capacity<ac::chained_storage>();
+    check_capacity<ac::open_addressing>();
+    check_capacity<ac::swiss_table>();
+    check_capacity<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, ChainedGrowsAtMaxLoadFactor)
+{
+    // Growth used to test ( count / size ) >= 1.0 in integer arithmetic; a fractional maximum must be honored.
+    ac::HashTbl<int, int> htable( 101 );
+    htable.max_load_factor( 0.75f );
+    for( int i = 0 ; i < 75 ; i++ )
+        htable.insert( i, i );
+    ASSERT_EQ( 101u, htable.bucket_count() );
+    htable.insert( 75, 75 );
+    ASSERT_GT( htable.bucket_count(), 101u );
+}
+
+TEST_F(HTTest, OpenAddressingMaxLoadIsClamped)
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::open_addressing> flat;
+    flat.max_load_factor( 1.0f );
+    ASSERT_FLOAT_EQ( 0.875f, flat.max_load_factor() );
+
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, ac::swiss_table> swiss;
+    swiss.max_load_factor( 2.0f );
+    ASSERT_FLOAT_EQ( 0.875f, swiss.max_load_factor() );
+    for( int i = 0 ; i < 1000 ; i++ )
+        swiss.insert( i, i );
+    ASSERT_LE( swiss.load_factor(), 0.875f );
+}
+
+template < typename Storage >
+void check_max_load_clamp( float highest_ )
+{
+    for( float ml : { 0.01f, 0.0f, -1.0f, std::nanf( "" ) } )
+    {
+        ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> htable;
+        htable.max_load_factor( ml );
+        ASSERT_FLOAT_EQ( 0.0625f, htable.max_load_factor() );
+        for( int i = 0 ; i < 100 ; i++ )
+            htable.insert( i, i );
+        ASSERT_EQ( 100u, htable.size() );
+        ASSERT_LE( htable.load_factor(), 0.0625f );
+        int d = 0;
+        for( int i = 0 ; i < 100 ; i++ )
+        {
+            ASSERT_TRUE( htable.retrieve( i, d ) );
+            ASSERT_EQ( i, d );
+        }
+    }
+
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> htable;
+    htable.max_load_factor( 2.0f );
+    ASSERT_FLOAT_EQ( highest_, htable.max_load_factor() );
+}
+
+TEST_F(HTTest, MaxLoadFactorIsClamped)
+{
+    check_max_load_clamp<ac::chained_storage>( 2.0f );
+    check_max_load_clamp<ac::open_addressing>( 0.875f );
+    check_max_load_clamp<ac::swiss_table>( 0.875f );
+    check_max_load_clamp<ac::cuckoo_table>( 0.95f );
+}
+
+// ============================================================================
+// TESTING BULK BUILD
+// ============================================================================
+
+/// Wraps an iterator so it only offers single pass input iteration, like a stream.
+template < typename It >
+struct SinglePass
+{
+    using iterator_category = std::input_iterator_tag;
+    using value_type = typename std::iterator_traits< It >::value_type;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type*;
+    using reference = const value_type&;
+
+    It it;
+    reference operator*() const { return *it; }
+    SinglePass & operator++() { ++it; return *this; }
+    bool operator!=( const SinglePass & other ) const { return it != other.it; }
+    bool operator==( const SinglePass & other ) const { return it == other.it; }
+};
+
+template < typename Storage >
+void check_bulk_build( void )
+{
+    using Table = ac::HashTbl<int, std::string, CountingHash, std::equal_to<int>, Storage>;
+    std::vector< std::pair<int, std::string> > pairs;
+    for( int i = 0 ; i < 10000 ; i++ )
+        pairs.emplace_back( i, std::to_string( i ) );
+
+    // Counted ranges are placed without any rehash: each key is hashed exactly once.
+    CountingHash::calls = 0;
+    Table htable( pairs.begin(), pairs.end() );
+    ASSERT_EQ( pairs.size(), CountingHash::calls );
+    ASSERT_EQ( pairs.size(), htable.size() );
+    ASSERT_LE( htable.load_factor(), htable.max_load_factor() );
+    for( const auto & p : pairs )
+        ASSERT_EQ( p.second, htable.at( p.first ) );
+
+    // Same for insert( first, last ) on a table already holding entries.
+    std::map<int, std::string> more;
+    for( int i = 5000 ; i < 30000 ; i++ )
+        more[i] = "m";
+    htable.insert( more.begin(), more.end() );
+    ASSERT_EQ( 30000u, htable.size() );
+    ASSERT_EQ( "m", htable.at( 5000 ) );
+    ASSERT_EQ( "4999", htable.at( 4999 ) );
+    ASSERT_LE( htable.load_factor(), htable.max_load_factor() );
+
+    // Single pass ranges can't be counted, but still work.
+    Table streamed( SinglePass< decltype( pairs.begin() ) >{ pairs.begin() }, SinglePass< decltype( pairs.begin() ) >{ pairs.end() } );
+    ASSERT_EQ( pairs.size(), streamed.size() );
+    ASSERT_EQ( "9999", streamed.at( 9999 ) );
+
+    // Entries and tuples, moved when the iterators are move iterators; the last duplicate wins.
+    std::vector< typename Table::Entry > entries;
+    entries.emplace_back( 1, "one" );
+    entries.emplace_back( 2, "two" );
+    entries.emplace_back( 1, "uno" );
+    Table moved( std::make_move_iterator( entries.begin() ), std::make_move_iterator( entries.end() ) );
+    ASSERT_EQ( 2u, moved.size() );
+    ASSERT_EQ( "uno", moved.at( 1 ) );
+    ASSERT_TRUE( entries[1].m_data.empty() );
+
+    std::vector< std::tuple<int, std::string> > tuples { { 3, "three" }, { 4, "four" } };
+    moved.insert( tuples.begin(), tuples.end() );
+    moved.insert( { { 5, "five" } } );
+    ASSERT_EQ( 5u, moved.size() );
+    ASSERT_EQ( "three", moved.at( 3 ) );
+    ASSERT_EQ( "five", moved.at( 5 ) );
+
+    // Empty ranges build a usable table.
+    Table empty( pairs.end(), pairs.end() );
+    ASSERT_TRUE( empty.empty() );
+    empty[7] = "seven";
+    ASSERT_EQ( 1u, empty.size() );
+}
+
+TEST_F(HTTest, BulkBuild)
+{
+    check_bulk_build<ac::chained_storage>();
+    check_bulk_build<ac::open_addressing>();
+    check_bulk_build<ac::swiss_table>();
+    check_bulk_build<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, InitializerListIsSizedForItsEntries)
+{
+    ac::HashTbl<int, int> htable { {1, 1}, {2, 2}, {3, 3} };
+    ASSERT_EQ( 3u, htable.size() );
+    ASSERT_LE( htable.load_factor(), 1.0f );
+
+    htable = { {4, 4}, {5, 5} };
+    ASSERT_EQ( 2u, htable.size() );
+    ASSERT_TRUE( htable.find( 1 ) == htable.end() );
+    ASSERT_EQ( 5, htable.at( 5 ) );
+}
+
+template < typename Storage >
+void check_literal_insert( void )
+{
+    // Both literals decay to const char*, an iterator, but not over key/data pairs: the key and data overload is picked.
+    ac::HashTbl<std::string, std::string, std::hash<std::string>, std::equal_to<std::string>, Storage> htable;
+    ASSERT_TRUE( htable.insert( "alpha", "beta" ) );
+    ASSERT_FALSE( htable.insert( "alpha", "gamma" ) );
+    ASSERT_EQ( 1u, htable.size() );
+    ASSERT_EQ( "gamma", htable.at( "alpha" ) );
+}
+
+TEST_F(HTTest, InsertStringLiterals)
+{
+    check_literal_insert<ac::chained_storage>();
+    check_literal_insert<ac::open_addressing>();
+    check_literal_insert<ac::swiss_table>();
+    check_literal_insert<ac::cuckoo_table>();
+}
+
+// ============================================================================
+// TESTING PARALLEL REHASH
+// ============================================================================
+
+/// True when both tables hold the same entries, in the same iteration order.
+template < typename Table >
+bool same_layout( const Table & a_, const Table & b_ )
+{
+    return a_.bucket_count() == b_.bucket_count() and a_.size() == b_.size()
+        and std::equal( a_.begin(), a_.end(), b_.begin(), b_.end(), []( const auto & x_, const auto & y_ )
+                        { return x_.m_key == y_.m_key and x_.m_data == y_.m_data; } );
+}
+
+template < typename HashPolicy >
+void check_parallel_rehash( void )
+{
+    using Table = ac::HashTbl<std::string, int, std::hash<std::string>, std::equal_to<std::string>,
+                              ac::chained_storage, ac::prime_size, HashPolicy>;
+    Table serial, parallel;
+    parallel.parallel_rehash( 4 );
+
+    // Growing through several rehashes, the largest ones split between threads.
+    const int n = 100000;
+    for( int i = 0 ; i < n ; i++ )
+    {
+        serial.insert( std::to_string( ac::mix_hash( i ) ), i );
+        parallel.insert( std::to_string( ac::mix_hash( i ) ), i );
+    }
+    ASSERT_GT( parallel.bucket_count(), Table::PARALLEL_MIN );
+    ASSERT_TRUE( same_layout( serial, parallel ) );
+
+    serial.rehash( 3 * n );
+    parallel.rehash( 3 * n );
+    ASSERT_TRUE( same_layout( serial, parallel ) );
+
+    // Shrinking, and an odd thread count.
+    parallel.parallel_rehash( 3 );
+    serial.rehash( n );
+    parallel.rehash( n );
+    ASSERT_TRUE( same_layout( serial, parallel ) );
+    for( int i = 0 ; i < n ; i++ )
+        ASSERT_EQ( i, parallel.at( std::to_string( ac::mix_hash( i ) ) ) );
+
+    // A copy keeps the setting.
+    Table copy( parallel );
+    copy.rehash( 2 * n );
+    serial.rehash( 2 * n );
+    ASSERT_TRUE( same_layout( serial, copy ) );
+}
+
+TEST_F(HTTest, ParallelRehash)
+{
+    check_parallel_rehash<ac::recompute_hash>();
+    check_parallel_rehash<ac::cache_hash>();
+}
+
+TEST_F(HTTest, ParallelBulkBuild)
+{
+    using Table = ac::HashTbl<int, std::string>;
+
+    // Repeated keys keep their last data, as with the serial build.
+    std::vector< std::pair<int, std::string> > pairs;
+    for( int i = 0 ; i < 120000 ; i++ )
+        pairs.emplace_back( static_cast<int>( ac::mix_hash( i % 50000 ) ), std::to_string( i ) );
+
+    Table serial( pairs.begin(), pairs.end() );
+    for( size_t threads : { 2u, 3u, 8u } )
+    {
+        Table parallel( pairs.begin(), pairs.end(), threads );
+        ASSERT_EQ( 50000u, parallel.size() );
+        ASSERT_TRUE( same_layout( serial, parallel ) );
+    }
+
+    // Entries are moved out of an rvalue range.
+    auto moved = pairs;
+    Table parallel( std::make_move_iterator( moved.begin() ), std::make_move_iterator( moved.end() ), 4 );
+    ASSERT_TRUE( same_layout( serial, parallel ) );
+    ASSERT_TRUE( moved.back().second.empty() );
+
+    // Small and single pass ranges are built serially.
+    Table few( pairs.begin(), pairs.begin() + 100, 4 );
+    ASSERT_EQ( 100u, few.size() );
+    using It = std::vector< std::pair<int, std::string> >::iterator;
+    Table streamed( SinglePass<It>{ pairs.begin() }, SinglePass<It>{ pairs.end() }, 4 );
+    ASSERT_EQ( 50000u, streamed.size() );
+    ASSERT_EQ( serial.at( pairs[7].first ), streamed.at( pairs[7].first ) );
+}
+
+// ============================================================================
+// TESTING BATCHED LOOKUP
+// ============================================================================
+
+template < typename Storage >
+void check_retrieve_many( void )
+{
+    ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> htable;
+    std::vector<int> keys;
+    for( int i = 0 ; i < 1999 ; i++ )
+        keys.push_back( ( i * 7919 ) % 3000 );
+
+    // An empty table finds nothing and leaves the data alone.
+    std::vector<int> data( keys.size(), -1 );
+    std::unique_ptr<bool[]> found( new bool[ keys.size() ] );
+    ASSERT_EQ( 0u, htable.retrieve_many( keys.data(), keys.size(), data.data(), found.get() ) );
+    ASSERT_EQ( -1, data[0] );
+    ASSERT_FALSE( found[0] );
+
+    for( int i = 0 ; i < 1500 ; i++ )
+        htable.insert( i, i * 2 );
+
+    // Same answers as one retrieve() per key, for a key count that isn't a multiple of the batch.
+    size_t expected = 0;
+    size_t hits = htable.retrieve_many( keys.data(), keys.size(), data.data(), found.get() );
+    for( size_t i = 0 ; i < keys.size() ; i++ )
+    {
+        int d = -1;
+        bool hit = htable.retrieve( keys[i], d );
+        ASSERT_EQ( hit, found[i] );
+        if( hit )
+        {
+            ASSERT_EQ( d, data[i] );
+            expected++;
+        }
+    }
+    ASSERT_EQ( expected, hits );
+
+    // found_ is optional.
+    ASSERT_EQ( expected, htable.retrieve_many( keys.data(), keys.size(), data.data() ) );
+    ASSERT_EQ( 0u, htable.retrieve_many( keys.data(), 0, data.data() ) );
+
+    // Transparent keys are looked up without building a std::string.
+    ac::HashTbl<std::string, int, ac::string_hash, std::equal_to<>, Storage> words { { "alpha", 1 }, { "beta", 2 } };
+    std::string_view queries[] = { "beta", "gamma", "alpha" };
+    int values[3] = { 0, 0, 0 };
+    ASSERT_EQ( 2u, words.retrieve_many( queries, 3, values ) );
+    ASSERT_EQ( 2, values[0] );
+    ASSERT_EQ( 0, values[1] );
+    ASSERT_EQ( 1, values[2] );
+}
+
+TEST_F(HTTest, RetrieveMany)
+{
+    check_retrieve_many<ac::chained_storage>();
+    check_retrieve_many<ac::open_addressing>();
+    check_retrieve_many<ac::swiss_table>();
+    check_retrieve_many<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, RetrieveManyDuringIncrementalRehash)
+{
+    ac::HashTbl<int, int> htable;
+    htable.incremental_rehash( 1 );
+    std::vector<int> keys;
+    for( int i = 0 ; i < 500 ; i++ )
+    {
+        htable.insert( i, -i );
+        keys.push_back( i );
+    }
+    ASSERT_TRUE( htable.rehashing() );
+
+    std::vector<int> data( keys.size() );
+    ASSERT_EQ( keys.size(), htable.retrieve_many( keys.data(), keys.size(), data.data() ) );
+    for( size_t i = 0 ; i < keys.size() ; i++ )
+        ASSERT_EQ( -keys[i], data[i] );
+}
+
+// ============================================================================
+// TESTING CONCURRENT TABLE
+// ============================================================================
+
+template < typename Storage >
+void check_concurrent_table( void )
+{
+    ac::ConcurrentHashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage> htable( 8 );
+    const int threads = 4, per_thread = 5000;
+    ASSERT_EQ( 8u, htable.shard_count() );
+
+    // Writers on disjoint keys, while readers look them up.
+    std::vector<std::thread> workers;
+    for( int t = 0 ; t < threads ; t++ )
+    {
+        workers.emplace_back( [&htable, t, per_thread]{
+            for( int i = t * per_thread ; i < ( t + 1 ) * per_thread ; i++ )
+                htable.insert( i, i * 2 );
+        } );
+        workers.emplace_back( [&htable, threads, per_thread]{
+            int d = 0;
+            for( int i = 0 ; i < threads * per_thread ; i++ )
+            {
+                if( htable.retrieve( i, d ) )
+                {
+                    ASSERT_EQ( i * 2, d );
+                }
+            }
+        } );
+    }
+    for( auto & w : workers )
+        w.join();
+    workers.clear();
+
+    ASSERT_EQ( size_t( threads * per_thread ), htable.size() );
+    for( int i = 0 ; i < threads * per_thread ; i++ )
+    {
+        int d = -1;
+        ASSERT_TRUE( htable.retrieve( i, d ) );
+        ASSERT_EQ( i * 2, d );
+    }
+
+    // upsert() read-modify-writes are atomic: every increment is counted.
+    for( int t = 0 ; t < threads ; t++ )
+        workers.emplace_back( [&htable]{
+            for( int i = 0 ; i < 1000 ; i++ )
+                htable.upsert( -1 - i % 10, 1, []( int & d_ ) { d_++; } );
+        } );
+    for( auto & w : workers )
+        w.join();
+    workers.clear();
+
+    int total = 0;
+    htable.for_each( [&total]( const int & k_, int & d_ ) { if( k_ < 0 ) total += d_; } );
+    ASSERT_EQ( threads * 1000, total );
+
+    // Concurrent erasers each remove their own keys.
+    for( int t = 0 ; t < threads ; t++ )
+        workers.emplace_back( [&htable, t, per_thread]{
+            for( int i = t * per_thread ; i < ( t + 1 ) * per_thread ; i++ )
+                ASSERT_TRUE( htable.erase( i ) );
+        } );
+    for( auto & w : workers )
+        w.join();
+
+    ASSERT_EQ( 10u, htable.size() );
+    ASSERT_TRUE( htable.contains( -1 ) );
+    ASSERT_FALSE( htable.contains( 0 ) );
+    htable.clear();
+    ASSERT_TRUE( htable.empty() );
+}
+
+TEST_F(HTTest, ConcurrentTable)
+{
+    check_concurrent_table<ac::chained_storage>();
+    check_concurrent_table<ac::open_addressing>();
+    check_concurrent_table<ac::swiss_table>();
+    check_concurrent_table<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, ConcurrentTableShards)
+{
+    // Shard counts are rounded up to a power of two, and every shard grows on its own.
+    ac::ConcurrentHashTbl<std::string, int, ac::string_hash, std::equal_to<>> htable( 5 );
+    ASSERT_EQ( 8u, htable.shard_count() );
+
+    htable.reserve( 1000 );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_TRUE( htable.insert( std::to_string( i ), i ) );
+    ASSERT_FALSE( htable.insert( "7", 70 ) );
+
+    int d = 0;
+    ASSERT_TRUE( htable.retrieve( std::string_view( "7" ), d ) );
+    ASSERT_EQ( 70, d );
+    ASSERT_TRUE( htable.erase( std::string_view( "7" ) ) );
+    ASSERT_EQ( 999u, htable.size() );
+
+    // Entries are spread over all the shards.
+    std::map<int, int> seen;
+    const auto & chtable = htable;
+    chtable.for_each( [&seen]( const std::string &, const int & d_ ) { seen[ d_ ]++; } );
+    ASSERT_EQ( 999u, seen.size() );
+}
+
+template < typename Storage >
+void check_read_modify_write( void )
+{
+    ac::HashTbl<std::string, int, std::hash<std::string>, std::equal_to<std::string>, Storage> htable;
+
+    // upsert( k, fn ) starts new keys from 0, as ++htable[ k ] would.
+    ASSERT_TRUE( htable.upsert( "a", []( int & d_ ) { d_ += 5; } ) );
+    ASSERT_FALSE( htable.upsert( "a", []( int & d_ ) { d_ += 5; } ) );
+    ASSERT_EQ( 10, htable.at( "a" ) );
+
+    // upsert( k, d, fn ) only calls fn on existing keys.
+    ASSERT_TRUE( htable.upsert( "b", 7, []( int & d_ ) { d_ = -1; } ) );
+    ASSERT_EQ( 7, htable.at( "b" ) );
+    ASSERT_FALSE( htable.upsert( "b", 7, []( int & d_ ) { d_ *= 3; } ) );
+    ASSERT_EQ( 21, htable.at( "b" ) );
+
+    int calls = 0;
+    ASSERT_FALSE( htable.compute_if_present( "c", [&calls]( int & ) { calls++; } ) );
+    ASSERT_TRUE( htable.compute_if_absent( "c", [&calls]{ calls++; return 3; } ) );
+    ASSERT_FALSE( htable.compute_if_absent( "c", [&calls]{ calls++; return 4; } ) );
+    ASSERT_TRUE( htable.compute_if_present( "c", [&calls]( int & d_ ) { calls++; d_++; } ) );
+    ASSERT_EQ( 2, calls );
+    ASSERT_EQ( 4, htable.at( "c" ) );
+
+    // Data reached through upsert() stays valid while the table grows under it.
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_TRUE( htable.upsert( std::to_string( i ), [i]( int & d_ ) { d_ = i; } ) );
+    ASSERT_EQ( 1003u, htable.size() );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, htable.at( std::to_string( i ) ) );
+}
+
+TEST_F(HTTest, ReadModifyWrite)
+{
+    check_read_modify_write<ac::chained_storage>();
+    check_read_modify_write<ac::open_addressing>();
+    check_read_modify_write<ac::swiss_table>();
+    check_read_modify_write<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, ConcurrentCounters)
+{
+    // The word count pattern, ++word_map[w], from several threads without outside locking.
+    ac::ConcurrentHashTbl<std::string, size_t, ac::string_hash, std::equal_to<>> counts( 4 );
+    const int threads = 4, rounds = 2000, words = 50;
+    std::vector<std::thread> workers;
+    for( int t = 0 ; t < threads ; t++ )
+        workers.emplace_back( [&counts, t]{
+            for( int i = 0 ; i < rounds ; i++ )
+            {
+                std::string w = std::to_string( ( i + t ) % words );
+                if( t % 2 == 0 )
+                    counts.upsert( w, []( size_t & d_ ) { d_++; } );
+                else
+                    counts.fetch_add( w, 1 );
+            }
+        } );
+    for( auto & w : workers )
+        w.join();
+
+    ASSERT_EQ( size_t( words ), counts.size() );
+    size_t total = 0;
+    counts.for_each( [&total]( const std::string &, const size_t & d_ ) { total += d_; } );
+    ASSERT_EQ( size_t( threads * rounds ), total );
+
+    ASSERT_EQ( size_t( threads * rounds / words ), counts.fetch_add( "0", 10 ) );
+    ASSERT_EQ( 0u, counts.fetch_add( "new", 2 ) );
+    ASSERT_FALSE( counts.compute_if_absent( "new", []{ return size_t( 9 ); } ) );
+    ASSERT_TRUE( counts.compute_if_present( "new", []( size_t & d_ ) { d_ *= 2; } ) );
+    size_t d = 0;
+    ASSERT_TRUE( counts.retrieve( "new", d ) );
+    ASSERT_EQ( 4u, d );
+    ASSERT_FALSE( counts.compute_if_present( "none", []( size_t & d_ ) { d_ = 1; } ) );
+    ASSERT_TRUE( counts.compute_if_absent( "none", []{ return size_t( 9 ); } ) );
+    ASSERT_TRUE( counts.retrieve( "none", d ) );
+    ASSERT_EQ( 9u, d );
+}
+
+// ============================================================================
+// TESTING READ MOSTLY TABLE
+// ============================================================================
+
+TEST_F(HTTest, ReadMostlyTable)
+{
+    ac::ReadMostlyHashTbl<int, std::string> htable;
+    ASSERT_TRUE( htable.empty() );
+
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_TRUE( htable.insert( i, std::to_string( i ) ) );
+    ASSERT_FALSE( htable.insert( 7, "seven" ) );
+    ASSERT_EQ( 1000u, htable.size() );
+    ASSERT_GE( htable.bucket_count(), 1000u );
+
+    std::string d;
+    ASSERT_TRUE( htable.retrieve( 7, d ) );
+    ASSERT_EQ( "seven", d );
+    ASSERT_FALSE( htable.retrieve( 1000, d ) );
+
+    ASSERT_FALSE( htable.upsert( 8, "new", []( std::string & d_ ) { d_ += "!"; } ) );
+    ASSERT_TRUE( htable.upsert( 1000, "new", []( std::string & d_ ) { d_ += "!"; } ) );
+    ASSERT_TRUE( htable.retrieve( 8, d ) );
+    ASSERT_EQ( "8!", d );
+    ASSERT_TRUE( htable.retrieve( 1000, d ) );
+    ASSERT_EQ( "new", d );
+
+    ASSERT_TRUE( htable.erase( 1000 ) );
+    ASSERT_FALSE( htable.erase( 1000 ) );
+    ASSERT_FALSE( htable.contains( 1000 ) );
+
+    size_t visited = 0;
+    htable.for_each( [&visited]( const int &, const std::string & ) { visited++; } );
+    ASSERT_EQ( 1000u, visited );
+
+    htable.rehash( 5000 );
+    ASSERT_GE( htable.bucket_count(), 5000u );
+    ASSERT_TRUE( htable.contains( 999 ) );
+
+    htable.clear();
+    ASSERT_TRUE( htable.empty() );
+    ASSERT_FALSE( htable.contains( 1 ) );
+}
+
+TEST_F(HTTest, ReadMostlyTableReadersDuringWrites)
+{
+    ac::ReadMostlyHashTbl<int, int> htable;
+    const int stable = 1000;
+    for( int i = 0 ; i < stable ; i++ )
+        htable.insert( i, i );
+
+    // Readers never miss a stable key, whatever the writer does meanwhile, and always see a whole value.
+    std::atomic<bool> done { false };
+    std::atomic<long> misses { 0 }, torn { 0 };
+    std::vector<std::thread> readers;
+    for( int t = 0 ; t < 3 ; t++ )
+        readers.emplace_back( [&]{
+            int d = 0;
+            while( not done.load() )
+                for( int i = 0 ; i < stable ; i++ )
+                {
+                    if( not htable.retrieve( i, d ) )
+                        misses++;
+                    else if( d < i or ( d - i ) % 10 != 0 )
+                        torn++;
+                }
+        } );
+
+    for( int round = 0 ; round < 20 ; round++ )
+    {
+        for( int i = 0 ; i < stable ; i += 7 )
+            htable.upsert( i, i, []( int & d_ ) { d_ += 10; } );
+        for( int i = stable ; i < stable + 2000 ; i++ )
+            htable.insert( i, i );
+        for( int i = stable ; i < stable + 2000 ; i++ )
+            htable.erase( i );
+        htable.rehash( round % 2 == 0 ? 20000 : 0 );
+        std::this_thread::yield();
+    }
+    done = true;
+    for( auto & r : readers )
+        r.join();
+
+    ASSERT_EQ( 0, misses.load() );
+    ASSERT_EQ( 0, torn.load() );
+    ASSERT_EQ( size_t( stable ), htable.size() );
+    int d = 0;
+    ASSERT_TRUE( htable.retrieve( 0, d ) );
+    ASSERT_EQ( 200, d );
+}
+
+TEST_F(HTTest, ReadMostlyTableMoreReadersThanSlots)
+{
+    ac::ReadMostlyHashTbl<int, int> htable;
+    for( int i = 0 ; i < 10 ; i++ )
+        htable.insert( i, i );
+
+    // Each level of for_each() holds a reader, so the deepest levels find every slot taken and overflow.
+    int deepest = 0;
+    std::function<void( int )> nest = [&]( int depth_ ) {
+        if( depth_ == 100 )
+        {
+            int d = 0;
+            EXPECT_TRUE( htable.retrieve( 3, d ) );
+            htable.upsert( 3, 0, []( int & d_ ) { d_ += 100; } );
+            htable.erase( 4 );
+            deepest = depth_;
+            return;
+        }
+        bool first = true;
+        htable.for_each( [&]( const int & k_, const int & d_ ) {
+            EXPECT_TRUE( k_ == d_ or k_ + 100 == d_ );
+            if( first )
+                nest( depth_ + 1 );
+            first = false;
+        } );
+    };
+    nest( 0 );
+
+    ASSERT_EQ( 100, deepest );
+    int d = 0;
+    ASSERT_TRUE( htable.retrieve( 3, d ) );
+    ASSERT_EQ( 103, d );
+    ASSERT_FALSE( htable.contains( 4 ) );
+    htable.insert( 20, 20 );
+    ASSERT_EQ( 10u, htable.size() );
+}
+
+// ============================================================================
+// TESTING SNAPSHOT
+// ============================================================================
+
+template < typename Storage >
+void check_snapshot( void )
+{
+    const std::string path = ::testing::TempDir() + "hashtbl_snapshot.bin";
+    ac::HashTbl<int, double, std::hash<int>, std::equal_to<int>, Storage> htable;
+    for( int i = 0 ; i < 5000 ; i++ )
+        htable.insert( i * 7, i / 2.0 );
+
+    ac::save_snapshot( htable, path );
+    ac::MappedHashTbl<int, double> mapped( path );
+    ASSERT_EQ( htable.size(), mapped.size() );
+    for( int i = 0 ; i < 5000 ; i++ )
+    {
+        double d = -1;
+        ASSERT_TRUE( mapped.retrieve( i * 7, d ) );
+        ASSERT_EQ( i / 2.0, d );
+        ASSERT_FALSE( mapped.contains( i * 7 + 1 ) );
+    }
+
+    size_t seen = 0;
+    mapped.for_each( [&]( const int & k_, const double & d_ ) { ASSERT_EQ( htable.at( k_ ), d_ ); seen++; } );
+    ASSERT_EQ( htable.size(), seen );
+    std::remove( path.c_str() );
+}
+
+TEST_F(HTTest, Snapshot)
+{
+    check_snapshot<ac::chained_storage>();
+    check_snapshot<ac::open_addressing>();
+    check_snapshot<ac::swiss_table>();
+    check_snapshot<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, SnapshotStringKeys)
+{
+    // Account keys hold a string, stored in the arena and compared there.
+    const std::string path = ::testing::TempDir() + "hashtbl_accounts.bin";
+    ac::HashTbl< Account::AcctKey, std::pair<float, int>, KeyHash, KeyEqual > balances;
+    for( int i = 0 ; i < 1000 ; i++ )
+        balances.insert( std::make_tuple( "Owner " + std::to_string( i ), 1, i % 7, i ), { i * 1.5f, i } );
+
+    ac::save_snapshot( balances, path );
+    auto mapped = ac::MappedHashTbl< Account::AcctKey, std::pair<float, int>, KeyHash >( path );
+    ASSERT_EQ( 1000u, mapped.size() );
+
+    std::pair<float, int> d;
+    ASSERT_TRUE( mapped.retrieve( std::make_tuple( std::string( "Owner 42" ), 1, 0, 42 ), d ) );
+    ASSERT_EQ( 42 * 1.5f, d.first );
+    ASSERT_EQ( 42, d.second );
+    // Same account number, other owner: the whole key is compared.
+    ASSERT_FALSE( mapped.contains( std::make_tuple( std::string( "Owner 43" ), 1, 0, 42 ) ) );
+
+    // An empty table makes a valid snapshot too.
+    ac::save_snapshot( ac::HashTbl< Account::AcctKey, std::pair<float, int>, KeyHash, KeyEqual >(), path );
+    ac::MappedHashTbl< Account::AcctKey, std::pair<float, int>, KeyHash > none( path );
+    ASSERT_TRUE( none.empty() );
+    ASSERT_FALSE( none.contains( std::make_tuple( std::string( "Owner 42" ), 1, 0, 42 ) ) );
+    std::remove( path.c_str() );
+}
+
+/// Hashes ints differently from std::hash, like a snapshot reader built with another KeyHash.
+struct SaltedIntHash
+{
+    size_t operator()( int k_ ) const { return std::hash<int>()( k_ ) ^ 0x5bd1e995; }
+};
+
+TEST_F(HTTest, SnapshotRejectsBadFiles)
+{
+    const std::string path = ::testing::TempDir() + "hashtbl_bad.bin";
+    ac::HashTbl<int, int> htable{ { 1, 10 }, { 2, 20 } };
+    ac::save_snapshot( htable, path );
+
+    // Other data type, missing file, other KeyHash, then a corrupted version number and a truncated file.
+    ASSERT_THROW( ( ac::MappedHashTbl<int, double>( path ) ), std::runtime_error );
+    ASSERT_THROW( ( ac::MappedHashTbl<int, int>( path + ".none" ) ), std::runtime_error );
+    // Same types, other KeyHash: lookups would miss, so the file is rejected.
+    ASSERT_THROW( ( ac::MappedHashTbl<int, int, SaltedIntHash>( path ) ), std::runtime_error );
+
+    std::string bytes;
+    {
+        std::ifstream in( path, std::ios::binary );
+        bytes.assign( std::istreambuf_iterator<char>( in ), std::istreambuf_iterator<char>() );
+    }
+    std::string bad = bytes;
+    bad[8] = 99;
+    std::ofstream( path, std::ios::binary ).write( bad.data(), bad.size() );
+    ASSERT_THROW( ( ac::MappedHashTbl<int, int>( path ) ), std::runtime_error );
+    std::ofstream( path, std::ios::binary ).write( bytes.data(), bytes.size() - 4 );
+    ASSERT_THROW( ( ac::MappedHashTbl<int, int>( path ) ), std::runtime_error );
+
+    std::ofstream( path, std::ios::binary ).write( bytes.data(), bytes.size() );
+    ac::MappedHashTbl<int, int> mapped( path );
+    int d = 0;
+    ASSERT_TRUE( mapped.retrieve( 2, d ) );
+    ASSERT_EQ( 20, d );
+    std::remove( path.c_str() );
+}
+
+// ============================================================================
+// TESTING SAVE AND LOAD
+// ============================================================================
+
+namespace ac
+{
+    /// Accounts hold a string, so they are written member by member.
+    template < >
+    struct serializer< Account >
+    {
+        static void write( stream_writer & out_, const Account & a_ )
+        {
+            out_.value( a_.name );
+            out_.value( a_.bank );
+            out_.value( a_.agency );
+            out_.value( a_.account_num );
+            out_.value( a_.m_balance );
+        }
+
+        static void read( stream_reader & in_, Account & a_ )
+        {
+            in_.value( a_.name );
+            in_.value( a_.bank );
+            in_.value( a_.agency );
+            in_.value( a_.account_num );
+            in_.value( a_.m_balance );
+        }
+    };
+}
+
+template < typename Storage >
+void check_save_load( void )
+{
+    using Table = ac::HashTbl<int, std::string, CountingHash, std::equal_to<int>, Storage>;
+    Table saved;
+    for( int i = 0 ; i < 20000 ; i++ )
+        saved.insert( i * 3, std::to_string( i ) );
+
+    std::stringstream stream;
+    ac::save( saved, stream );
+
+    // The restored table is sized once from the header: every key is hashed exactly once.
+    Table restored;
+    restored.insert( -1, "gone" );
+    CountingHash::calls = 0;
+    ac::load( restored, stream );
+    ASSERT_EQ( saved.size(), CountingHash::calls );
+    ASSERT_EQ( saved.size(), restored.size() );
+    ASSERT_TRUE( restored.find( -1 ) == restored.end() );
+    for( const auto & e : saved )
+        ASSERT_EQ( e.m_data, restored.at( e.m_key ) );
+}
+
+TEST_F(HTTest, SaveLoad)
+{
+    check_save_load<ac::chained_storage>();
+    check_save_load<ac::open_addressing>();
+    check_save_load<ac::swiss_table>();
+    check_save_load<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, SaveLoadAccounts)
+{
+    using Table = ac::HashTbl< Account::AcctKey, Account, KeyHash, KeyEqual >;
+    Table accounts;
+    for( int i = 0 ; i < 100 ; i++ )
+    {
+        Account a{ "Owner " + std::to_string( i ), 1, i % 3, i, i * 2.5f };
+        accounts.insert( a.get_key(), a );
+    }
+    accounts.max_load_factor( 0.5f );
+
+    std::stringstream stream;
+    ac::save( accounts, stream );
+    Table restored;
+    ac::load( restored, stream );
+    ASSERT_EQ( 100u, restored.size() );
+    ASSERT_EQ( 0.5f, restored.max_load_factor() );
+    for( const auto & e : accounts )
+        ASSERT_EQ( e.m_data, restored.at( e.m_key ) );
+}
+
+TEST_F(HTTest, LoadRejectsBadStreams)
+{
+    ac::HashTbl<int, std::string> htable;
+    for( int i = 0 ; i < 100 ; i++ )
+        htable.insert( i, std::to_string( i ) );
+    std::stringstream stream;
+    ac::save( htable, stream );
+    const std::string bytes = stream.str();
+
+    // A flipped bit in an entry fails the final checksum, and leaves the table empty.
+    std::string bad = bytes;
+    bad[ bytes.size() / 2 ] ^= 1;
+    std::stringstream corrupted( bad );
+    ac::HashTbl<int, std::string> restored{ { 1, "one" } };
+    ASSERT_THROW( ac::load( restored, corrupted ), std::runtime_error );
+    ASSERT_TRUE( restored.empty() );
+
+    // So does a truncated stream.
+    std::stringstream truncated( bytes.substr( 0, bytes.size() - 20 ) );
+    ASSERT_THROW( ac::load( restored, truncated ), std::runtime_error );
+
+    // A rejected header leaves the table as it was: damaged, so its checksum fails, or well formed but of another version.
+    restored.insert( 1, "one" );
+    bad = bytes;
+    bad[16] ^= 1;
+    std::stringstream header( bad );
+    ASSERT_THROW( ac::load( restored, header ), std::runtime_error );
+    ASSERT_EQ( 1u, restored.size() );
+
+    ac::StreamHeader future{};
+    std::memcpy( future.magic, ac::STREAM_MAGIC, sizeof( future.magic ) );
+    future.version = ac::STREAM_VERSION + 1;
+    future.byte_order = ac::STREAM_BYTE_ORDER;
+    std::stringstream incompatible;
+    ac::stream_writer out( incompatible );
+    out.bytes( &future, sizeof( future ) );
+    out.seal();
+    ASSERT_THROW( ac::load( restored, incompatible ), std::runtime_error );
+    ASSERT_EQ( 1u, restored.size() );
+    ASSERT_EQ( "one", restored.at( 1 ) );
+
+    std::stringstream good( bytes );
+    ac::load( restored, good );
+    ASSERT_EQ( 100u, restored.size() );
+}
+
+// ============================================================================
+// TESTING STATS
+// ============================================================================
+
+template < typename Storage >
+void check_stats( void )
+{
+    using Table = ac::HashTbl<int, int, std::hash<int>, std::equal_to<int>, Storage, ac::prime_size, ac::recompute_hash,
+                              std::allocator< ac::HashEntry<int, int> >, ac::collect_stats>;
+    Table htable;
+    for( int i = 0 ; i < 5000 ; i++ )
+        htable.insert( i, i );
+
+    ac::HashStats s = htable.stats();
+    ASSERT_EQ( 5000u, s.size );
+    ASSERT_EQ( htable.bucket_count(), s.bucket_count );
+    ASSERT_GE( s.rehashes, 1u );
+    ASSERT_FALSE( s.histogram.empty() );
+    ASSERT_EQ( s.longest + 1, s.histogram.size() );
+    ASSERT_GT( s.histogram.back(), 0u );
+    ASSERT_GT( s.empty_ratio, 0.0 );
+    ASSERT_LT( s.empty_ratio, 1.0 );
+    ASSERT_GE( s.bytes, s.bucket_count * sizeof( int ) );
+
+    // Chained tables count buckets by chain length, flat ones count entries by probe distance.
+    size_t buckets = 0, entries = 0;
+    for( size_t n = 0 ; n < s.histogram.size() ; n++ )
+    {
+        buckets += s.histogram[n];
+        entries += n * s.histogram[n];
+    }
+    if constexpr ( std::is_same< Storage, ac::chained_storage >::value )
+    {
+        ASSERT_EQ( s.bucket_count, buckets );
+        ASSERT_EQ( 5000u, entries );
+    }
+    else
+        ASSERT_EQ( 5000u, buckets );
+
+    // Every lookup is counted, whichever way it is made.
+    int d = 0;
+    for( int i = 0 ; i < 100 ; i++ )
+        ASSERT_TRUE( htable.retrieve( i, d ) );
+    for( int i = 1 ; i <= 50 ; i++ )
+        ASSERT_FALSE( htable.retrieve( -i, d ) );
+    ASSERT_EQ( 7, htable.at( 7 ) );
+    ASSERT_THROW( htable.at( -1 ), std::out_of_range );
+    int keys[] = { 1, -1, 2, -2, 3, -3, 4, -4, 5, -5 };
+    int data[10];
+    ASSERT_EQ( 5u, htable.retrieve_many( keys, 10, data ) );
+
+    s = htable.stats();
+    ASSERT_EQ( 106u, s.hits );
+    ASSERT_EQ( 56u, s.misses );
+
+    // Counters belong to a table object: a copy starts from zero, and reset_stats() zeroes them.
+    Table copy( htable );
+    ASSERT_EQ( 0u, copy.stats().hits );
+    htable.reset_stats();
+    s = htable.stats();
+    ASSERT_EQ( 0u, s.hits );
+    ASSERT_EQ( 0u, s.misses );
+    ASSERT_EQ( 0u, s.rehashes );
+    ASSERT_EQ( 0u, s.rehash_ns );
+    ASSERT_EQ( 5000u, s.size );
+
+    htable.rehash( 20000 );
+    ASSERT_EQ( 1u, htable.stats().rehashes );
+}
+
+TEST_F(HTTest, Stats)
+{
+    check_stats<ac::chained_storage>();
+    check_stats<ac::open_addressing>();
+    check_stats<ac::swiss_table>();
+    check_stats<ac::cuckoo_table>();
+}
+
+TEST_F(HTTest, StatsCountersAreOptIn)
+{
+    // Without collect_stats the counters take no room and stay at zero, the shape is still measured.
+    static_assert( std::is_empty< ac::stats_counters< ac::no_stats > >::value, "no_stats must add nothing to a table" );
+    ac::HashTbl<int, int> htable;
+    int d = 0;
+    for( int i = 0 ; i < 100 ; i++ )
+        htable.insert( i, i );
+    htable.retrieve( 1, d );
+    htable.retrieve( -1, d );
+
+    ac::HashStats s = htable.stats();
+    ASSERT_EQ( 100u, s.size );
+    ASSERT_EQ( 0u, s.hits );
+    ASSERT_EQ( 0u, s.misses );
+    ASSERT_EQ( 0u, s.rehashes );
+}
+
+/// Hashes an account key by its account number only, as KeyHash used to.
+struct AcctNumHash
+{
+    size_t operator()( const Account::AcctKey & k_ ) const
+    { return static_cast<size_t>( std::get<3>( k_ ) ); }
+};
+
+TEST_F(HTTest, StatsRevealWeakHash)
+{
+    // Hashing the account number only piles up the accounts that share one in one chain.
+    std::vector<Account::AcctKey> keys;
+    for( int owner = 0 ; owner < 200 ; owner++ )
+        for( int num = 0 ; num < 10 ; num++ )
+            keys.emplace_back( "Owner " + std::to_string( owner ), 1, owner % 7, num );
+
+    ac::HashTbl<Account::AcctKey, int, AcctNumHash, KeyEqual> weak;
+    ac::HashTbl<Account::AcctKey, int, KeyHash, KeyEqual> full;
+    for( const auto & k : keys )
+    {
+        weak.insert( k, 0 );
+        full.insert( k, 0 );
+    }
+
+    ac::HashStats bad = weak.stats(), good = full.stats();
+    ASSERT_EQ( 200u, bad.longest );
+    ASSERT_GT( bad.empty_ratio, 0.99 );
+    ASSERT_LT( good.longest, 10u );
+    ASSERT_LT( good.empty_ratio, 0.7 );
+
+    ac::ConcurrentHashTbl<Account::AcctKey, int, KeyHash, KeyEqual> shared;
+    for( const auto & k : keys )
+        shared.insert( k, 0 );
+    ASSERT_EQ( keys.size(), shared.stats().size );
+}
+
+// ============================================================================
+// TESTING COMPOSITE KEY HASHING
+// ============================================================================
+
+TEST_F(HTTest, AccountsSharingANumber)
+{
+    // Same account number at two banks, and at two agencies of one bank: three accounts, not one.
+    Account a{ "Ana", 1, 10, 777, 1.0f }, b{ "Ana", 2, 10, 777, 2.0f }, c{ "Bia", 1, 11, 777, 3.0f };
+    ac::HashTbl< Account::AcctKey, Account, KeyHash, KeyEqual > accounts;
+    ASSERT_TRUE( accounts.insert( a.get_key(), a ) );
+    ASSERT_TRUE( accounts.insert( b.get_key(), b ) );
+    ASSERT_TRUE( accounts.insert( c.get_key(), c ) );
+    ASSERT_EQ( 3u, accounts.size() );
+    ASSERT_EQ( b, accounts.at( b.get_key() ) );
+    ASSERT_FALSE( KeyEqual()( a.get_key(), b.get_key() ) );
+    ASSERT_NE( KeyHash()( a.get_key() ), KeyHash()( b.get_key() ) );
+}
+
+TEST_F(HTTest, CompositeHashMembers)
+{
+    ac::composite_hash h;
+
+    // Order and member boundaries matter.
+    ASSERT_NE( h( std::make_tuple( 1, 2 ) ), h( std::make_tuple( 2, 1 ) ) );
+    ASSERT_NE( h( std::make_pair( std::string( "a" ), std::string( "bc" ) ) ), h( std::make_pair( std::string( "ab" ), std::string( "c" ) ) ) );
+    ASSERT_NE( h( std::make_tuple( 0, 0 ) ), h( std::make_tuple( 0 ) ) );
+
+    // Strings hash alike whatever holds them, and hash_members() is the hash of the members' std::tie().
+    std::string name = "Holder 42";
+    std::string_view view = name;
+    ASSERT_EQ( h( name ), h( view ) );
+    ASSERT_EQ( h( std::make_tuple( name, 7 ) ), h( std::make_tuple( view, 7 ) ) );
+    ASSERT_EQ( h( std::tie( name, view ) ), ac::hash_members( name, view ) );
+    ASSERT_EQ( h( std::make_tuple( 1.5, 'x' ) ), ac::hash_members( 1.5, 'x' ) );
+}
+
+TEST_F(HTTest, HashBytesUsesEveryByte)
+{
+    // Every length up to a few blocks, covering each branch: flipping any byte changes the hash.
+    std::string bytes( 100, 'k' );
+    std::set<uint64_t> seen;
+    for( size_t n = 0 ; n <= bytes.size() ; n++ )
+    {
+        uint64_t base = ac::hash_bytes( bytes.data(), n );
+        ASSERT_TRUE( seen.insert( base ).second );
+        for( size_t i = 0 ; i < n ; i++ )
+        {
+            std::string flipped = bytes.substr( 0, n );
+            flipped[i] ^= 1;
+            ASSERT_NE( base, ac::hash_bytes( flipped.data(), n ) );
+        }
+    }
+    ASSERT_NE( ac::hash_bytes( "abc", 3, 1 ), ac::hash_bytes( "abc", 3, 2 ) );
+}
+
+TEST_F(HTTest, CompositeHashSpreadsLowBits)
+{
+    // Sequential keys, bucketed by the low bits alone with no mixing, still fill the buckets evenly.
+    const size_t buckets = 256, keys = 256 * 64;
+    std::vector<size_t> ints( buckets ), accounts( buckets );
+    for( size_t i = 0 ; i < keys ; i++ )
+    {
+        int id = static_cast<int>( i );
+        ints[ ac::composite_hash()( std::make_tuple( id / 64, id % 64 ) ) % buckets ]++;
+        accounts[ KeyHash()( std::make_tuple( "Holder " + std::to_string( id % 100 ), 1, id % 7, id / 100 ) ) % buckets ]++;
+    }
+    ASSERT_LT( *std::max_element( ints.begin(), ints.end() ), 64u * 2 );
+    ASSERT_GT( *std::min_element( ints.begin(), ints.end() ), 64u / 2 );
+    ASSERT_LT( *std::max_element( accounts.begin(), accounts.end() ), 64u * 2 );
+    ASSERT_GT( *std::min_element( accounts.begin(), accounts.end() ), 64u / 2 );
+}
+
+// ============================================================================
+// TESTING TREEIFIED BUCKETS
+// ============================================================================
+
+/// Sends every key to the same bucket, the worst hash there is.
+struct ConstantHash
+{
+    size_t operator()( int ) const
+    { return 42; }
+};
+
+TEST_F(HTTest, TreeifiedBuckets)
+{
+    ac::HashTbl<int, int, ConstantHash, CountingEqual> htable;
+    htable.treeify_buckets( 8 );
+    for( int i = 0 ; i < 1000 ; i++ )
+        ASSERT_TRUE( htable.insert( i * 2, i ) );
+    ASSERT_FALSE( htable.insert( 10, -5 ) );
+    ASSERT_EQ( 1000u, htable.size() );
+
+    ac::HashStats s = htable.stats();
+    ASSERT_EQ( 1u, s.treeified );
+    ASSERT_EQ( 1000u, s.longest );
+
+    // One bucket of a thousand entries, yet each lookup compares a single key for equality.
+    int d = 0;
+    CountingEqual::calls = 0;
+    for( int i = 0 ; i < 1000 ; i++ )
+    {
+        ASSERT_TRUE( htable.retrieve( i * 2, d ) );
+        ASSERT_EQ( i == 5 ? -5 : i, d );
+        ASSERT_FALSE( htable.retrieve( i * 2 + 1, d ) );
+    }
+    ASSERT_LE( CountingEqual::calls, 2000u );
+    ASSERT_EQ( 7, htable.find( 14 )->m_data );
+    ASSERT_TRUE( htable.find( 15 ) == htable.end() );
+
+    // Erasing goes through the index too, which is dropped once the chain is down to half the threshold.
+    for( int i = 0 ; i < 996 ; i++ )
+        ASSERT_TRUE( htable.erase( i * 2 ) );
+    ASSERT_FALSE( htable.erase( 0 ) );
+    ASSERT_EQ( 4u, htable.size() );
+    ASSERT_EQ( 0u, htable.stats().treeified );
+    for( int i = 996 ; i < 1000 ; i++ )
+        ASSERT_EQ( i, htable.at( i * 2 ) );
+
+    // Growing the chain again indexes it again.
+    for( int i = 0 ; i < 10 ; i++ )
+        htable[ -i - 1 ] = i;
+    ASSERT_EQ( 1u, htable.stats().treeified );
+    ASSERT_EQ( 9, htable.at( -10 ) );
+}
+
+TEST_F(HTTest, TreeifiedBucketsAcrossRehashes)
+{
+    using Table = ac::HashTbl<int, int, ConstantHash, CountingEqual>;
+    Table htable;
+    for( int i = 0 ; i < 500 ; i++ )
+        htable.insert( i, i );
+
+    // Indexing an existing table, then copies, moves and every kind of rehash keep the index.
+    htable.treeify_buckets( 8 );
+    ASSERT_EQ( 1u, htable.stats().treeified );
+    htable.rehash( 4000 );
+    ASSERT_EQ( 1u, htable.stats().treeified );
+
+    Table copy( htable );
+    ASSERT_EQ( 1u, copy.stats().treeified );
+    Table moved( std::move( copy ) );
+    ASSERT_EQ( 1u, moved.stats().treeified );
+
+    // While an incremental rehash runs, buckets are scanned; they are indexed again once it is done.
+    htable.incremental_rehash( 1 );
+    htable.rehash( 8000 );
+    ASSERT_TRUE( htable.rehashing() );
+    ASSERT_EQ( 0u, htable.stats().treeified );
+    int d = 0;
+    for( int i = 0 ; i < 500 ; i++ )
+    {
+        ASSERT_TRUE( moved.retrieve( i, d ) );
+        ASSERT_TRUE( htable.retrieve( i, d ) );
+        ASSERT_EQ( i, d );
+    }
+    for( int i = 500 ; i < 600 && htable.rehashing() ; i++ )
+        htable.insert( i, i );
+    while( htable.rehashing() )
+        htable.erase( -1 );
+    ASSERT_EQ( 1u, htable.stats().treeified );
+    for( int i = 0 ; i < 500 ; i++ )
+        ASSERT_EQ( i, htable.at( i ) );
+
+    htable.clear();
+    ASSERT_EQ( 0u, htable.stats().treeified );
+    htable.treeify_buckets( 0 );
+    for( int i = 0 ; i < 100 ; i++ )
+        htable.insert( i, i );
+    ASSERT_EQ( 0u, htable.stats().treeified );
+}
+
+TEST_F(HTTest, TreeifiedAccountBuckets)
+{
+    // Accounts hashed by their number alone, many sharing one: each shared number becomes one indexed bucket.
+    ac::HashTbl<Account::AcctKey, int, AcctNumHash, KeyEqual> accounts;
+    accounts.treeify_buckets( 8 );
+    for( int owner = 0 ; owner < 100 ; owner++ )
+        for( int num = 0 ; num < 5 ; num++ )
+            accounts.insert( std::make_tuple( "Owner " + std::to_string( owner ), 1 + owner % 3, owner, num ), owner );
+
+    ASSERT_EQ( 500u, accounts.size() );
+    ASSERT_EQ( 5u, accounts.stats().treeified );
+    for( int owner = 0 ; owner < 100 ; owner++ )
+        ASSERT_EQ( owner, accounts.at( std::make_tuple( "Owner " + std::to_string( owner ), 1 + owner % 3, owner, 3 ) ) );
+    ASSERT_TRUE( accounts.find( std::make_tuple( std::string( "Owner 1" ), 1, 1, 3 ) ) == accounts.end() );
+}
+
+/// A key type that can look up int keys, but can't be ordered against them.
+struct Id
+{
+    int value;
+};
+
+struct ConstantIdHash
+{
+    using is_transparent = void;
+    size_t operator()( int ) const { return 42; }
+    size_t operator()( Id ) const { return 42; }
+};
+
+struct IdEqual
+{
+    using is_transparent = void;
+    bool operator()( int lhs, int rhs ) const { return lhs == rhs; }
+    bool operator()( int lhs, Id rhs ) const { return lhs == rhs.value; }
+};
+
+TEST_F(HTTest, TreeifiedBucketsEraseUnorderedKey)
+{
+    // An Id can't use the index to find its entry, but erasing it must still drop the entry from the index.
+    ac::HashTbl<int, int, ConstantIdHash, IdEqual> htable;
+    htable.treeify_buckets( 4 );
+    for( int i = 0 ; i < 20 ; i++ )
+        ASSERT_TRUE( htable.insert( i, -i ) );
+    ASSERT_EQ( 1u, htable.stats().treeified );
+
+    ASSERT_TRUE( htable.erase( Id{ 5 } ) );
+    ASSERT_FALSE( htable.erase( Id{ 5 } ) );
+    int d = 0;
+    ASSERT_FALSE( htable.retrieve( 5, d ) );
+    for( int i = 0 ; i < 20 ; i++ )
+        if( i != 5 )
+        {
+            ASSERT_EQ( -i, htable.at( i ) );
+        }
+
+    // Down to half the threshold the index goes away.
+    for( int i = 0 ; i < 18 ; i++ )
+        if( i != 5 )
+        {
+            ASSERT_TRUE( htable.erase( Id{ i } ) );
+        }
+    ASSERT_EQ( 0u, htable.stats().treeified );
+    ASSERT_EQ( 18, -htable.at( 18 ) );
+    ASSERT_EQ( 19, -htable.at( Id{ 19 } ) );
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);